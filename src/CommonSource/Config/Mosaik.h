@@ -66,6 +66,17 @@ const char OS_DIRECTORY_SEPARATOR = '/';
 
 #define DIRECTORY_NAME_LENGTH    255
 
+// =====================================
+// Platform specific memory prefetching
+// =====================================
+
+#ifdef WIN32
+#include <xmmintrin.h>
+#define PREFETCH_READ(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define PREFETCH_READ(p) __builtin_prefetch((p), 0, 3)
+#endif
+
 // ====================================
 // Enable unit test diagnostic messages
 // ====================================
@@ -17,13 +17,232 @@ const uint64_t CAbstractDnaHash::DNA_HASH_EMPTY_KEY = -1;
 const unsigned int CAbstractDnaHash::LargestResizeableSize = 1 << 31;
 
 // register our thread mutexes
-pthread_mutex_t CAbstractDnaHash::mJumpCacheMutex;
 pthread_mutex_t CAbstractDnaHash::mJumpKeyMutex;
 pthread_mutex_t CAbstractDnaHash::mJumpPositionMutex;
 
 CAbstractDnaHash::CAbstractDnaHash() 
-: mHashes(NULL)
+: mSnapshotBuffer(NULL)
+, mSnapshotBufferLen(0)
+, mHashes(NULL)
 , mMemoryAllocated(false)
+, mBuildPartitionShift(0)
+, mBuildPartitionMask(0)
 {}
 
 CAbstractDnaHash::~CAbstractDnaHash() {}
+
+// finishes a pass over the reference sequence, returns false if another pass is needed
+bool CAbstractDnaHash::FinishBuildPass(void) {
+	return true;
+}
+
+// finishes the current pass for one build partition (called by the thread that owns it)
+void CAbstractDnaHash::FinishBuildPartition(const unsigned int partition) {}
+
+// returns the number of build partitions: keys in different partitions can be added concurrently
+unsigned int CAbstractDnaHash::GetNumBuildPartitions(void) const {
+	return 1;
+}
+
+// retrieves the genome locations of all of the fragments (in order of the lookups)
+void CAbstractDnaHash::GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt) {
+	for(vector<HashLookup>::iterator lIter = lookups.begin(); lIter != lookups.end(); ++lIter)
+		Get(lIter->Key, lIter->QueryPosition, hrt, lIter->MhpOccupancy);
+}
+
+// retrieves the genome locations of both strands with one canonical lookup per fragment
+void CAbstractDnaHash::GetCanonicalBatch(vector<HashLookup>& lookups, CHashRegionTree& forwardHrt, CHashRegionTree& reverseHrt) {
+	cout << "ERROR: This hash table does not store canonical keys." << endl;
+	exit(1);
+}
+
+// returns true if the hash table stores canonical keys (both strands are retrieved by GetCanonicalBatch)
+bool CAbstractDnaHash::IsCanonical(void) const {
+	return false;
+}
+
+// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+bool CAbstractDnaHash::AttachSnapshotSections(const vector<HashSnapshotSection>& sections) {
+	return false;
+}
+
+// retrieves the hash table arrays that are stored in a snapshot, returns false if snapshots are not supported
+bool CAbstractDnaHash::GetSnapshotSections(vector<HashSnapshotSection>& sections) {
+	return false;
+}
+
+// memory maps a hash table snapshot built with the same identity, returns false if the snapshot does not exist
+bool CAbstractDnaHash::LoadSnapshot(const string& filename, const HashSnapshotIdentity& identity) {
+
+	FILE* in = fopen(filename.c_str(), "rb");
+	if(!in) return false;
+
+	// retrieve the file size
+	fseek64(in, 0, SEEK_END);
+	const uint64_t fileSize = ftell64(in);
+	fseek64(in, 0, SEEK_SET);
+
+	// read and validate the header
+	HashSnapshotHeader header;
+	if((fileSize < sizeof(HashSnapshotHeader)) || (fread((char*)&header, sizeof(HashSnapshotHeader), 1, in) != 1) ||
+		(memcmp(header.Signature, HASH_SNAPSHOT_SIGNATURE, HASH_SNAPSHOT_SIGNATURE_LEN) != 0)) {
+		cout << "ERROR: " << filename << " is not a hash table snapshot." << endl;
+		exit(1);
+	}
+
+	if(header.Version != HASH_SNAPSHOT_VERSION) {
+		cout << "ERROR: The hash table snapshot (" << filename << ") uses file format version " << header.Version << ", but this version of MOSAIK expects version " << HASH_SNAPSHOT_VERSION << ". Please remove the snapshot so that it can be recreated." << endl;
+		exit(1);
+	}
+
+	if(memcmp((const char*)&header.Identity, (const char*)&identity, sizeof(HashSnapshotIdentity)) != 0) {
+		cout << "ERROR: The hash table snapshot (" << filename << ") was created with a different reference sequence archive, algorithm, hash size or hash position threshold. Please remove the snapshot or specify another snapshot filename." << endl;
+		exit(1);
+	}
+
+	// read and validate the section table
+	vector<uint64_t> sectionTable(header.NumSections * 2);
+	if((header.NumSections > 0) && (fread((char*)&sectionTable[0], sizeof(uint64_t), sectionTable.size(), in) != sectionTable.size())) {
+		cout << "ERROR: The hash table snapshot (" << filename << ") is truncated." << endl;
+		exit(1);
+	}
+
+	for(unsigned int i = 0; i < header.NumSections; i++) {
+		const uint64_t offset = sectionTable[2 * i], numBytes = sectionTable[2 * i + 1];
+		if((offset % HASH_SNAPSHOT_ALIGNMENT != 0) || (offset > fileSize) || (numBytes > fileSize - offset)) {
+			cout << "ERROR: The hash table snapshot (" << filename << ") is truncated." << endl;
+			exit(1);
+		}
+	}
+
+	// replace the current hash table with the snapshot
+	if(mMemoryAllocated) FreeMemory();
+
+#ifndef WIN32
+	void* pData = mmap(NULL, (size_t)fileSize, PROT_READ, MAP_SHARED, fileno(in), 0);
+
+	if(pData == MAP_FAILED) {
+		cout << "ERROR: Unable to memory map the hash table snapshot (" << filename << ")." << endl;
+		exit(1);
+	}
+
+	// start reading the whole snapshot in the background: the lookups are random
+	madvise(pData, (size_t)fileSize, MADV_WILLNEED);
+	mSnapshotBuffer = (char*)pData;
+#else
+	try {
+		mSnapshotBuffer = new char[fileSize];
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the hash table snapshot." << endl;
+		exit(1);
+	}
+
+	fseek64(in, 0, SEEK_SET);
+	fread(mSnapshotBuffer, (size_t)fileSize, 1, in);
+#endif
+
+	fclose(in);
+
+	mSnapshotBufferLen = fileSize;
+	mMemoryAllocated   = true;
+	mCapacity          = header.Capacity;
+	mMask              = header.Mask;
+	mCount             = header.Count;
+	mThreshold         = header.Threshold;
+
+	vector<HashSnapshotSection> sections(header.NumSections);
+	for(unsigned int i = 0; i < header.NumSections; i++) {
+		sections[i].pData    = mSnapshotBuffer + sectionTable[2 * i];
+		sections[i].NumBytes = sectionTable[2 * i + 1];
+	}
+
+	if(!AttachSnapshotSections(sections)) {
+		cout << "ERROR: The hash table snapshot (" << filename << ") does not match the hash table used by the selected algorithm." << endl;
+		exit(1);
+	}
+
+	return true;
+}
+
+// releases the memory used by a loaded snapshot
+void CAbstractDnaHash::ReleaseSnapshot(void) {
+
+	if(!mSnapshotBuffer) return;
+
+#ifndef WIN32
+	munmap(mSnapshotBuffer, (size_t)mSnapshotBufferLen);
+#else
+	delete [] mSnapshotBuffer;
+#endif
+
+	mSnapshotBuffer    = NULL;
+	mSnapshotBufferLen = 0;
+}
+
+// writes the finished hash table to a snapshot file
+void CAbstractDnaHash::SaveSnapshot(const string& filename, const HashSnapshotIdentity& identity) {
+
+	vector<HashSnapshotSection> sections;
+	if(!GetSnapshotSections(sections)) {
+		cout << "ERROR: Hash table snapshots are not supported by the selected hash table." << endl;
+		exit(1);
+	}
+
+	HashSnapshotHeader header;
+	memset((char*)&header, 0, sizeof(HashSnapshotHeader));
+	memcpy(header.Signature, HASH_SNAPSHOT_SIGNATURE, HASH_SNAPSHOT_SIGNATURE_LEN);
+	header.Version     = HASH_SNAPSHOT_VERSION;
+	header.NumSections = (uint32_t)sections.size();
+	header.Identity    = identity;
+	header.Capacity    = mCapacity;
+	header.Mask        = mMask;
+	header.Count       = mCount;
+	header.Threshold   = mThreshold;
+
+	// lay out the sections after the header and the section table
+	vector<uint64_t> sectionTable(sections.size() * 2);
+	uint64_t offset = sizeof(HashSnapshotHeader) + sectionTable.size() * sizeof(uint64_t);
+
+	for(unsigned int i = 0; i < (unsigned int)sections.size(); i++) {
+		offset = (offset + HASH_SNAPSHOT_ALIGNMENT - 1) / HASH_SNAPSHOT_ALIGNMENT * HASH_SNAPSHOT_ALIGNMENT;
+		sectionTable[2 * i]     = offset;
+		sectionTable[2 * i + 1] = sections[i].NumBytes;
+		offset += sections[i].NumBytes;
+	}
+
+	// write to a temporary file first: concurrent jobs should never see a partial snapshot
+	ostringstream sb;
+	sb << filename << ".tmp";
+#ifndef WIN32
+	sb << "." << getpid();
+#endif
+	const string tempFilename = sb.str();
+
+	FILE* out = fopen(tempFilename.c_str(), "wb");
+	if(!out) {
+		cout << "ERROR: Unable to open the hash table snapshot (" << tempFilename << ") for writing." << endl;
+		exit(1);
+	}
+
+	bool isOk = (fwrite((const char*)&header, sizeof(HashSnapshotHeader), 1, out) == 1);
+	if(isOk && !sectionTable.empty()) isOk = (fwrite((const char*)&sectionTable[0], sizeof(uint64_t), sectionTable.size(), out) == sectionTable.size());
+
+	const char padding[HASH_SNAPSHOT_ALIGNMENT] = {0};
+	for(unsigned int i = 0; isOk && (i < (unsigned int)sections.size()); i++) {
+		const uint64_t position = ftell64(out);
+		if(position < sectionTable[2 * i]) isOk = (fwrite(padding, (size_t)(sectionTable[2 * i] - position), 1, out) == 1);
+		if(isOk && (sections[i].NumBytes > 0)) isOk = (fwrite(sections[i].pData, (size_t)sections[i].NumBytes, 1, out) == 1);
+	}
+
+	if((fclose(out) != 0) || !isOk) {
+		cout << "ERROR: Unable to write the hash table snapshot (" << tempFilename << ")." << endl;
+		remove(tempFilename.c_str());
+		exit(1);
+	}
+
+	if(rename(tempFilename.c_str(), filename.c_str()) != 0) {
+		cout << "ERROR: Unable to rename the hash table snapshot to " << filename << "." << endl;
+		remove(tempFilename.c_str());
+		exit(1);
+	}
+}
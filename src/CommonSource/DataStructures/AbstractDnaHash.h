@@ -11,13 +11,109 @@
 #pragma once
 
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "Mosaik.h"
+#include "LargeFileSupport.h"
 #include "PosixThreads.h"
 #include "HashRegionTree.h"
 
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 using namespace std;
 using namespace AVLTree;
 
+// the number of lookups between prefetching a hash slot and resolving it
+#define HASH_PREFETCH_DISTANCE 8
+
+// the hash table snapshot signature and file format version
+#define HASH_SNAPSHOT_SIGNATURE     "MOSAIKHS"
+#define HASH_SNAPSHOT_SIGNATURE_LEN 8
+#define HASH_SNAPSHOT_VERSION       1
+
+// every hash table array in a snapshot starts on this byte boundary
+#define HASH_SNAPSHOT_ALIGNMENT 64
+
+// denotes a snapshot that was not trimmed with a hash position threshold
+#define HASH_SNAPSHOT_NO_THRESHOLD 0xffffffff
+
+// identifies the reference sequence and aligner settings a hash table snapshot was built with
+struct HashSnapshotIdentity {
+	uint64_t ReferenceLength;
+	uint64_t ReferenceChecksum;
+	uint32_t NumReferenceSequences;
+	uint32_t Algorithm;
+	uint32_t HashSize;
+	uint32_t HashPositionThreshold;
+	uint32_t IsColorspace;
+	uint32_t Reserved;
+
+	HashSnapshotIdentity(void)
+		: ReferenceLength(0)
+		, ReferenceChecksum(0)
+		, NumReferenceSequences(0)
+		, Algorithm(0)
+		, HashSize(0)
+		, HashPositionThreshold(HASH_SNAPSHOT_NO_THRESHOLD)
+		, IsColorspace(0)
+		, Reserved(0)
+	{}
+};
+
+// the fixed-size header at the start of a hash table snapshot
+struct HashSnapshotHeader {
+	char Signature[HASH_SNAPSHOT_SIGNATURE_LEN];
+	uint32_t Version;
+	uint32_t NumSections;
+	HashSnapshotIdentity Identity;
+	uint32_t Capacity;
+	uint32_t Mask;
+	uint32_t Count;
+	uint32_t Threshold;
+};
+
+// points to one of the hash table arrays stored in a snapshot
+struct HashSnapshotSection {
+	char* pData;
+	uint64_t NumBytes;
+
+	HashSnapshotSection(void)
+		: pData(NULL)
+		, NumBytes(0)
+	{}
+
+	HashSnapshotSection(char* data, const uint64_t numBytes)
+		: pData(data)
+		, NumBytes(numBytes)
+	{}
+};
+
+// stores one hash lookup in a batched retrieval
+struct HashLookup {
+	uint64_t Key;
+	unsigned int QueryPosition;
+	double MhpOccupancy;
+	// the same window on the reverse strand (canonical lookups only)
+	uint64_t ReverseKey;
+	unsigned int ReverseQueryPosition;
+	double ReverseMhpOccupancy;
+
+	HashLookup(void)
+		: Key(0)
+		, QueryPosition(0)
+		, MhpOccupancy(1.0)
+		, ReverseKey(0)
+		, ReverseQueryPosition(0)
+		, ReverseMhpOccupancy(1.0)
+	{}
+};
+
 class CAbstractDnaHash {
 public:
 	CAbstractDnaHash(void);
@@ -26,24 +122,56 @@ public:
 	virtual void Add(const uint64_t& key, const unsigned int genomePosition) = 0;
 	// resets the counter and hash positions values
 	virtual void Clear(void) = 0;
+	// finishes a pass over the reference sequence, returns false if another pass is needed
+	virtual bool FinishBuildPass(void);
+	// finishes the current pass for one build partition (called by the thread that owns it)
+	virtual void FinishBuildPartition(const unsigned int partition);
+	// returns the build partition of the key
+	inline unsigned int GetBuildPartition(const uint64_t& key) const;
+	// returns the number of build partitions: keys in different partitions can be added concurrently
+	virtual unsigned int GetNumBuildPartitions(void) const;
 	// retrieves the genome location of the fragment
 	virtual void Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy) = 0;
+	// retrieves the genome locations of all of the fragments (in order of the lookups)
+	virtual void GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt);
+	// retrieves the genome locations of both strands with one canonical lookup per fragment
+	virtual void GetCanonicalBatch(vector<HashLookup>& lookups, CHashRegionTree& forwardHrt, CHashRegionTree& reverseHrt);
+	// returns true if the hash table stores canonical keys (both strands are retrieved by GetCanonicalBatch)
+	virtual bool IsCanonical(void) const;
 	// dumps the contents of the hash table to standard output
 	virtual void Dump(void) = 0;
 	// redimension the hash table to the specified size
 	virtual void FreeMemory(void) = 0;
 	// randomize and trim hash positions
 	virtual void RandomizeAndTrimHashPositions(unsigned short numHashPositions) = 0;
+	// memory maps a hash table snapshot built with the same identity, returns false if the snapshot does not exist
+	bool LoadSnapshot(const string& filename, const HashSnapshotIdentity& identity);
+	// writes the finished hash table to a snapshot file
+	void SaveSnapshot(const string& filename, const HashSnapshotIdentity& identity);
 	// register our thread mutexes
-	static pthread_mutex_t mJumpCacheMutex;
 	static pthread_mutex_t mJumpKeyMutex;
 	static pthread_mutex_t mJumpPositionMutex;
 	
 protected:
+	// searches for the key starting at the specified position, returns false if the key was not found
+	inline bool FindKey(const uint64_t& key, unsigned int& position) const;
 	// translates the supplied hash to a position in the hash table
 	inline unsigned int IndexFor(uint64_t index) const;
+	// scrambles the bits of the supplied hash
+	static inline uint64_t MixKey(uint64_t index);
+	// translates the supplied hash to a position in the hash table and prefetches the key
+	inline unsigned int PrefetchIndexFor(const uint64_t& key) const;
 	// runs when we need to resize the hash table
 	virtual void Resize(void) = 0;
+	// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+	virtual bool AttachSnapshotSections(const vector<HashSnapshotSection>& sections);
+	// retrieves the hash table arrays that are stored in a snapshot, returns false if snapshots are not supported
+	virtual bool GetSnapshotSections(vector<HashSnapshotSection>& sections);
+	// releases the memory used by a loaded snapshot
+	void ReleaseSnapshot(void);
+	// stores the loaded snapshot (the hash table arrays point into this buffer)
+	char* mSnapshotBuffer;
+	uint64_t mSnapshotBufferLen;
 	// stores the hashes
 	uint64_t* mHashes;
 	// registers how many elements our hash can handle
@@ -64,10 +192,23 @@ protected:
 	const static unsigned int LargestResizeableSize;
 	// stores the current hash size
 	unsigned char mHashSize;
+	// selects the build partition from the key (hash tables with one build partition use a zero mask)
+	unsigned char mBuildPartitionShift;
+	unsigned int mBuildPartitionMask;
 };
 
+// returns the build partition of the key
+inline unsigned int CAbstractDnaHash::GetBuildPartition(const uint64_t& key) const {
+	return (unsigned int)(key >> mBuildPartitionShift) & mBuildPartitionMask;
+}
+
 // translates the supplied hash to a position in the hash table
 inline unsigned int CAbstractDnaHash::IndexFor(uint64_t index) const {
+	return (unsigned int)(MixKey(index) & mMask);
+}
+
+// scrambles the bits of the supplied hash
+inline uint64_t CAbstractDnaHash::MixKey(uint64_t index) {
 	index = (~index) + (index << 21);
 	index = index ^ (index >> 24);
 	index = (index + (index << 3)) + (index << 8);
@@ -75,6 +216,33 @@ inline unsigned int CAbstractDnaHash::IndexFor(uint64_t index) const {
 	index = (index + (index << 2)) + (index << 4);
 	index = index ^ (index >> 28);
 	index = index + (index << 31);
-	return index & mMask;
+	return index;
+}
+
+// translates the supplied hash to a position in the hash table and prefetches the key
+inline unsigned int CAbstractDnaHash::PrefetchIndexFor(const uint64_t& key) const {
+	unsigned int position = IndexFor(key);
+	if(position >= mCapacity) position = 0;
+	PREFETCH_READ(mHashes + position);
+	return position;
+}
+
+// searches for the key starting at the specified position, returns false if the key was not found
+inline bool CAbstractDnaHash::FindKey(const uint64_t& key, unsigned int& position) const {
+
+	// find an unused element
+	while(mHashes[position] != DNA_HASH_EMPTY_KEY) {
+
+		// check to see if it already exists
+		if(mHashes[position] == key) return true;
+
+		// get the next position
+		position++;
+
+		// wrap around if needed
+		if(position >= mCapacity) position = 0;
+	}
+
+	return false;
 }
 
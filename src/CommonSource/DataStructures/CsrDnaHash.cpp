@@ -0,0 +1,519 @@
+// ***************************************************************************
+// CCsrDnaHash - genome hash map used in the all algorithm. Stores the sorted
+//               keys, their position offsets and one contiguous positions
+//               array (compressed sparse row). Built in two passes over the
+//               reference sequence. (unlimited genome positions / hash)
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "CsrDnaHash.h"
+
+// constructor
+CCsrDnaHash::CCsrDnaHash(const unsigned char bitCapacity, const unsigned char hashSize)
+: mBuildPass(BuildPass_COUNT)
+, mInitialPartitionCapacity(0)
+, mKeys(NULL)
+, mNumKeys(0)
+, mOffsets(NULL)
+, mPositions(NULL)
+, mNumPositions(0)
+, mFillOffsets(NULL)
+, mDirectory(NULL)
+, mDirectoryShift(0)
+{
+	mCount     = 0;
+	mCapacity  = 0;
+	mMask      = 0;
+	mLoad      = 0.8f;
+	mThreshold = 0;
+	mHashSize  = hashSize;
+
+	// split the estimated table size over the key ranges
+	mBuildPartitionShift = hashSize * 2 - CSR_BUILD_PARTITION_BITS;
+	mBuildPartitionMask  = (1 << CSR_BUILD_PARTITION_BITS) - 1;
+	mPartitions.resize(1 << CSR_BUILD_PARTITION_BITS);
+
+	const unsigned char partitionBits = (bitCapacity > CSR_BUILD_PARTITION_BITS + 8 ? bitCapacity - CSR_BUILD_PARTITION_BITS : 8);
+	mInitialPartitionCapacity = 1 << (partitionBits < 31 ? partitionBits : 31);
+
+	// set the default settings for each element
+	mMemoryAllocated = true;
+	Clear();
+}
+
+// destructor
+CCsrDnaHash::~CCsrDnaHash(void) {
+	if(mMemoryAllocated) FreeMemory();
+}
+
+// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+bool CCsrDnaHash::AttachSnapshotSections(const vector<HashSnapshotSection>& sections) {
+
+	if((sections.size() != 4) || (sections[0].NumBytes % SIZEOF_UINT64 != 0) || (sections[2].NumBytes % SIZEOF_INT != 0)) return false;
+
+	mNumKeys      = (unsigned int)(sections[0].NumBytes / SIZEOF_UINT64);
+	mNumPositions = (unsigned int)(sections[2].NumBytes / SIZEOF_INT);
+	if(sections[1].NumBytes != ((uint64_t)mNumKeys + 1) * SIZEOF_INT) return false;
+
+	// the directory size determines the directory shift
+	const unsigned char keyBits = mHashSize * 2;
+	unsigned char directoryBits = 1;
+	while((directoryBits < keyBits) && ((((uint64_t)1 << directoryBits) + 1) * SIZEOF_INT < sections[3].NumBytes)) directoryBits++;
+	if(((((uint64_t)1 << directoryBits) + 1) * SIZEOF_INT) != sections[3].NumBytes) return false;
+
+	mKeys           = (uint64_t*)sections[0].pData;
+	mOffsets        = (unsigned int*)sections[1].pData;
+	mPositions      = (unsigned int*)sections[2].pData;
+	mDirectory      = (unsigned int*)sections[3].pData;
+	mDirectoryShift = keyBits - directoryBits;
+	mBuildPass      = BuildPass_COMPLETE;
+
+	return true;
+}
+
+// retrieves the hash table arrays that are stored in a snapshot, returns false if the hash table is not finished
+bool CCsrDnaHash::GetSnapshotSections(vector<HashSnapshotSection>& sections) {
+
+	if(mBuildPass != BuildPass_COMPLETE) return false;
+
+	const uint64_t numDirectoryEntries = (uint64_t)1 << (mHashSize * 2 - mDirectoryShift);
+
+	sections.clear();
+	sections.push_back(HashSnapshotSection((char*)mKeys,      (uint64_t)mNumKeys * SIZEOF_UINT64));
+	sections.push_back(HashSnapshotSection((char*)mOffsets,   ((uint64_t)mNumKeys + 1) * SIZEOF_INT));
+	sections.push_back(HashSnapshotSection((char*)mPositions, (uint64_t)mNumPositions * SIZEOF_INT));
+	sections.push_back(HashSnapshotSection((char*)mDirectory, (numDirectoryEntries + 1) * SIZEOF_INT));
+
+	return true;
+}
+
+// allocates an empty counting table for the build partition
+void CCsrDnaHash::AllocatePartition(BuildPartition& bp, const unsigned int capacity) {
+
+	try {
+
+		bp.Hashes = new uint64_t[capacity];
+		bp.Counts = new unsigned int[capacity];
+
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the DNA hash map." << endl;
+		exit(1);
+	}
+
+	uninitialized_fill(bp.Hashes, bp.Hashes + capacity, DNA_HASH_EMPTY_KEY);
+	uninitialized_fill(bp.Counts, bp.Counts + capacity, 0);
+
+	bp.Capacity  = capacity;
+	bp.Mask      = capacity - 1;
+	bp.Threshold = (unsigned int)(capacity * mLoad);
+}
+
+// frees the counting table of the build partition
+void CCsrDnaHash::FreePartition(BuildPartition& bp) {
+	delete [] bp.Hashes;
+	delete [] bp.Counts;
+	bp.Hashes   = NULL;
+	bp.Counts   = NULL;
+	bp.Capacity = 0;
+	vector<uint64_t>().swap(bp.SortedKeys);
+	vector<unsigned int>().swap(bp.SortedCounts);
+}
+
+// frees all memory used by the hash table
+void CCsrDnaHash::FreeMemory(void) {
+	mMemoryAllocated = false;
+
+	for(vector<BuildPartition>::iterator pIter = mPartitions.begin(); pIter != mPartitions.end(); ++pIter)
+		FreePartition(*pIter);
+
+	// the arrays of a loaded snapshot point into the snapshot buffer
+	if(mSnapshotBuffer) ReleaseSnapshot();
+	else {
+		delete [] mKeys;
+		delete [] mOffsets;
+		delete [] mPositions;
+		delete [] mDirectory;
+	}
+
+	delete [] mFillOffsets;
+
+	mKeys        = NULL;
+	mOffsets     = NULL;
+	mPositions   = NULL;
+	mFillOffsets = NULL;
+	mDirectory   = NULL;
+}
+
+// adds a fragment to the hash table
+void CCsrDnaHash::Add(const uint64_t& key, const unsigned int genomePosition) {
+
+	// store the genome position in the slot reserved during the counting pass
+	if(mBuildPass == BuildPass_FILL) {
+
+		unsigned int keyIndex;
+		if(!FindKeyIndex(key, keyIndex)) {
+			cout << "ERROR: A hash was found during the second pass over the reference sequence that was not counted during the first pass." << endl;
+			exit(1);
+		}
+
+		mPositions[mFillOffsets[keyIndex]++] = genomePosition;
+		return;
+	}
+
+	if(mBuildPass == BuildPass_COMPLETE) {
+		cout << "ERROR: Hashes cannot be added to the CSR hash table once it has been built." << endl;
+		exit(1);
+	}
+
+	BuildPartition& bp = mPartitions[GetBuildPartition(key)];
+
+	// check to see if we need to resize the hash table
+	if((bp.NumKeys + 1) > bp.Threshold) ResizePartition(bp);
+
+	unsigned int position;
+	if(!FindPartitionKey(bp, key, position)) {
+
+		// assign the key
+		bp.Hashes[position] = key;
+
+		// increase the counter
+		bp.NumKeys++;
+	}
+
+	bp.Counts[position]++;
+	bp.NumPositions++;
+}
+
+// resets the counter and hash positions values
+void CCsrDnaHash::Clear(void) {
+
+	FreeMemory();
+	mMemoryAllocated = true;
+
+	// create empty counting tables
+	for(vector<BuildPartition>::iterator pIter = mPartitions.begin(); pIter != mPartitions.end(); ++pIter) {
+		AllocatePartition(*pIter, mInitialPartitionCapacity);
+		pIter->NumKeys      = 0;
+		pIter->NumPositions = 0;
+	}
+
+	// reset the counter and collisions variables
+	mCount        = 0;
+	mNumKeys      = 0;
+	mNumPositions = 0;
+	mBuildPass    = BuildPass_COUNT;
+}
+
+// creates the sorted keys, offsets and key directory from the key counts
+void CCsrDnaHash::CreateIndex(void) {
+
+	// finish any partition that was not finished by a hashing thread
+	for(unsigned int i = 0; i < (unsigned int)mPartitions.size(); i++)
+		if(mPartitions[i].Hashes) FinishBuildPartition(i);
+
+	mNumKeys      = 0;
+	mNumPositions = 0;
+
+	for(vector<BuildPartition>::const_iterator pIter = mPartitions.begin(); pIter != mPartitions.end(); ++pIter) {
+		mNumKeys      += pIter->NumKeys;
+		mNumPositions += pIter->NumPositions;
+	}
+
+	mCount = mNumKeys;
+
+	try {
+
+		// the partitions are key ranges, so concatenating them keeps the keys sorted
+		mKeys    = new uint64_t[mNumKeys];
+		mOffsets = new unsigned int[mNumKeys + 1];
+
+		unsigned int keyIndex = 0, offset = 0;
+		for(vector<BuildPartition>::iterator pIter = mPartitions.begin(); pIter != mPartitions.end(); ++pIter) {
+
+			for(unsigned int i = 0; i < pIter->NumKeys; i++, keyIndex++) {
+				mKeys[keyIndex]    = pIter->SortedKeys[i];
+				mOffsets[keyIndex] = offset;
+				offset += pIter->SortedCounts[i];
+			}
+
+			FreePartition(*pIter);
+		}
+
+		mOffsets[mNumKeys] = offset;
+
+		// create the key directory: roughly one key per entry
+		const unsigned char keyBits = mHashSize * 2;
+		unsigned char directoryBits = 1;
+		while(((1ULL << (directoryBits + 1)) <= mNumKeys) && (directoryBits < CSR_MAX_DIRECTORY_BITS) && (directoryBits < keyBits)) directoryBits++;
+
+		mDirectoryShift = keyBits - directoryBits;
+		const unsigned int numDirectoryEntries = 1 << directoryBits;
+		mDirectory = new unsigned int[numDirectoryEntries + 1];
+
+		keyIndex = 0;
+		for(unsigned int i = 0; i < numDirectoryEntries; i++) {
+			mDirectory[i] = keyIndex;
+			while((keyIndex < mNumKeys) && (GetDirectoryIndex(mKeys[keyIndex]) == i)) keyIndex++;
+		}
+
+		mDirectory[numDirectoryEntries] = mNumKeys;
+
+		// reserve the positions
+		mPositions   = new unsigned int[mNumPositions];
+		mFillOffsets = new unsigned int[mNumKeys];
+		memcpy(mFillOffsets, mOffsets, mNumKeys * SIZEOF_INT);
+
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the DNA hash map." << endl;
+		exit(1);
+	}
+}
+
+// finishes a pass over the reference sequence, returns false if another pass is needed
+bool CCsrDnaHash::FinishBuildPass(void) {
+
+	switch(mBuildPass) {
+		case BuildPass_COUNT:
+			CreateIndex();
+			mBuildPass = BuildPass_FILL;
+			return false;
+		case BuildPass_FILL:
+			delete [] mFillOffsets;
+			mFillOffsets = NULL;
+			mBuildPass = BuildPass_COMPLETE;
+			return true;
+		default:
+			return true;
+	}
+}
+
+// finishes the current pass for one build partition (called by the thread that owns it)
+void CCsrDnaHash::FinishBuildPartition(const unsigned int partition) {
+
+	if(mBuildPass != BuildPass_COUNT) return;
+
+	BuildPartition& bp = mPartitions[partition];
+
+	// sort the keys of this key range
+	bp.SortedKeys.resize(bp.NumKeys);
+	unsigned int keyIndex = 0;
+	for(unsigned int i = 0; i < bp.Capacity; i++)
+		if(bp.Hashes[i] != DNA_HASH_EMPTY_KEY) bp.SortedKeys[keyIndex++] = bp.Hashes[i];
+
+	sort(bp.SortedKeys.begin(), bp.SortedKeys.end());
+
+	// retrieve their counts
+	bp.SortedCounts.resize(bp.NumKeys);
+	for(unsigned int i = 0; i < bp.NumKeys; i++) {
+		unsigned int position;
+		FindPartitionKey(bp, bp.SortedKeys[i], position);
+		bp.SortedCounts[i] = bp.Counts[position];
+	}
+
+	// the counting table is no longer needed
+	delete [] bp.Hashes;
+	delete [] bp.Counts;
+	bp.Hashes   = NULL;
+	bp.Counts   = NULL;
+	bp.Capacity = 0;
+}
+
+// returns the number of build partitions: keys in different partitions can be added concurrently
+unsigned int CCsrDnaHash::GetNumBuildPartitions(void) const {
+	return (unsigned int)mPartitions.size();
+}
+
+// retrieves the genome location of the fragment
+void CCsrDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy) {
+
+	// use a fixed mhp occupancy
+	mhpOccupancy = 1.0;
+
+	unsigned int keyIndex;
+	if(!FindKeyIndex(key, keyIndex)) return;
+
+	// create new hash regions and add them to the tree
+	const unsigned int endOffset = mOffsets[keyIndex + 1];
+	for(unsigned int i = mOffsets[keyIndex]; i < endOffset; i++) {
+		HashRegion island;
+		island.Begin         = mPositions[i];
+		island.End           = mPositions[i] + mHashSize - 1;
+		island.QueryBegin    = queryPosition;
+		island.QueryEnd      = queryPosition + mHashSize - 1;
+		hrt.Insert(island);
+	}
+}
+
+// retrieves the genome locations of all of the fragments (in order of the lookups)
+void CCsrDnaHash::GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt) {
+
+	// each lookup is prefetched in two stages: first the key directory entry,
+	// then the key offsets once the key has been found
+	const unsigned int numLookups  = (unsigned int)lookups.size();
+	const unsigned int keyDistance = HASH_PREFETCH_DISTANCE;
+	const unsigned int posDistance = HASH_PREFETCH_DISTANCE / 2;
+
+	unsigned int keyIndexes[HASH_PREFETCH_DISTANCE];
+	bool foundKeys[HASH_PREFETCH_DISTANCE];
+
+	for(unsigned int i = 0; (i < keyDistance) && (i < numLookups); i++)
+		PREFETCH_READ(mDirectory + GetDirectoryIndex(lookups[i].Key));
+
+	for(unsigned int i = 0; (i < posDistance) && (i < numLookups); i++) {
+		foundKeys[i] = FindKeyIndex(lookups[i].Key, keyIndexes[i]);
+		if(foundKeys[i]) PREFETCH_READ(mOffsets + keyIndexes[i]);
+	}
+
+	for(unsigned int i = 0; i < numLookups; i++) {
+
+		HashLookup& lookup = lookups[i];
+		const unsigned int keyIndex = keyIndexes[i % HASH_PREFETCH_DISTANCE];
+		const bool foundKey = foundKeys[i % HASH_PREFETCH_DISTANCE];
+
+		// find the key and prefetch its offsets
+		const unsigned int resolveIndex = i + posDistance;
+		if(resolveIndex < numLookups) {
+			const unsigned int r = resolveIndex % HASH_PREFETCH_DISTANCE;
+			foundKeys[r] = FindKeyIndex(lookups[resolveIndex].Key, keyIndexes[r]);
+			if(foundKeys[r]) PREFETCH_READ(mOffsets + keyIndexes[r]);
+		}
+
+		// prefetch the key directory entry
+		const unsigned int prefetchIndex = i + keyDistance;
+		if(prefetchIndex < numLookups) PREFETCH_READ(mDirectory + GetDirectoryIndex(lookups[prefetchIndex].Key));
+
+		// use a fixed mhp occupancy
+		lookup.MhpOccupancy = 1.0;
+
+		if(!foundKey) continue;
+
+		// create new hash regions and add them to the tree
+		const unsigned int endOffset = mOffsets[keyIndex + 1];
+		for(unsigned int j = mOffsets[keyIndex]; j < endOffset; j++) {
+			HashRegion island;
+			island.Begin         = mPositions[j];
+			island.End           = mPositions[j] + mHashSize - 1;
+			island.QueryBegin    = lookup.QueryPosition;
+			island.QueryEnd      = lookup.QueryPosition + mHashSize - 1;
+			hrt.Insert(island);
+		}
+	}
+}
+
+// doubles the size of a counting table
+void CCsrDnaHash::ResizePartition(BuildPartition& bp) {
+
+	if(bp.Capacity >= LargestResizeableSize) {
+		cout << "ERROR: Cannot resize hash table. Already at maximum capacity." << endl;
+		exit(1);
+	}
+
+	// keep the old table
+	uint64_t* tHashes        = bp.Hashes;
+	unsigned int* tCounts    = bp.Counts;
+	unsigned int oldCapacity = bp.Capacity;
+
+	// populate the new table
+	AllocatePartition(bp, oldCapacity << 1);
+
+	for(unsigned int i = 0; i < oldCapacity; i++) {
+
+		// if it was an active element, add it to the new hash
+		if(tHashes[i] != DNA_HASH_EMPTY_KEY) {
+			unsigned int position;
+			FindPartitionKey(bp, tHashes[i], position);
+			bp.Hashes[position] = tHashes[i];
+			bp.Counts[position] = tCounts[i];
+		}
+	}
+
+	// delete the old tables
+	delete [] tHashes;
+	delete [] tCounts;
+}
+
+// runs when we need to resize the hash table (unused, see ResizePartition)
+void CCsrDnaHash::Resize(void) {}
+
+// dumps the contents of the hash table to standard output
+void CCsrDnaHash::Dump(void) {
+
+	cout << "DNA hash table contents:" << endl;
+	cout << "========================" << endl;
+
+	if(mBuildPass != BuildPass_COMPLETE) {
+		cout << "the hash table has not been built yet." << endl;
+		return;
+	}
+
+	for(unsigned int i = 0; i < mNumKeys; i++) {
+		cout << "key: " << mKeys[i] << ", positions:";
+		for(unsigned int j = mOffsets[i]; j < mOffsets[i + 1]; j++) cout << " " << mPositions[j];
+		cout << endl;
+	}
+
+	cout << endl;
+	cout << "keys found in hash table: " << mNumKeys << ", positions found: " << mOffsets[mNumKeys] << endl;
+}
+
+// randomize and trim hash positions
+void CCsrDnaHash::RandomizeAndTrimHashPositions(unsigned short numHashPositions) {
+
+	// calculate the threshold if a zero parameter is given
+	if(numHashPositions == 0) {
+
+		cout << endl << "- calculating genome position threshold... ";
+		cout.flush();
+
+		double sum = 0.0;
+		unsigned int numHashes = mNumKeys;
+
+		// calculate the sum
+		for(unsigned int i = 0; i < mNumKeys; i++) sum += mOffsets[i + 1] - mOffsets[i];
+
+		// calculate the mean number of hash positions
+		double mean = sum / (double)numHashes;
+
+		// calculate the standard deviation
+		double diffSumSquare = 0.0;
+
+		for(unsigned int i = 0; i < mNumKeys; i++) {
+			double diffSum = (mOffsets[i + 1] - mOffsets[i]) - mean;
+			diffSumSquare += diffSum * diffSum;
+		}
+
+		double variance = diffSumSquare / (numHashes - 1.0);
+		double stddev   = sqrt(variance);
+
+		numHashPositions = (unsigned short)(mean + 4.0 * stddev);
+
+		cout << "finished." << endl;
+		cout << "- setting the max number of hash positions per hash (" << numHashPositions << ")" << endl;
+	}
+
+	// randomize, trim and compact the positions in place
+	unsigned int writeOffset = 0;
+	for(unsigned int i = 0; i < mNumKeys; i++) {
+
+		const unsigned int beginOffset = mOffsets[i];
+		unsigned int numPositions      = mOffsets[i + 1] - beginOffset;
+
+		if(numPositions > numHashPositions) {
+			std::shuffle(mPositions + beginOffset, mPositions + beginOffset + numPositions, std::default_random_engine{});
+			numPositions = numHashPositions;
+		}
+
+		if(writeOffset != beginOffset) memmove(mPositions + writeOffset, mPositions + beginOffset, numPositions * SIZEOF_INT);
+
+		mOffsets[i]  = writeOffset;
+		writeOffset += numPositions;
+	}
+
+	mOffsets[mNumKeys] = writeOffset;
+	mNumPositions      = writeOffset;
+}
@@ -0,0 +1,163 @@
+// ***************************************************************************
+// CCsrDnaHash - genome hash map used in the all algorithm. Stores the sorted
+//               keys, their position offsets and one contiguous positions
+//               array (compressed sparse row). Built in two passes over the
+//               reference sequence; each pass can be split by key range
+//               across threads. (unlimited genome positions / hash)
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "AbstractDnaHash.h"
+#include "MemoryUtilities.h"
+
+using namespace std;
+
+// the maximum number of bits used by the key directory
+#define CSR_MAX_DIRECTORY_BITS 30
+
+// the keys are counted in 2^CSR_BUILD_PARTITION_BITS independent key ranges
+#define CSR_BUILD_PARTITION_BITS 8
+
+class CCsrDnaHash : public CAbstractDnaHash {
+public:
+	// constructor
+	CCsrDnaHash(const unsigned char bitCapacity, const unsigned char hashSize);
+	// destructor
+	~CCsrDnaHash(void);
+	// adds a fragment to the hash table
+	void Add(const uint64_t& key, const unsigned int genomePosition);
+	// resets the counter and hash positions values
+	void Clear(void);
+	// finishes a pass over the reference sequence, returns false if another pass is needed
+	bool FinishBuildPass(void);
+	// finishes the current pass for one build partition (called by the thread that owns it)
+	void FinishBuildPartition(const unsigned int partition);
+	// returns the number of build partitions: keys in different partitions can be added concurrently
+	unsigned int GetNumBuildPartitions(void) const;
+	// retrieves the genome location of the fragment
+	void Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy);
+	// retrieves the genome locations of all of the fragments (in order of the lookups)
+	void GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt);
+	// dumps the contents of the hash table to standard output
+	void Dump(void);
+	// frees all memory used by the hash table
+	void FreeMemory(void);
+	// randomize and trim hash positions
+	void RandomizeAndTrimHashPositions(unsigned short numHashPositions);
+
+private:
+	// define our build passes
+	enum BuildPassType {
+		BuildPass_COUNT,
+		BuildPass_FILL,
+		BuildPass_COMPLETE
+	};
+	// counts the keys of one key range (counting pass only)
+	struct BuildPartition {
+		uint64_t* Hashes;
+		unsigned int* Counts;
+		unsigned int Capacity;
+		unsigned int Mask;
+		unsigned int Threshold;
+		unsigned int NumKeys;
+		unsigned int NumPositions;
+		// the sorted keys and their counts once the partition is finished
+		vector<uint64_t> SortedKeys;
+		vector<unsigned int> SortedCounts;
+
+		BuildPartition(void)
+			: Hashes(NULL)
+			, Counts(NULL)
+			, Capacity(0)
+			, Mask(0)
+			, Threshold(0)
+			, NumKeys(0)
+			, NumPositions(0)
+		{}
+	};
+	// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+	bool AttachSnapshotSections(const vector<HashSnapshotSection>& sections);
+	// retrieves the hash table arrays that are stored in a snapshot, returns false if the hash table is not finished
+	bool GetSnapshotSections(vector<HashSnapshotSection>& sections);
+	// allocates an empty counting table for the build partition
+	void AllocatePartition(BuildPartition& bp, const unsigned int capacity);
+	// searches for the key in the build partition, returns false if the key was not found
+	inline bool FindPartitionKey(const BuildPartition& bp, const uint64_t& key, unsigned int& position) const;
+	// frees the counting table of the build partition
+	static void FreePartition(BuildPartition& bp);
+	// creates the sorted keys, offsets and key directory from the key counts
+	void CreateIndex(void);
+	// returns the index of the key in the sorted key array, returns false if the key was not found
+	inline bool FindKeyIndex(const uint64_t& key, unsigned int& keyIndex) const;
+	// returns the key directory entry for the specified key
+	inline unsigned int GetDirectoryIndex(const uint64_t& key) const;
+	// doubles the size of a counting table
+	void ResizePartition(BuildPartition& bp);
+	// runs when we need to resize the hash table (unused, see ResizePartition)
+	void Resize(void);
+	// stores the current build pass
+	BuildPassType mBuildPass;
+	// stores the number of times each key occurs (counting pass only)
+	vector<BuildPartition> mPartitions;
+	unsigned int mInitialPartitionCapacity;
+	// stores the sorted keys
+	uint64_t* mKeys;
+	unsigned int mNumKeys;
+	// stores the offset of each key's positions (mNumKeys + 1 entries)
+	unsigned int* mOffsets;
+	// stores the genome positions of every key
+	unsigned int* mPositions;
+	unsigned int mNumPositions;
+	// stores the next free position of each key (fill pass only)
+	unsigned int* mFillOffsets;
+	// maps the leading key bits to a range of sorted keys
+	unsigned int* mDirectory;
+	unsigned char mDirectoryShift;
+};
+
+// returns the key directory entry for the specified key
+inline unsigned int CCsrDnaHash::GetDirectoryIndex(const uint64_t& key) const {
+	return (unsigned int)(key >> mDirectoryShift);
+}
+
+// returns the index of the key in the sorted key array, returns false if the key was not found
+inline bool CCsrDnaHash::FindKeyIndex(const uint64_t& key, unsigned int& keyIndex) const {
+
+	const unsigned int directoryIndex = GetDirectoryIndex(key);
+	const uint64_t* pBegin = mKeys + mDirectory[directoryIndex];
+	const uint64_t* pEnd   = mKeys + mDirectory[directoryIndex + 1];
+
+	const uint64_t* pKey = lower_bound(pBegin, pEnd, key);
+	if((pKey == pEnd) || (*pKey != key)) return false;
+
+	keyIndex = (unsigned int)(pKey - mKeys);
+	return true;
+}
+
+// searches for the key in the build partition, returns false if the key was not found
+inline bool CCsrDnaHash::FindPartitionKey(const BuildPartition& bp, const uint64_t& key, unsigned int& position) const {
+
+	position = (unsigned int)(MixKey(key) & bp.Mask);
+
+	// find an unused element
+	while(bp.Hashes[position] != DNA_HASH_EMPTY_KEY) {
+		if(bp.Hashes[position] == key) return true;
+		position = (position + 1) & bp.Mask;
+	}
+
+	return false;
+}
@@ -0,0 +1,156 @@
+// ***************************************************************************
+// CDiagonalSeedConsolidator - collects hash hits in a flat vector, radix
+//                             sorts them by diagonal and sweeps them into
+//                             hash regions in one linear pass.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "DiagonalSeedConsolidator.h"
+
+// constructor
+CDiagonalSeedConsolidator::CDiagonalSeedConsolidator(void)
+: mRadixCounts(1 << SEED_RADIX_BITS)
+{}
+
+// destructor
+CDiagonalSeedConsolidator::~CDiagonalSeedConsolidator(void) {}
+
+// removes all of the hash hits
+void CDiagonalSeedConsolidator::Clear(void) {
+	mSeeds.clear();
+}
+
+// consolidates the hash hits into hash regions sorted by reference position
+void CDiagonalSeedConsolidator::Consolidate(const unsigned int queryLength, const unsigned char hashSize, const unsigned char indelSize, vector<HashRegion>& regions) {
+
+	regions.clear();
+	if(mSeeds.empty()) return;
+
+	RadixSort();
+
+	// ===============================================
+	// sweep the hash hits on each diagonal into spans
+	// ===============================================
+
+	HashRegion current;
+	uint64_t currentDiagonal = 0;
+	bool hasCurrent = false;
+
+	for(vector<uint64_t>::const_iterator sIter = mSeeds.begin(); sIter != mSeeds.end(); ++sIter) {
+
+		const uint64_t diagonal       = *sIter >> 16;
+		const unsigned short queryPos = (unsigned short)(*sIter & 0xffff);
+
+		// extend the current span if the hash hit is in phase
+		if(hasCurrent && (diagonal == currentDiagonal) && ((int)queryPos - (int)current.QueryEnd <= (int)hashSize)) {
+			const unsigned short queryEnd = queryPos + hashSize - 1;
+			if(queryEnd > current.QueryEnd) {
+				current.End      += queryEnd - current.QueryEnd;
+				current.QueryEnd  = queryEnd;
+			}
+			continue;
+		}
+
+		if(hasCurrent) regions.push_back(current);
+
+		current.Begin      = (unsigned int)(diagonal + queryPos - SEED_DIAGONAL_OFFSET);
+		current.End        = current.Begin + hashSize - 1;
+		current.QueryBegin = queryPos;
+		current.QueryEnd   = queryPos + hashSize - 1;
+		currentDiagonal    = diagonal;
+		hasCurrent         = true;
+	}
+
+	regions.push_back(current);
+
+	// ==========================================================
+	// join spans separated by a single indel (as CHashRegionTree)
+	// ==========================================================
+
+	// N.B. like the AVL tree, each span is compared with the previous regions that
+	// start within one query length and is merged into the closest candidate
+	sort(regions.begin(), regions.end());
+
+	unsigned int numRegions = 0;
+	for(vector<HashRegion>::const_iterator rIter = regions.begin(); rIter != regions.end(); ++rIter) {
+
+		const HashRegion r = *rIter;
+		bool foundCandidate = false;
+
+		for(unsigned int i = numRegions; i-- > 0;) {
+
+			HashRegion& phr = regions[i];
+
+			// stop checking previous regions if an expected query length cannot exist prior to the span
+			if((phr.Begin + queryLength - 1) < r.Begin) break;
+
+			const int diffAnchors = (int)(r.Begin - phr.End);
+			const int diffQueries = (int)r.QueryBegin - (int)phr.QueryEnd;
+
+			const bool isInPhase   = (diffAnchors == diffQueries) && (diffQueries >= -(int)hashSize) && (diffQueries <= (int)hashSize);
+			const bool isInsertion = (diffAnchors == 1) && (diffQueries > 1) && (diffQueries <= (indelSize + 1));
+			const bool isDeletion  = (diffQueries == 1) && (diffAnchors > 1) && (diffAnchors <= (indelSize + 1));
+
+			if(isInPhase || isInsertion || isDeletion) {
+				phr.End      = r.End;
+				phr.QueryEnd = r.QueryEnd;
+				foundCandidate = true;
+				break;
+			}
+		}
+
+		if(!foundCandidate) regions[numRegions++] = r;
+	}
+
+	regions.resize(numRegions);
+}
+
+// sorts the seed keys in ascending order
+void CDiagonalSeedConsolidator::RadixSort(void) {
+
+	const unsigned int numSeeds = (unsigned int)mSeeds.size();
+	const unsigned int numBuckets = 1 << SEED_RADIX_BITS;
+	const uint64_t bucketMask = numBuckets - 1;
+
+	// small inputs are faster with a comparison sort
+	if(numSeeds < 64) {
+		sort(mSeeds.begin(), mSeeds.end());
+		return;
+	}
+
+	mSortBuffer.resize(numSeeds);
+
+	// only sort the digits that actually differ
+	uint64_t minKey = mSeeds[0], maxKey = mSeeds[0];
+	for(unsigned int i = 1; i < numSeeds; i++) {
+		if(mSeeds[i] < minKey) minKey = mSeeds[i];
+		if(mSeeds[i] > maxKey) maxKey = mSeeds[i];
+	}
+
+	const uint64_t keyRange = maxKey - minKey;
+
+	for(unsigned int shift = 0; (shift < 64) && ((keyRange >> shift) != 0); shift += SEED_RADIX_BITS) {
+
+		// count the digits
+		fill(mRadixCounts.begin(), mRadixCounts.end(), 0);
+		for(unsigned int i = 0; i < numSeeds; i++) mRadixCounts[((mSeeds[i] - minKey) >> shift) & bucketMask]++;
+
+		// convert the counts into bucket offsets
+		unsigned int offset = 0;
+		for(unsigned int b = 0; b < numBuckets; b++) {
+			const unsigned int count = mRadixCounts[b];
+			mRadixCounts[b] = offset;
+			offset += count;
+		}
+
+		// scatter the keys
+		for(unsigned int i = 0; i < numSeeds; i++) mSortBuffer[mRadixCounts[((mSeeds[i] - minKey) >> shift) & bucketMask]++] = mSeeds[i];
+
+		mSeeds.swap(mSortBuffer);
+	}
+}
@@ -0,0 +1,53 @@
+// ***************************************************************************
+// CDiagonalSeedConsolidator - collects hash hits in a flat vector, radix
+//                             sorts them by diagonal and sweeps them into
+//                             hash regions in one linear pass.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "HashRegion.h"
+#include "Mosaik.h"
+
+using namespace std;
+
+// the number of bits sorted per radix sort pass
+#define SEED_RADIX_BITS 16
+
+// keeps the diagonal positive when the hash hit precedes the query offset
+#define SEED_DIAGONAL_OFFSET 65536
+
+class CDiagonalSeedConsolidator {
+public:
+	// constructor
+	CDiagonalSeedConsolidator(void);
+	// destructor
+	~CDiagonalSeedConsolidator(void);
+	// adds a hash hit
+	inline void Add(const HashRegion& seed);
+	// removes all of the hash hits
+	void Clear(void);
+	// consolidates the hash hits into hash regions sorted by reference position
+	void Consolidate(const unsigned int queryLength, const unsigned char hashSize, const unsigned char indelSize, vector<HashRegion>& regions);
+private:
+	// sorts the seed keys in ascending order
+	void RadixSort(void);
+	// our seed keys: diagonal in the upper bits, query position in the lower 16 bits
+	vector<uint64_t> mSeeds;
+	vector<uint64_t> mSortBuffer;
+	vector<unsigned int> mRadixCounts;
+};
+
+// adds a hash hit
+inline void CDiagonalSeedConsolidator::Add(const HashRegion& seed) {
+	const uint64_t diagonal = (uint64_t)seed.Begin + SEED_DIAGONAL_OFFSET - seed.QueryBegin;
+	mSeeds.push_back((diagonal << 16) | seed.QueryBegin);
+}
@@ -54,8 +54,36 @@ CDnaHash::~CDnaHash(void) {
 // redimension the hash table to the specified size
 void CDnaHash::FreeMemory(void) {
 	mMemoryAllocated = false;
-	delete [] mHashes;
-	delete [] mHashPositions;
+
+	// the arrays of a loaded snapshot point into the snapshot buffer
+	if(mSnapshotBuffer) ReleaseSnapshot();
+	else {
+		delete [] mHashes;
+		delete [] mHashPositions;
+	}
+
+	mHashes        = NULL;
+	mHashPositions = NULL;
+}
+
+// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+bool CDnaHash::AttachSnapshotSections(const vector<HashSnapshotSection>& sections) {
+
+	if((sections.size() != 2) || (sections[0].NumBytes != (uint64_t)mCapacity * SIZEOF_UINT64) ||
+		(sections[1].NumBytes != (uint64_t)mCapacity * SIZEOF_INT)) return false;
+
+	mHashes        = (uint64_t*)sections[0].pData;
+	mHashPositions = (unsigned int*)sections[1].pData;
+
+	return true;
+}
+
+// retrieves the hash table arrays that are stored in a snapshot
+bool CDnaHash::GetSnapshotSections(vector<HashSnapshotSection>& sections) {
+	sections.clear();
+	sections.push_back(HashSnapshotSection((char*)mHashes,        (uint64_t)mCapacity * SIZEOF_UINT64));
+	sections.push_back(HashSnapshotSection((char*)mHashPositions, (uint64_t)mCapacity * SIZEOF_INT));
+	return true;
 }
 
 // adds a fragment to the hash table
@@ -199,6 +227,46 @@ void CDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, CHash
 	}
 }
 
+// retrieves the genome locations of all of the fragments (in order of the lookups)
+void CDnaHash::GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt) {
+
+	const unsigned int numLookups = (unsigned int)lookups.size();
+	unsigned int positions[HASH_PREFETCH_DISTANCE];
+
+	// prefetch the first hash slots
+	for(unsigned int i = 0; (i < HASH_PREFETCH_DISTANCE) && (i < numLookups); i++) {
+		positions[i] = PrefetchIndexFor(lookups[i].Key);
+		PREFETCH_READ(mHashPositions + positions[i]);
+	}
+
+	for(unsigned int i = 0; i < numLookups; i++) {
+
+		HashLookup& lookup = lookups[i];
+		unsigned int position = positions[i % HASH_PREFETCH_DISTANCE];
+
+		// prefetch the hash slot that is resolved a few lookups from now
+		const unsigned int prefetchIndex = i + HASH_PREFETCH_DISTANCE;
+		if(prefetchIndex < numLookups) {
+			const unsigned int prefetchPosition = PrefetchIndexFor(lookups[prefetchIndex].Key);
+			PREFETCH_READ(mHashPositions + prefetchPosition);
+			positions[i % HASH_PREFETCH_DISTANCE] = prefetchPosition;
+		}
+
+		// use a fixed mhp occupancy
+		lookup.MhpOccupancy = 1.0;
+
+		// create a new hash region and add it to the tree
+		if(FindKey(lookup.Key, position) && (mHashPositions[position] != DNA_HASH_NON_UNIQUE_KEY)) {
+			HashRegion island;
+			island.Begin         = mHashPositions[position];
+			island.End           = mHashPositions[position] + mHashSize - 1;
+			island.QueryBegin    = lookup.QueryPosition;
+			island.QueryEnd      = lookup.QueryPosition + mHashSize - 1;
+			hrt.Insert(island);
+		}
+	}
+}
+
 // runs when we need to resize the hash table
 void CDnaHash::Resize(void) {
 
@@ -32,6 +32,8 @@ public:
 	void Clear(void);
 	// retrieves the genome location of the fragment
 	void Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy);
+	// retrieves the genome locations of all of the fragments (in order of the lookups)
+	void GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt);
 	// returns statistics about the hash table
 	void GetStatistics(unsigned int& numUsedHashes, unsigned int& numUniqueHashes, unsigned int& numNonUniqueHashes, unsigned int& numUsedHashesCount, unsigned int& numUniqueHashesCount, unsigned int& numNonUniqueHashesCount, double& mean, double& stddev);
 	// dumps the contents of the hash table to standard output
@@ -42,6 +44,10 @@ public:
 	void RandomizeAndTrimHashPositions(unsigned short numHashPositions);
 
 private:
+	// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+	bool AttachSnapshotSections(const vector<HashSnapshotSection>& sections);
+	// retrieves the hash table arrays that are stored in a snapshot
+	bool GetSnapshotSections(vector<HashSnapshotSection>& sections);
 	// runs when we need to resize the hash table
 	void Resize(void);
 	// stores our hash positions
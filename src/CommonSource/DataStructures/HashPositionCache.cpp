@@ -0,0 +1,127 @@
+// ***************************************************************************
+// CHashPositionCache - caches the genome positions of recently used hashes.
+//                      The cache is split into independently locked shards
+//                      and uses the CLOCK algorithm to approximate LRU.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "HashPositionCache.h"
+
+// constructor
+CHashPositionCache::CHashPositionCache(const unsigned int maxSize)
+: mShardMask(0)
+, mShardCapacity(0)
+{
+	// use the largest power of two that still leaves at least one entry per shard
+	unsigned int numShards = 1;
+	while(((numShards << 1) <= MAX_CACHE_SHARDS) && ((numShards << 1) <= maxSize)) numShards <<= 1;
+
+	mShardMask     = numShards - 1;
+	mShardCapacity = (maxSize + numShards - 1) / numShards;
+
+	mShards.resize(numShards);
+	for(vector<CacheShard>::iterator sIter = mShards.begin(); sIter != mShards.end(); ++sIter) {
+		sIter->Entries.reserve(mShardCapacity);
+		pthread_mutex_init(&sIter->Mutex, NULL);
+	}
+}
+
+// destructor
+CHashPositionCache::~CHashPositionCache(void) {
+	for(vector<CacheShard>::iterator sIter = mShards.begin(); sIter != mShards.end(); ++sIter)
+		pthread_mutex_destroy(&sIter->Mutex);
+}
+
+// adds the hash regions of the cached key to the hash region tree, returns false if the key is not cached
+bool CHashPositionCache::Get(const uint64_t& key, const unsigned int queryPosition, const unsigned char hashSize, CHashRegionTree& hrt) {
+
+	CacheShard& shard = GetShard(key);
+	pthread_mutex_lock(&shard.Mutex);
+
+	unordered_map<uint64_t, unsigned int>::const_iterator lookupIter = shard.Lookup.find(key);
+
+	if(lookupIter == shard.Lookup.end()) {
+		shard.CacheMisses++;
+		pthread_mutex_unlock(&shard.Mutex);
+		return false;
+	}
+
+	// read the positions in place
+	CacheEntry& entry = shard.Entries[lookupIter->second];
+	entry.IsReferenced = true;
+	shard.CacheHits++;
+
+	const unsigned int numPositions = (unsigned int)entry.Positions.size();
+	for(unsigned int i = 0; i < numPositions; i++) {
+		HashRegion island;
+		island.Begin      = entry.Positions[i];
+		island.End        = entry.Positions[i] + hashSize - 1;
+		island.QueryBegin = queryPosition;
+		island.QueryEnd   = queryPosition + hashSize - 1;
+		hrt.Insert(island);
+	}
+
+	pthread_mutex_unlock(&shard.Mutex);
+	return true;
+}
+
+// retrieves the cache statistics (summed over all shards)
+void CHashPositionCache::GetStatistics(uint64_t& cacheHits, uint64_t& cacheMisses) const {
+	cacheHits   = 0;
+	cacheMisses = 0;
+
+	for(vector<CacheShard>::const_iterator sIter = mShards.begin(); sIter != mShards.end(); ++sIter) {
+		cacheHits   += sIter->CacheHits;
+		cacheMisses += sIter->CacheMisses;
+	}
+}
+
+// stores the hash positions of the specified key
+void CHashPositionCache::Insert(const uint64_t& key, const unsigned int* pPositions, const unsigned int numPositions) {
+
+	if(mShardCapacity == 0) return;
+
+	CacheShard& shard = GetShard(key);
+	pthread_mutex_lock(&shard.Mutex);
+
+	// another thread may have already added this key
+	if(shard.Lookup.find(key) != shard.Lookup.end()) {
+		pthread_mutex_unlock(&shard.Mutex);
+		return;
+	}
+
+	unsigned int entryIndex = 0;
+
+	if(shard.Entries.size() < mShardCapacity) {
+
+		// use a new entry while the shard is still filling up
+		entryIndex = (unsigned int)shard.Entries.size();
+		shard.Entries.resize(entryIndex + 1);
+
+	} else {
+
+		// advance the clock hand until we find an entry that wasn't referenced recently
+		while(shard.Entries[shard.ClockHand].IsReferenced) {
+			shard.Entries[shard.ClockHand].IsReferenced = false;
+			shard.ClockHand = (shard.ClockHand + 1) % mShardCapacity;
+		}
+
+		entryIndex = shard.ClockHand;
+		shard.ClockHand = (shard.ClockHand + 1) % mShardCapacity;
+		shard.Lookup.erase(shard.Entries[entryIndex].Key);
+	}
+
+	// the evicted entry's vector keeps its capacity, so this rarely allocates
+	CacheEntry& entry = shard.Entries[entryIndex];
+	entry.Key          = key;
+	entry.IsReferenced = false;
+	entry.Positions.assign(pPositions, pPositions + numPositions);
+	shard.Lookup[key] = entryIndex;
+
+	pthread_mutex_unlock(&shard.Mutex);
+}
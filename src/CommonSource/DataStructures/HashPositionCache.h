@@ -0,0 +1,81 @@
+// ***************************************************************************
+// CHashPositionCache - caches the genome positions of recently used hashes.
+//                      The cache is split into independently locked shards
+//                      and uses the CLOCK algorithm to approximate LRU.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <vector>
+#include "HashRegionTree.h"
+#include "Mosaik.h"
+#include "PosixThreads.h"
+#include "UnorderedMap.h"
+
+using namespace std;
+using namespace AVLTree;
+
+// the maximum number of cache shards (must be a power of two)
+#define MAX_CACHE_SHARDS 256
+
+class CHashPositionCache {
+public:
+	// constructor
+	CHashPositionCache(const unsigned int maxSize);
+	// destructor
+	~CHashPositionCache(void);
+	// adds the hash regions of the cached key to the hash region tree, returns false if the key is not cached
+	bool Get(const uint64_t& key, const unsigned int queryPosition, const unsigned char hashSize, CHashRegionTree& hrt);
+	// retrieves the cache statistics (summed over all shards)
+	void GetStatistics(uint64_t& cacheHits, uint64_t& cacheMisses) const;
+	// stores the hash positions of the specified key
+	void Insert(const uint64_t& key, const unsigned int* pPositions, const unsigned int numPositions);
+
+private:
+	// stores the hash positions for one key
+	struct CacheEntry {
+		uint64_t Key;
+		vector<unsigned int> Positions;
+		bool IsReferenced;
+
+		CacheEntry(void)
+			: Key(0)
+			, IsReferenced(false)
+		{}
+	};
+	// stores a subset of the cached keys
+	struct CacheShard {
+		vector<CacheEntry> Entries;
+		unordered_map<uint64_t, unsigned int> Lookup;
+		unsigned int ClockHand;
+		uint64_t CacheHits;
+		uint64_t CacheMisses;
+		pthread_mutex_t Mutex;
+
+		CacheShard(void)
+			: ClockHand(0)
+			, CacheHits(0)
+			, CacheMisses(0)
+		{}
+	};
+	// returns the shard responsible for the specified key
+	inline CacheShard& GetShard(const uint64_t& key);
+	// our cache shards
+	vector<CacheShard> mShards;
+	unsigned int mShardMask;
+	// the maximum number of entries per shard
+	unsigned int mShardCapacity;
+};
+
+// returns the shard responsible for the specified key
+inline CHashPositionCache::CacheShard& CHashPositionCache::GetShard(const uint64_t& key) {
+	// neighboring k-mers differ in their low bits, so we mix the key first
+	const uint64_t mixedKey = key * 0x9E3779B97F4A7C15ULL;
+	return mShards[(unsigned int)(mixedKey >> 40) & mShardMask];
+}
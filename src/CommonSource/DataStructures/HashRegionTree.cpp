@@ -21,52 +21,30 @@ namespace AVLTree {
 	, mHashSize(hashSize)
 	, mIndelSize(3)
 	, mCount(0)
+	, mNumNodes(0)
+	, mUseDiagonalSort(false)
+	, mIsConsolidated(false)
+	, mRegionIndex(0)
 	{}
 
 	CHashRegionTree::~CHashRegionTree() {
-		Clear();
+		for(vector<HashRegionAvlNode*>::iterator bIter = mNodeBlocks.begin(); bIter != mNodeBlocks.end(); ++bIter)
+			::operator delete(*bIter);
 	}
 
-	// clears the tree
+	// clears the tree (the allocated nodes are kept for the next read)
 	void CHashRegionTree::Clear() {
-
-		// nothing to traverse
-		if(mRoot == NULL) return;
-
-		HashRegionAvlNode* n = mRoot;
-		HashRegionAvlNode* d = NULL;
-
-		// find the minimum leftmost level
-		while(n->Left  != NULL) n = n->Left;
-		while(n->Right != NULL) n = n->Right;
-
-		do {
-
-			// create a pointer to our delete node
-			d = n;
-
-			if(n->Parent == NULL) {
-				delete d;
-				break;
-
-			// Next in order will be our parent's right child's leftmost child
-			} else if((n->Parent->Right != NULL) && (n->Parent->Right != n)) {
-
-				n = n->Parent->Right;
-				while(n->Left  != NULL) n = n->Left;
-				while(n->Right != NULL) n = n->Right;
-				delete d;
-			
-			} else {
-				n = n->Parent;
-				delete d;
-			}
-
-		} while(n != NULL);
-
-		// reset the counter and root pointer
-		mRoot = NULL;
-		mCount = 0;
+		mRoot     = NULL;
+		mTraverse = NULL;
+		mCount    = 0;
+		mNumNodes = 0;
+
+		if(mUseDiagonalSort) {
+			mSeedConsolidator.Clear();
+			mRegions.clear();
+			mRegionIndex    = 0;
+			mIsConsolidated = false;
+		}
 	}
 
 	// overload the cout operator
@@ -81,6 +59,13 @@ namespace AVLTree {
 		// DEBUG
 		unsigned int level = 0;
 
+		if(mUseDiagonalSort) {
+			ConsolidateSeeds();
+			for(vector<HashRegion>::const_iterator rIter = mRegions.begin(); rIter != mRegions.end(); ++rIter)
+				cout << *rIter << endl;
+			return;
+		}
+
 		// nothing to traverse
 		if(mRoot == NULL) return;
 
@@ -138,17 +123,29 @@ namespace AVLTree {
 
 	// returns the current size of the tree
 	unsigned int CHashRegionTree::GetCount() {
+		if(mUseDiagonalSort) {
+			ConsolidateSeeds();
+			return (unsigned int)mRegions.size();
+		}
+
 		return mCount;
 	}
 
 	// gets the current hash region at the traversal pointer
 	HashRegion* CHashRegionTree::GetTraversalHashRegion() {
+		if(mUseDiagonalSort) return (mRegionIndex < mRegions.size() ? &mRegions[mRegionIndex] : NULL);
 		return &mTraverse->Data;
 	}
 
 	// go to the first entry
 	void CHashRegionTree::GotoFirstEntry() {
 
+		if(mUseDiagonalSort) {
+			ConsolidateSeeds();
+			mRegionIndex = 0;
+			return;
+		}
+
 		// empty tree
 		if(mRoot == NULL) return;
 
@@ -162,6 +159,12 @@ namespace AVLTree {
 	// go to the last entry
 	void CHashRegionTree::GotoLastEntry() {
 
+		if(mUseDiagonalSort) {
+			ConsolidateSeeds();
+			mRegionIndex = (mRegions.empty() ? 0 : (unsigned int)mRegions.size() - 1);
+			return;
+		}
+
 		// empty tree
 		if(mRoot == NULL) return;
 
@@ -174,7 +177,13 @@ namespace AVLTree {
 
 	// find the next entry
 	bool CHashRegionTree::GetNextEntry() {
-		
+
+		if(mUseDiagonalSort) {
+			if(mRegionIndex >= mRegions.size()) return false;
+			mRegionIndex++;
+			return true;
+		}
+
 		// return if our traversal pointer is NULL
 		if(!mTraverse) return false;
 
@@ -214,7 +223,14 @@ namespace AVLTree {
 
 	// find the previous entry
 	bool CHashRegionTree::GetPreviousEntry(HashRegion& key) {
-		
+
+		if(mUseDiagonalSort) {
+			if(mRegionIndex >= mRegions.size()) return false;
+			key = mRegions[mRegionIndex];
+			mRegionIndex = (mRegionIndex == 0 ? (unsigned int)mRegions.size() : mRegionIndex - 1);
+			return true;
+		}
+
 		// return if our traversal pointer is NULL
 		if(mTraverse == NULL) return false;
 
@@ -286,6 +302,13 @@ namespace AVLTree {
 	// update the tree
 	void CHashRegionTree::Insert(HashRegion& key) {
 
+		// collect the hash hit and consolidate once the traversal starts
+		if(mUseDiagonalSort) {
+			mSeedConsolidator.Add(key);
+			mIsConsolidated = false;
+			return;
+		}
+
 		// A1. Initialization
 		HashRegionAvlNode* n = mRoot;
 		HashRegionAvlNode* p = NULL;
@@ -308,7 +331,7 @@ namespace AVLTree {
 
 		// A3. Insert
 		mCount++;
-		n = new HashRegionAvlNode(key, p);
+		n = AllocateNode(key, p);
 
 		if(p) {
 		
@@ -400,8 +423,8 @@ namespace AVLTree {
 				if(isLeftChild) p->Left = NULL;
 					else p->Right = NULL;
 
-				// delete the candidate node
-				delete n;
+				// return the candidate node (always the most recently allocated one)
+				mNumNodes--;
 
 				// decrement the count
 				mCount--;
@@ -497,6 +520,11 @@ namespace AVLTree {
 		l->Balance = l->Balance + (1 + MAX(n->Balance, 0));
 	}
 
+	// consolidates the hash hits by sorting them by diagonal instead of using the AVL tree
+	void CHashRegionTree::EnableDiagonalSeedSorting(void) {
+		mUseDiagonalSort = true;
+	}
+
 	// sets the expected query length
 	void CHashRegionTree::SetExpectedQueryLength(unsigned int queryLen) {
 		mQueryLength = queryLen;
@@ -11,6 +11,9 @@
 #pragma once
 
 #include <iostream>
+#include <new>
+#include <vector>
+#include "DiagonalSeedConsolidator.h"
 #include "HashRegion.h"
 
 using namespace std;
@@ -20,6 +23,9 @@ using namespace std;
 
 #define HASH_SIZE 10
 
+// the number of tree nodes allocated at once
+#define HASH_REGION_NODE_BLOCK_SIZE 1024
+
 namespace AVLTree {
 
 	struct HashRegionAvlNode {
@@ -42,10 +48,12 @@ namespace AVLTree {
 	public:
 		CHashRegionTree(unsigned int queryLen, unsigned char hashSize);
 		~CHashRegionTree();
-		// clears the tree
+		// clears the tree (the allocated nodes are kept for the next read)
 		void Clear();
 		// dumps the tree in sorted order
 		void DumpTree();
+		// consolidates the hash hits by sorting them by diagonal instead of using the AVL tree
+		void EnableDiagonalSeedSorting(void);
 		// go to the first entry
 		void GotoFirstEntry();
 		// go to the last entry
@@ -63,6 +71,8 @@ namespace AVLTree {
 		// sets the expected query length
 		void SetExpectedQueryLength(unsigned int queryLen);
 	private:
+		// returns a new node from our node blocks
+		inline HashRegionAvlNode* AllocateNode(HashRegion& data, HashRegionAvlNode* parent);
 		// our tree root
 		HashRegionAvlNode* mRoot;
 		// our traversal pointer root
@@ -79,11 +89,43 @@ namespace AVLTree {
 		unsigned char mIndelSize;
 		// the current element count
 		unsigned int mCount;
+		// our node blocks
+		vector<HashRegionAvlNode*> mNodeBlocks;
+		unsigned int mNumNodes;
 		// rotates a given node left
 		void LeftRotate(HashRegionAvlNode* n);
 		// rotates a given node right
 		void RightRotate(HashRegionAvlNode* n);
 		// moves on to the previous element in the tree
 		void MoveToPreviousEntry();
+		// converts the collected hash hits into hash regions (diagonal sorting only)
+		inline void ConsolidateSeeds(void);
+		// toggles the diagonal seed sorting
+		bool mUseDiagonalSort;
+		bool mIsConsolidated;
+		// our diagonal seed consolidator and the resulting hash regions
+		CDiagonalSeedConsolidator mSeedConsolidator;
+		vector<HashRegion> mRegions;
+		unsigned int mRegionIndex;
 	};
+
+	// converts the collected hash hits into hash regions (diagonal sorting only)
+	inline void CHashRegionTree::ConsolidateSeeds(void) {
+		if(mIsConsolidated) return;
+		mSeedConsolidator.Consolidate(mQueryLength, mHashSize, mIndelSize, mRegions);
+		mIsConsolidated = true;
+	}
+
+	// returns a new node from our node blocks
+	inline HashRegionAvlNode* CHashRegionTree::AllocateNode(HashRegion& data, HashRegionAvlNode* parent) {
+
+		const unsigned int blockIndex = mNumNodes / HASH_REGION_NODE_BLOCK_SIZE;
+		const unsigned int nodeIndex  = mNumNodes % HASH_REGION_NODE_BLOCK_SIZE;
+
+		if(blockIndex == mNodeBlocks.size())
+			mNodeBlocks.push_back((HashRegionAvlNode*)::operator new(HASH_REGION_NODE_BLOCK_SIZE * sizeof(HashRegionAvlNode)));
+
+		mNumNodes++;
+		return new(mNodeBlocks[blockIndex] + nodeIndex) HashRegionAvlNode(data, parent);
+	}
 }
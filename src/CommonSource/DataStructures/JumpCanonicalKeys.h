@@ -0,0 +1,107 @@
+// ***************************************************************************
+// CJumpCanonicalKeys - maps canonical keys onto the dense key directory.
+//                      A key and its reverse complement share one slot, so
+//                      the directory holds about half of the 4^k keys.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include "Mosaik.h"
+
+using namespace std;
+
+// the number of middle dinucleotides that differ from their reverse complement, counting each pair once
+#define JUMP_CANONICAL_NUM_MIDDLE_PAIRS 6
+
+class CJumpCanonicalKeys {
+public:
+	// returns the number of directory slots used by the specified hash size
+	static inline uint64_t GetNumKeys(unsigned char hashSize);
+	// returns the directory slot shared by the key and its reverse complement
+	static inline uint64_t GetRank(uint64_t key, unsigned char hashSize);
+private:
+	// returns the reverse complement of the key
+	static inline uint64_t GetReverseComplement(uint64_t key, const unsigned char hashSize);
+};
+
+// returns the number of directory slots used by the specified hash size
+inline uint64_t CJumpCanonicalKeys::GetNumKeys(unsigned char hashSize) {
+
+	// odd hash sizes have no palindromes: exactly half of the keys
+	if((hashSize & 1) == 1) return (uint64_t)1 << (2 * hashSize - 1);
+
+	// even hash sizes add one slot for each palindrome
+	uint64_t numKeys = 1;
+	for(unsigned char s = 2; s <= hashSize; s += 2)
+		numKeys = ((uint64_t)JUMP_CANONICAL_NUM_MIDDLE_PAIRS << (2 * (s - 2))) + 4 * numKeys;
+
+	return numKeys;
+}
+
+// returns the directory slot shared by the key and its reverse complement
+inline uint64_t CJumpCanonicalKeys::GetRank(uint64_t key, unsigned char hashSize) {
+
+	// the slot of each middle dinucleotide: the six pairs first, then the four palindromes (AT, CG, GC, TA)
+	static const unsigned char middleRanks[16] = { 0, 1, 2, 0, 3, 4, 1, 0, 5, 2, 0, 0, 3, 0, 0, 0 };
+
+	uint64_t rank = 0;
+
+	while(hashSize > 0) {
+
+		const unsigned char sideBits = 2 * (hashSize / 2);
+
+		// odd hash sizes: use the strand whose middle base is A or C and drop the middle base's high bit
+		if((hashSize & 1) == 1) {
+			uint64_t middle = (key >> sideBits) & 3;
+			if(middle > 1) {
+				key    = GetReverseComplement(key, hashSize);
+				middle = 3 - middle;
+			}
+
+			const uint64_t sideMask = ((uint64_t)1 << sideBits) - 1;
+			return rank + ((((key >> (sideBits + 2)) << 1) | middle) << sideBits) + (key & sideMask);
+		}
+
+		// even hash sizes: use the strand with the smaller middle dinucleotide
+		const unsigned char outerBits = sideBits - 2;
+		const uint64_t outerMask = ((uint64_t)1 << outerBits) - 1;
+
+		uint64_t middle = (key >> outerBits) & 15;
+		const uint64_t reverseMiddle = ((3 - (middle & 3)) << 2) | (3 - (middle >> 2));
+
+		if(middle != reverseMiddle) {
+			if(middle > reverseMiddle) {
+				key    = GetReverseComplement(key, hashSize);
+				middle = reverseMiddle;
+			}
+
+			const uint64_t outer = ((key >> (outerBits + 4)) << outerBits) | (key & outerMask);
+			return rank + ((uint64_t)middleRanks[middle] << (2 * outerBits)) + outer;
+		}
+
+		// palindromic middles leave the outer bases, which are ranked as a shorter canonical key
+		hashSize -= 2;
+		rank += ((uint64_t)JUMP_CANONICAL_NUM_MIDDLE_PAIRS << (2 * outerBits)) + middleRanks[middle] * GetNumKeys(hashSize);
+		key = ((key >> (outerBits + 4)) << outerBits) | (key & outerMask);
+	}
+
+	return rank;
+}
+
+// returns the reverse complement of the key
+inline uint64_t CJumpCanonicalKeys::GetReverseComplement(uint64_t key, const unsigned char hashSize) {
+
+	uint64_t reverseKey = 0;
+	for(unsigned char i = 0; i < hashSize; i++) {
+		reverseKey = (reverseKey << 2) | (3 - (key & 3));
+		key >>= 2;
+	}
+
+	return reverseKey;
+}
@@ -13,12 +13,18 @@
 #include "JumpDnaHash.h"
 
 // constructor
-CJumpDnaHash::CJumpDnaHash(const unsigned char hashSize, const string& filenameStub, const unsigned short numPositions, const bool keepKeysInMemory, const bool keepPositionsInMemory, const unsigned int numCachedElements)
+CJumpDnaHash::CJumpDnaHash(const unsigned char hashSize, const string& filenameStub, const unsigned short numPositions, const bool keepKeysInMemory, const bool keepPositionsInMemory, const unsigned int numCachedElements, const bool useMemoryMap, const bool prefetchMemoryMap)
 : mNumPositions(numPositions)
+, mFormatVersion(JUMP_FORMAT_VERSION_1)
 , mLimitPositions(false)
 , mKeepKeysInMemory(keepKeysInMemory)
 , mKeepPositionsInMemory(keepPositionsInMemory)
 , mUseCache(false)
+, mUseMemoryMap(false)
+, mUseSparseKeys(false)
+, mIsCanonical(false)
+, mUseCanonicalRanks(false)
+, mUseKmerFilter(false)
 , mKeys(NULL)
 , mPositions(NULL)
 , mBuffer(NULL)
@@ -26,10 +32,12 @@ CJumpDnaHash::CJumpDnaHash(const unsigned char hashSize, const string& filenameS
 , mKeyBuffer(NULL)
 , mKeyBufferLen(0)
 , mKeyBufferPtr(0)
+, mSparseLowBits(0)
+, mSparseRecordsOffset(0)
 , mPositionBuffer(NULL)
 , mPositionBufferLen(0)
 , mPositionBufferPtr(0)
-, mMruCache(numCachedElements)
+, mHashPositionCache(numCachedElements)
 {
 	mHashSize = hashSize;
 
@@ -79,16 +87,59 @@ CJumpDnaHash::CJumpDnaHash(const unsigned char hashSize, const string& filenameS
 		exit(1);
 	}
 
+	// check the format version (version 1 databases only store the hash size)
+	const int formatVersion = fgetc(mMeta);
+	if(formatVersion != EOF) mFormatVersion = (unsigned char)formatVersion;
+
+	if((mFormatVersion < JUMP_FORMAT_VERSION_1) || (mFormatVersion > JUMP_FORMAT_VERSION_3)) {
+		cout << "ERROR: The jump database uses an unknown format version (" << (short)mFormatVersion << "). Please create the jump database with this version of MosaikJump." << endl;
+		exit(1);
+	}
+
+	// check the key directory type (older databases always use dense keys)
+	const int keysType = fgetc(mMeta);
+	if(keysType == JUMP_KEYS_SPARSE) mUseSparseKeys = true;
+	else if((keysType != EOF) && (keysType != JUMP_KEYS_DENSE)) {
+		cout << "ERROR: The jump database uses an unknown key directory type (" << keysType << "). Please create the jump database with this version of MosaikJump." << endl;
+		exit(1);
+	}
+
+	// check the strand layout (older databases only store forward strand keys)
+	const int strands = fgetc(mMeta);
+	if(strands == JUMP_STRANDS_CANONICAL) mIsCanonical = true;
+	else if(strands == JUMP_STRANDS_CANONICAL_RANKED) {
+		mIsCanonical       = true;
+		mUseCanonicalRanks = true;
+	} else if((strands != EOF) && (strands != JUMP_STRANDS_FORWARD)) {
+		cout << "ERROR: The jump database uses an unknown strand layout (" << strands << "). Please create the jump database with this version of MosaikJump." << endl;
+		exit(1);
+	}
+
+	// read the subsample caps (older databases store complete lists only)
+	const int numSubsampleCaps = fgetc(mMeta);
+	if((numSubsampleCaps != EOF) && (numSubsampleCaps > 0)) {
+		mSubsampleCaps.resize(numSubsampleCaps);
+		if(fread((char*)&mSubsampleCaps[0], SIZEOF_INT, numSubsampleCaps, mMeta) != (size_t)numSubsampleCaps) {
+			cout << "ERROR: The metadata file (" << metaFilename << ") is truncated." << endl;
+			exit(1);
+		}
+	}
+
 	// close the metadata file
 	fclose(mMeta);
 
+	if(mUseSparseKeys) ReadSparseKeysHeader(keysFilename);
+
 	// place the keys and positions in memory
-	if(keepKeysInMemory)      LoadKeys();
-	if(keepPositionsInMemory) LoadPositions();
+	if(useMemoryMap) MapFiles(prefetchMemoryMap);
+	else {
+		if(keepKeysInMemory)      LoadKeys();
+		if(keepPositionsInMemory) LoadPositions();
+	}
 
 	// activate the MRU cache
 	if(numCachedElements > 0) mUseCache = true;
-	if(keepKeysInMemory && keepPositionsInMemory) mUseCache = false;
+	if(mKeepKeysInMemory && mKeepPositionsInMemory) mUseCache = false;
 
 	// limit the number of hash positions
 	if(numPositions > 0) RandomizeAndTrimHashPositions(numPositions);
@@ -119,16 +170,34 @@ void CJumpDnaHash::Dump() {
 
 // close the jump database
 void CJumpDnaHash::FreeMemory(void) {
-	if(mBuffer)         delete [] mBuffer;
-	if(mKeyBuffer)      delete [] mKeyBuffer;
-	if(mPositionBuffer) delete [] mPositionBuffer;
+	if(mBuffer) delete [] mBuffer;
+
+#ifndef WIN32
+	if(mUseMemoryMap) {
+		if(mKeyBuffer)      munmap(mKeyBuffer, (size_t)mKeyBufferLen);
+		if(mPositionBuffer) munmap(mPositionBuffer, (size_t)mPositionBufferLen);
+	} else {
+#endif
+		if(mKeyBuffer)      delete [] mKeyBuffer;
+		if(mPositionBuffer) delete [] mPositionBuffer;
+#ifndef WIN32
+	}
+#endif
+
+	mBuffer           = NULL;
+	mKeyBuffer        = NULL;
+	mPositionBuffer   = NULL;
+	mMemoryAllocated  = false;
 }
 
 // retrieves the genome location of the fragment
 void CJumpDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy) {
 
-	// find the correct position in the keys database
-	const off_type offset = key * KEY_LENGTH;
+	if(mIsCanonical) {
+		cout << "ERROR: Canonical jump databases can only be queried with canonical lookups." << endl;
+		exit(1);
+	}
+
 	off_type position = 0;
 
 	// initialize the mhp occupancy
@@ -138,43 +207,21 @@ void CJumpDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, C
 	// check the MRU cache
 	// ===================
 
-	if(mUseCache) {
-		vector<unsigned int> positionVector;
-
-		pthread_mutex_lock(&mJumpCacheMutex);
-		bool isCached = mMruCache.Get(key, positionVector);
-		pthread_mutex_unlock(&mJumpCacheMutex);
-
-		// TODO: handle the mhp occupancy. How do we get the mhp occupancy when using the cache?
-
-		if(isCached) {
-			for(unsigned int i = 0; i < positionVector.size(); i++) {
-				HashRegion island;
-				island.Begin      = positionVector[i];
-				island.End        = positionVector[i] + mHashSize - 1;
-				island.QueryBegin = queryPosition;
-				island.QueryEnd   = queryPosition + mHashSize - 1;
-				hrt.Insert(island);
-			}
-			return;
-		}
+	// skip over-represented k-mers before touching the keys or positions (none of their positions are used)
+	if(IsFrequentKey(key)) {
+		mhpOccupancy = 0.0;
+		return;
 	}
 
+	// TODO: handle the mhp occupancy. How do we get the mhp occupancy when using the cache?
+	if(mUseCache && mHashPositionCache.Get(key, queryPosition, mHashSize, hrt)) return;
+
 	// ==========================
 	// retrieve the file position
 	// ==========================
 
-	if(mKeepKeysInMemory) {
-		memcpy((char*)&position, (char*)(mKeyBufferPtr + offset), KEY_LENGTH);
-	} else {
-		pthread_mutex_lock(&mJumpKeyMutex);
-		fseek64(mKeys, offset, SEEK_SET);
-		fread((char*)&position, KEY_LENGTH, 1, mKeys);
-		pthread_mutex_unlock(&mJumpKeyMutex);
-	}
-
 	// return if the key is undefined
-	if(position == 0xffffffffffULL) return;
+	if(!GetKeyOffset(key, position)) return;
 
 	if((uint64_t)position > mPositionBufferLen) {
 		cout << "ERROR: A position (" << position << ") was specified that is larger than the jump positions database (" << mPositionBufferLen << ")." << endl;
@@ -185,6 +232,11 @@ void CJumpDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, C
 	// retrieve the hash positions
 	// ===========================
 
+	if(mFormatVersion >= JUMP_FORMAT_VERSION_2) {
+		GetEncodedPositions(key, position, queryPosition, hrt, mhpOccupancy);
+		return;
+	}
+
 	if(mKeepPositionsInMemory) {
 
 		char* pPositions = (char*)(mPositionBufferPtr + position);
@@ -224,7 +276,6 @@ void CJumpDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, C
 		CMemoryUtilities::CheckBufferSize(mBuffer, mBufferLen, entrySize);
 
 		fread(mBuffer, entrySize, 1, mPositions);
-		pthread_mutex_unlock(&mJumpPositionMutex);
 
 		// set the mhp occupancy
 		if(mLimitPositions && (numPositions > mMaxHashPositions)) {
@@ -252,17 +303,321 @@ void CJumpDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition, C
 			hrt.Insert(island);
 		}
 
-		if(mUseCache) {
-			pthread_mutex_lock(&mJumpCacheMutex);
-			mMruCache.Insert(key, positionVector);
-			pthread_mutex_unlock(&mJumpCacheMutex);
+		// the position buffer is shared between the alignment threads
+		pthread_mutex_unlock(&mJumpPositionMutex);
+
+		if(mUseCache) mHashPositionCache.Insert(key, (positionVector.empty() ? NULL : &positionVector[0]), numPositions);
+	}
+}
+
+// retrieves the delta-encoded hash positions from a version 2 or 3 jump database
+void CJumpDnaHash::GetEncodedPositions(const uint64_t& key, const off_type position, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy) {
+
+	vector<unsigned int> positions;
+	ReadPositionLists(position, &positions, &mhpOccupancy);
+	InsertHashPositions(key, positions, queryPosition, hrt);
+}
+
+// retrieves the genome locations of both strands with one canonical lookup per fragment
+void CJumpDnaHash::GetCanonicalBatch(vector<HashLookup>& lookups, CHashRegionTree& forwardHrt, CHashRegionTree& reverseHrt) {
+
+	const unsigned int numLookups = (unsigned int)lookups.size();
+
+	// keeps the reverse strand positions until they can be inserted in ascending query order
+	vector<vector<unsigned int> > reversePositions(numLookups);
+	vector<double> reverseMhpOccupancies(numLookups, 1.0);
+	vector<bool> hasReversePositions(numLookups, false);
+	vector<bool> isReverseFrequent(numLookups, false);
+
+	// the first list contains the positions of the canonical key, the second list the positions of its reverse complement
+	vector<unsigned int> strandPositions[2];
+	double strandMhpOccupancies[2];
+
+	// ===================================
+	// retrieve the forward strand windows
+	// ===================================
+
+	for(unsigned int i = 0; i < numLookups; i++) {
+
+		HashLookup& lookup = lookups[i];
+		lookup.MhpOccupancy        = 1.0;
+		lookup.ReverseMhpOccupancy = 1.0;
+
+		// skip over-represented k-mers on both strands before touching the keys or positions
+		const uint64_t canonicalKey = GetCanonicalKey(lookup.Key);
+		if(IsFrequentKey(canonicalKey)) {
+			lookup.MhpOccupancy = 0.0;
+			if(GetCanonicalKey(lookup.ReverseKey) == canonicalKey) isReverseFrequent[i] = true;
+			continue;
+		}
+
+		// the cache stores the positions of the strand-specific keys
+		if(mUseCache && mHashPositionCache.Get(lookup.Key, lookup.QueryPosition, mHashSize, forwardHrt)) continue;
+
+		if(!GetCanonicalPositions(canonicalKey, strandPositions, strandMhpOccupancies)) continue;
+
+		const unsigned char strand = (lookup.Key == canonicalKey ? 0 : 1);
+		lookup.MhpOccupancy = strandMhpOccupancies[strand];
+		InsertHashPositions(lookup.Key, strandPositions[strand], lookup.QueryPosition, forwardHrt);
+
+		// both strands normally share one canonical key (reads with ambiguity codes may need two lookups)
+		if(GetCanonicalKey(lookup.ReverseKey) == canonicalKey) {
+			const unsigned char reverseStrand = (lookup.ReverseKey == canonicalKey ? 0 : 1);
+			reversePositions[i].swap(strandPositions[reverseStrand]);
+			reverseMhpOccupancies[i] = strandMhpOccupancies[reverseStrand];
+			hasReversePositions[i]   = true;
 		}
 	}
+
+	// ====================================================================
+	// retrieve the reverse strand windows (ascending reverse query order)
+	// ====================================================================
+
+	for(unsigned int i = numLookups; i > 0; i--) {
+
+		HashLookup& lookup = lookups[i - 1];
+
+		if(isReverseFrequent[i - 1] || (!hasReversePositions[i - 1] && IsFrequentKey(GetCanonicalKey(lookup.ReverseKey)))) {
+			lookup.ReverseMhpOccupancy = 0.0;
+			continue;
+		}
+
+		if(mUseCache && mHashPositionCache.Get(lookup.ReverseKey, lookup.ReverseQueryPosition, mHashSize, reverseHrt)) continue;
+
+		if(!hasReversePositions[i - 1]) {
+			const uint64_t canonicalKey = GetCanonicalKey(lookup.ReverseKey);
+			if(!GetCanonicalPositions(canonicalKey, strandPositions, strandMhpOccupancies)) continue;
+
+			const unsigned char reverseStrand = (lookup.ReverseKey == canonicalKey ? 0 : 1);
+			reversePositions[i - 1].swap(strandPositions[reverseStrand]);
+			reverseMhpOccupancies[i - 1] = strandMhpOccupancies[reverseStrand];
+		}
+
+		lookup.ReverseMhpOccupancy = reverseMhpOccupancies[i - 1];
+		InsertHashPositions(lookup.ReverseKey, reversePositions[i - 1], lookup.ReverseQueryPosition, reverseHrt);
+	}
+}
+
+// retrieves the strand position lists stored with the canonical key, returns false if the key is undefined
+bool CJumpDnaHash::GetCanonicalPositions(const uint64_t& canonicalKey, vector<unsigned int>* pStrandPositions, double* pMhpOccupancies) {
+
+	off_type position = 0;
+	if(!GetKeyOffset(canonicalKey, position)) return false;
+
+	if((uint64_t)position > mPositionBufferLen) {
+		cout << "ERROR: A position (" << position << ") was specified that is larger than the jump positions database (" << mPositionBufferLen << ")." << endl;
+		exit(1);
+	}
+
+	ReadPositionLists(position, pStrandPositions, pMhpOccupancies);
+
+	return true;
+}
+
+// returns the number of positions that have to be decoded to use the specified number of positions
+unsigned int CJumpDnaHash::GetNumDecodedPositions(const unsigned int numStoredPositions, const unsigned int numUsedPositions) const {
+
+	// without subsample tiers the subset can only be picked from the whole list
+	if(mSubsampleCaps.empty()) return numStoredPositions;
+
+	const unsigned int numPositions = (numUsedPositions < numStoredPositions ? numUsedPositions : numStoredPositions);
+
+	unsigned int tierEnd = 0;
+	while(tierEnd < numPositions) tierEnd = CJumpPositionCodec::GetTierEnd(mSubsampleCaps, tierEnd, numStoredPositions);
+
+	return tierEnd;
+}
+
+// decodes the hash positions that will be used from one strand's deltas and returns the number of bytes read
+// N.B. lists that hold every reference position in one tier are returned in the shuffled order of a version 1
+// database, which keeps the hash region insertion order (and the unique mode tie-breaks) of version 1 databases.
+// Lists split into tiers or truncated by MosaikJump are returned in reference order: restoring the shuffled order
+// would require replaying the build-time shuffle over every reference position.
+unsigned int CJumpDnaHash::DecodeStrandPositions(const unsigned char* pDeltas, const JumpListHeader& header, const unsigned int strand, vector<unsigned int>& positions, double& mhpOccupancy) {
+
+	const unsigned int numStoredPositions = header.NumPositions[strand];
+	unsigned int numUsedPositions = numStoredPositions;
+	if(mLimitPositions && (numUsedPositions > mMaxHashPositions)) numUsedPositions = mMaxHashPositions;
+
+	// the occupancy is based on the reference count, even when MosaikJump stored fewer positions
+	const unsigned int numReferencePositions = header.NumReferencePositions[strand];
+	mhpOccupancy = (numUsedPositions < numReferencePositions ? (double)numUsedPositions / (double)numReferencePositions : 1.0);
+
+	// decode the tiers that contain the used positions (the deltas restart at every tier)
+	const unsigned int numDecodedPositions = GetNumDecodedPositions(numStoredPositions, numUsedPositions);
+	positions.resize(numDecodedPositions);
+
+	unsigned int numBytes = 0, tierBegin = 0;
+
+	if(mSubsampleCaps.empty()) {
+		if(numDecodedPositions > 0) numBytes = CJumpPositionCodec::DecodePositions(pDeltas, numDecodedPositions, &positions[0]);
+	} else {
+		for(unsigned int tierEnd = 0; tierEnd < numDecodedPositions;) {
+			tierBegin = tierEnd;
+			tierEnd   = CJumpPositionCodec::GetTierEnd(mSubsampleCaps, tierBegin, numStoredPositions);
+			numBytes += CJumpPositionCodec::DecodePositions(pDeltas + numBytes, tierEnd - tierBegin, &positions[tierBegin]);
+		}
+	}
+
+	// MosaikJump picks its subset by shuffling the sorted positions, so we shuffle the last tier the same way
+	const bool hasVersion1Order = ((tierBegin == 0) && (numStoredPositions == numReferencePositions));
+	if(hasVersion1Order || (numUsedPositions < numDecodedPositions)) {
+		std::shuffle(positions.begin() + tierBegin, positions.end(), std::default_random_engine{});
+		positions.resize(numUsedPositions);
+	}
+
+	return numBytes;
+}
+
+// adds the hash positions to the hash region tree
+void CJumpDnaHash::InsertHashPositions(const uint64_t& key, const vector<unsigned int>& positions, const unsigned int& queryPosition, CHashRegionTree& hrt) {
+
+	const unsigned int numPositions = (unsigned int)positions.size();
+
+	for(unsigned int i = 0; i < numPositions; i++) {
+		HashRegion island;
+		island.Begin         = positions[i];
+		island.End           = positions[i] + mHashSize - 1;
+		island.QueryBegin    = queryPosition;
+		island.QueryEnd      = queryPosition + mHashSize - 1;
+		hrt.Insert(island);
+	}
+
+	if(mUseCache) mHashPositionCache.Insert(key, (numPositions == 0 ? NULL : &positions[0]), numPositions);
+}
+
+// decodes the position lists at the specified offset (canonical databases store the canonical key & its reverse complement)
+void CJumpDnaHash::ReadPositionLists(const off_type position, vector<unsigned int>* pStrandPositions, double* pMhpOccupancies) {
+
+	const unsigned int numStrands = (mIsCanonical ? 2 : 1);
+	JumpListHeader header;
+
+	if(mKeepPositionsInMemory) {
+
+		const unsigned char* pEntry = (const unsigned char*)(mPositionBufferPtr + position);
+		const unsigned char* pDeltas = pEntry + CJumpPositionCodec::DecodeListHeader(pEntry, mFormatVersion, mIsCanonical, header);
+
+		// version 2 canonical lists only reveal where the second strand starts once the first strand is decoded
+		for(unsigned int s = 0; s < numStrands; s++) {
+			const unsigned int numBytes = DecodeStrandPositions(pDeltas, header, s, pStrandPositions[s], pMhpOccupancies[s]);
+			pDeltas += (header.HasStrandLengths ? header.EncodedLength[s] : numBytes);
+		}
+
+		return;
+	}
+
+	pthread_mutex_lock(&mJumpPositionMutex);
+
+	// read the list header
+	fseek64(mPositions, position, SEEK_SET);
+	unsigned char headerBuffer[JUMP_MAX_LIST_HEADER_LENGTH + 1];
+	memset(headerBuffer, 0, JUMP_MAX_LIST_HEADER_LENGTH + 1);
+	fread((char*)headerBuffer, 1, JUMP_MAX_LIST_HEADER_LENGTH, mPositions);
+
+	off_type deltasOffset = position + CJumpPositionCodec::DecodeListHeader(headerBuffer, mFormatVersion, mIsCanonical, header);
+	const unsigned char* pDeltas = NULL;
+
+	for(unsigned int s = 0; s < numStrands; s++) {
+
+		// read the deltas of each strand (version 2 canonical lists are read at once)
+		if(header.HasStrandLengths || (s == 0)) {
+
+			// only read the tiers that will be decoded: a varint never exceeds JUMP_MAX_VARINT_LENGTH bytes
+			unsigned int numBytes = header.EncodedLength[s];
+			if(header.HasStrandLengths && mLimitPositions) {
+				const uint64_t maxBytes = (uint64_t)GetNumDecodedPositions(header.NumPositions[s], mMaxHashPositions) * JUMP_MAX_VARINT_LENGTH;
+				if(maxBytes < numBytes) numBytes = (unsigned int)maxBytes;
+			}
+
+			CMemoryUtilities::CheckBufferSize(mBuffer, mBufferLen, numBytes + JUMP_MAX_VARINT_LENGTH);
+			fseek64(mPositions, deltasOffset, SEEK_SET);
+			fread(mBuffer, numBytes, 1, mPositions);
+
+			deltasOffset += header.EncodedLength[s];
+			pDeltas = mBuffer;
+		}
+
+		pDeltas += DecodeStrandPositions(pDeltas, header, s, pStrandPositions[s], pMhpOccupancies[s]);
+	}
+
+	pthread_mutex_unlock(&mJumpPositionMutex);
+}
+
+// returns true if the jump database stores canonical keys
+bool CJumpDnaHash::IsCanonical(void) const {
+	return mIsCanonical;
+}
+
+// loads the filter of over-represented k-mers: their seeds are skipped with an mhp occupancy of zero
+void CJumpDnaHash::LoadKmerFilter(const string& filename) {
+	mKmerFilter.Load(filename);
+	mUseKmerFilter = true;
+	cout << "- skipping the seeds of k-mers with more than " << mKmerFilter.GetPositionThreshold() << " hash positions" << endl;
+}
+
+// retrieves the positions file offset of the key, returns false if the key is undefined
+bool CJumpDnaHash::GetKeyOffset(const uint64_t& key, off_type& position) {
+
+	if(mUseSparseKeys) return GetSparseKeyOffset(key, position);
+
+	// find the correct position in the keys database
+	const off_type offset = (mUseCanonicalRanks ? CJumpCanonicalKeys::GetRank(key, mHashSize) : key) * KEY_LENGTH;
+
+	if(mKeepKeysInMemory) {
+		memcpy((char*)&position, (char*)(mKeyBufferPtr + offset), KEY_LENGTH);
+	} else {
+		pthread_mutex_lock(&mJumpKeyMutex);
+		fseek64(mKeys, offset, SEEK_SET);
+		fread((char*)&position, KEY_LENGTH, 1, mKeys);
+		pthread_mutex_unlock(&mJumpKeyMutex);
+	}
+
+	return (position != 0xffffffffffULL);
+}
+
+// retrieves the positions file offset of the key from the sparse key directory, returns false if the key is undefined
+bool CJumpDnaHash::GetSparseKeyOffset(const uint64_t& key, off_type& position) {
+
+	const uint64_t bucket       = key >> mSparseLowBits;
+	const uint64_t lowKey       = key & (((uint64_t)1 << mSparseLowBits) - 1);
+	const unsigned char lowBytes = mSparseKeysHeader.LowBytes;
+	const unsigned int recordLength = CJumpSparseKeys::GetRecordLength(lowBytes);
+	const off_type directoryOffset = CJumpSparseKeys::GetDirectoryOffset() + bucket * SIZEOF_INT;
+
+	unsigned int range[2];
+
+	if(mKeepKeysInMemory) {
+
+		memcpy((char*)range, (char*)(mKeyBufferPtr + directoryOffset), 2 * SIZEOF_INT);
+		if(range[0] == range[1]) return false;
+
+		const unsigned char* pRecords = (const unsigned char*)(mKeyBufferPtr + mSparseRecordsOffset) + (uint64_t)range[0] * recordLength;
+		return CJumpSparseKeys::FindOffset(pRecords, range[1] - range[0], lowKey, lowBytes, position);
+	}
+
+	pthread_mutex_lock(&mJumpKeyMutex);
+
+	fseek64(mKeys, directoryOffset, SEEK_SET);
+	fread((char*)range, SIZEOF_INT, 2, mKeys);
+
+	bool foundKey = false;
+	if(range[0] != range[1]) {
+		const unsigned int numBytes = (range[1] - range[0]) * recordLength;
+		if(mSparseRecordBuffer.size() < numBytes) mSparseRecordBuffer.resize(numBytes);
+
+		fseek64(mKeys, mSparseRecordsOffset + (uint64_t)range[0] * recordLength, SEEK_SET);
+		fread((char*)&mSparseRecordBuffer[0], numBytes, 1, mKeys);
+		foundKey = CJumpSparseKeys::FindOffset(&mSparseRecordBuffer[0], range[1] - range[0], lowKey, lowBytes, position);
+	}
+
+	pthread_mutex_unlock(&mJumpKeyMutex);
+
+	return foundKey;
 }
 
 // returns the numbers of jump database cache hits and misses
 void CJumpDnaHash::GetCacheStatistics(uint64_t& cacheHits, uint64_t& cacheMisses) {
-	mMruCache.GetStatistics(cacheHits, cacheMisses);
+	mHashPositionCache.GetStatistics(cacheHits, cacheMisses);
 }
 
 // loads the keys database into memory
@@ -302,6 +657,32 @@ void CJumpDnaHash::LoadKeys(void) {
 	cout << "finished." << endl;
 }
 
+// reads and checks the header of a sparse keys file
+void CJumpDnaHash::ReadSparseKeysHeader(const string& keysFilename) {
+
+	memset((char*)&mSparseKeysHeader, 0, sizeof(JumpSparseKeysHeader));
+	fread((char*)&mSparseKeysHeader, sizeof(JumpSparseKeysHeader), 1, mKeys);
+	fseek64(mKeys, 0, SEEK_SET);
+
+	const unsigned char keyBits = mHashSize * 2;
+	const unsigned char directoryBits = mSparseKeysHeader.DirectoryBits;
+
+	if((memcmp(mSparseKeysHeader.Signature, JUMP_SPARSE_KEYS_SIGNATURE, JUMP_SPARSE_KEYS_SIGNATURE_LEN) != 0) ||
+		(directoryBits == 0) || (directoryBits > keyBits) || (directoryBits > JUMP_SPARSE_MAX_DIRECTORY_BITS)) {
+		cout << "ERROR: The keys file (" << keysFilename << ") does not contain a valid sparse key directory." << endl;
+		exit(1);
+	}
+
+	mSparseLowBits       = keyBits - directoryBits;
+	mSparseRecordsOffset = CJumpSparseKeys::GetRecordsOffset(directoryBits);
+
+	const uint64_t expectedLen = mSparseRecordsOffset + mSparseKeysHeader.NumKeys * CJumpSparseKeys::GetRecordLength(mSparseKeysHeader.LowBytes);
+	if((mSparseKeysHeader.LowBytes != ((mSparseLowBits + 7) / 8)) || (mKeyBufferLen != expectedLen)) {
+		cout << "ERROR: The keys file (" << keysFilename << ") is truncated or has an inconsistent sparse key directory." << endl;
+		exit(1);
+	}
+}
+
 // loads the positions database into memory
 void CJumpDnaHash::LoadPositions(void) {
 
@@ -339,6 +720,55 @@ void CJumpDnaHash::LoadPositions(void) {
 	cout << "finished." << endl;
 }
 
+// memory maps the keys and positions databases
+void CJumpDnaHash::MapFiles(const bool prefetch) {
+
+#ifdef WIN32
+	cout << "WARNING: Memory mapping the jump database is not supported on this platform. Loading the database into memory instead." << endl;
+	LoadKeys();
+	LoadPositions();
+#else
+	cout << "- memory mapping the jump database... ";
+	cout.flush();
+
+	mKeyBuffer         = MapFile(mKeys, mKeyBufferLen, prefetch, "keys");
+	mKeyBufferPtr      = (uintptr_t)mKeyBuffer;
+	mPositionBuffer    = MapFile(mPositions, mPositionBufferLen, prefetch, "positions");
+	mPositionBufferPtr = (uintptr_t)mPositionBuffer;
+	mUseMemoryMap      = true;
+
+	cout << "finished." << endl;
+#endif
+
+	// all lookups are now served from memory without locking
+	mKeepKeysInMemory      = true;
+	mKeepPositionsInMemory = true;
+}
+
+// memory maps the specified file (read-only & shared between processes)
+char* CJumpDnaHash::MapFile(FILE* stream, const uint64_t fileSize, const bool prefetch, const char* description) {
+
+	char* pMap = NULL;
+
+#ifndef WIN32
+	if(fileSize == 0) return NULL;
+
+	void* pData = mmap(NULL, (size_t)fileSize, PROT_READ, MAP_SHARED, fileno(stream), 0);
+
+	if(pData == MAP_FAILED) {
+		cout << "ERROR: Unable to memory map the jump " << description << " database." << endl;
+		exit(1);
+	}
+
+	// the keys are accessed randomly, so readahead is only useful when we prefetch the whole file
+	madvise(pData, (size_t)fileSize, (prefetch ? MADV_WILLNEED : MADV_RANDOM));
+
+	pMap = (char*)pData;
+#endif
+
+	return pMap;
+}
+
 // randomize and trim hash positions
 void CJumpDnaHash::RandomizeAndTrimHashPositions(unsigned short numHashPositions) {
 	mLimitPositions   = true;
@@ -15,11 +15,20 @@
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <random>
 #include "AbstractDnaHash.h"
+#include "JumpCanonicalKeys.h"
 #include "FileUtilities.h"
 #include "LargeFileSupport.h"
 #include "MemoryUtilities.h"
-#include "MruCache.h"
+#include "HashPositionCache.h"
+#include "JumpKmerFilter.h"
+#include "JumpPositionCodec.h"
+#include "JumpSparseKeys.h"
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 
 using namespace std;
 
@@ -28,7 +37,7 @@ using namespace std;
 class CJumpDnaHash : public CAbstractDnaHash {
 public:
 	// constructor
-	CJumpDnaHash(const unsigned char hashSize, const string& filenameStub, const unsigned short numPositions, const bool keepKeysInMemory, const bool keepPositionsInMemory, const unsigned int numCachedElements);
+	CJumpDnaHash(const unsigned char hashSize, const string& filenameStub, const unsigned short numPositions, const bool keepKeysInMemory, const bool keepPositionsInMemory, const unsigned int numCachedElements, const bool useMemoryMap, const bool prefetchMemoryMap);
 	// destructor
 	~CJumpDnaHash(void);
 	// dummy function
@@ -37,6 +46,12 @@ public:
 	void Clear(void);
 	// retrieves the genome location of the fragment
 	void Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy);
+	// retrieves the genome locations of both strands with one canonical lookup per fragment
+	void GetCanonicalBatch(vector<HashLookup>& lookups, CHashRegionTree& forwardHrt, CHashRegionTree& reverseHrt);
+	// returns true if the jump database stores canonical keys
+	bool IsCanonical(void) const;
+	// loads the filter of over-represented k-mers: their seeds are skipped with an mhp occupancy of zero
+	void LoadKmerFilter(const string& filename);
 	// returns the numbers of jump database cache hits and misses
 	void GetCacheStatistics(uint64_t& cacheHits, uint64_t& cacheMisses);
 	// dumps the contents of the hash table to standard output
@@ -47,14 +62,42 @@ public:
 	void RandomizeAndTrimHashPositions(unsigned short numHashPositions);
 
 private:
+	// decodes the hash positions that will be used from one strand's deltas and returns the number of bytes read
+	unsigned int DecodeStrandPositions(const unsigned char* pDeltas, const JumpListHeader& header, const unsigned int strand, vector<unsigned int>& positions, double& mhpOccupancy);
+	// retrieves the strand position lists stored with the canonical key, returns false if the key is undefined
+	bool GetCanonicalPositions(const uint64_t& canonicalKey, vector<unsigned int>* pStrandPositions, double* pMhpOccupancies);
+	// returns the lower of the key and its reverse complement
+	inline uint64_t GetCanonicalKey(const uint64_t& key) const;
+	// returns true if the k-mer filter marks the stored key as over-represented
+	inline bool IsFrequentKey(const uint64_t& key) const;
+	// retrieves the delta-encoded hash positions from a version 2 or 3 jump database
+	void GetEncodedPositions(const uint64_t& key, const off_type position, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy);
+	// returns the number of positions that have to be decoded to use the specified number of positions
+	unsigned int GetNumDecodedPositions(const unsigned int numStoredPositions, const unsigned int numUsedPositions) const;
+	// adds the hash positions to the hash region tree
+	void InsertHashPositions(const uint64_t& key, const vector<unsigned int>& positions, const unsigned int& queryPosition, CHashRegionTree& hrt);
+	// decodes the position lists at the specified offset (canonical databases store the canonical key & its reverse complement)
+	void ReadPositionLists(const off_type position, vector<unsigned int>* pStrandPositions, double* pMhpOccupancies);
+	// retrieves the positions file offset of the key, returns false if the key is undefined
+	bool GetKeyOffset(const uint64_t& key, off_type& position);
+	// retrieves the positions file offset of the key from the sparse key directory, returns false if the key is undefined
+	bool GetSparseKeyOffset(const uint64_t& key, off_type& position);
 	// loads the keys database into memory
 	void LoadKeys(void);
+	// reads and checks the header of a sparse keys file
+	void ReadSparseKeysHeader(const string& keysFilename);
 	// loads the positions database into memory
 	void LoadPositions(void);
+	// memory maps the keys and positions databases
+	void MapFiles(const bool prefetch);
+	// memory maps the specified file (read-only & shared between processes)
+	static char* MapFile(FILE* stream, const uint64_t fileSize, const bool prefetch, const char* description);
 	// dummy function
 	void Resize(void);
 	// specifies how many hash positions should be retrieved
 	unsigned short mNumPositions;
+	// the jump database format version
+	unsigned char mFormatVersion;
 	// toggles whether or not we return all hash positions or just a subset
 	bool mLimitPositions;
 	// toggles if the keys should be stored in memory
@@ -63,6 +106,20 @@ private:
 	bool mKeepPositionsInMemory;
 	// toggles if the hash table cache should be used
 	bool mUseCache;
+	// toggles if the keys and positions are memory mapped
+	bool mUseMemoryMap;
+	// toggles if the keys are stored in a sparse key directory
+	bool mUseSparseKeys;
+	// toggles if the keys are canonical (each key stores a forward and a reverse strand position list)
+	bool mIsCanonical;
+	// toggles if the dense key directory is indexed by canonical rank (one slot per key and reverse complement)
+	bool mUseCanonicalRanks;
+	// the ascending hash position caps that split each position list into deterministic subsample tiers
+	vector<unsigned int> mSubsampleCaps;
+	// toggles if the seeds of over-represented k-mers are skipped
+	bool mUseKmerFilter;
+	// our filter of over-represented k-mers
+	CJumpKmerFilter mKmerFilter;
 	// our jump database file handles
 	FILE* mKeys;
 	FILE* mMeta;
@@ -77,10 +134,36 @@ private:
 	char* mKeyBuffer;
 	uint64_t mKeyBufferLen;
 	uintptr_t mKeyBufferPtr;
+	// our sparse key directory layout
+	JumpSparseKeysHeader mSparseKeysHeader;
+	unsigned char mSparseLowBits;
+	uint64_t mSparseRecordsOffset;
+	// our sparse key record buffer (keys on disk)
+	vector<unsigned char> mSparseRecordBuffer;
 	// our input/output position buffer
 	char* mPositionBuffer;
 	uint64_t mPositionBufferLen;
 	uintptr_t mPositionBufferPtr;
 	// caches the most recently used hashes
-	CMruCache<uint64_t, vector<unsigned int> > mMruCache;
+	CHashPositionCache mHashPositionCache;
 };
+
+// returns the lower of the key and its reverse complement
+inline uint64_t CJumpDnaHash::GetCanonicalKey(const uint64_t& key) const {
+
+	// complement the bases and reverse the order of the 2-bit groups
+	uint64_t reverseKey = ~key;
+	reverseKey = ((reverseKey >> 2)  & 0x3333333333333333ULL) | ((reverseKey & 0x3333333333333333ULL) << 2);
+	reverseKey = ((reverseKey >> 4)  & 0x0F0F0F0F0F0F0F0FULL) | ((reverseKey & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	reverseKey = ((reverseKey >> 8)  & 0x00FF00FF00FF00FFULL) | ((reverseKey & 0x00FF00FF00FF00FFULL) << 8);
+	reverseKey = ((reverseKey >> 16) & 0x0000FFFF0000FFFFULL) | ((reverseKey & 0x0000FFFF0000FFFFULL) << 16);
+	reverseKey = (reverseKey >> 32) | (reverseKey << 32);
+	reverseKey >>= 64 - 2 * mHashSize;
+
+	return (key < reverseKey ? key : reverseKey);
+}
+
+// returns true if the k-mer filter marks the stored key as over-represented
+inline bool CJumpDnaHash::IsFrequentKey(const uint64_t& key) const {
+	return mUseKmerFilter && mKmerFilter.Contains(key);
+}
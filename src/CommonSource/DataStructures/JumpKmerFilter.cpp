@@ -0,0 +1,123 @@
+// ***************************************************************************
+// CJumpKmerFilter - a blocked Bloom filter of the over-represented k-mers in
+//                   a jump database. Lets the aligner skip seeds that would
+//                   only return capped or trimmed hash positions without
+//                   touching the keys or positions files.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "JumpKmerFilter.h"
+
+// constructor
+CJumpKmerFilter::CJumpKmerFilter(void)
+: mBlockMask(0)
+{
+	Initialize(0, 0);
+}
+
+// destructor
+CJumpKmerFilter::~CJumpKmerFilter(void) {}
+
+// adds a k-mer to the filter
+void CJumpKmerFilter::Add(const uint64_t& key) {
+
+	uint64_t blockHash = 0, probeHash = 0;
+	GetProbeHashes(key, blockHash, probeHash);
+
+	uint64_t* pBlock = &mBits[(blockHash & mBlockMask) * JUMP_KMER_FILTER_BLOCK_WORDS];
+	const unsigned int probeMask = (1 << JUMP_KMER_FILTER_BLOCK_BITS) - 1;
+
+	for(unsigned int p = 0; p < JUMP_KMER_FILTER_NUM_PROBES; p++, probeHash >>= JUMP_KMER_FILTER_BLOCK_BITS) {
+		const unsigned int bit = (unsigned int)(probeHash & probeMask);
+		pBlock[bit >> 6] |= (uint64_t)1 << (bit & 63);
+	}
+
+	mHeader.NumKeys++;
+}
+
+// returns the number of hash positions a k-mer needs to be added to the filter
+unsigned int CJumpKmerFilter::GetPositionThreshold(void) const {
+	return mHeader.PositionThreshold;
+}
+
+// creates an empty filter sized for the specified number of k-mers
+void CJumpKmerFilter::Initialize(const uint64_t numKeys, const unsigned int positionThreshold) {
+
+	memset((char*)&mHeader, 0, sizeof(JumpKmerFilterHeader));
+	memcpy(mHeader.Signature, JUMP_KMER_FILTER_SIGNATURE, JUMP_KMER_FILTER_SIGNATURE_LEN);
+	mHeader.PositionThreshold = positionThreshold;
+
+	// use a power of two number of blocks
+	const uint64_t blockSize = (uint64_t)JUMP_KMER_FILTER_BLOCK_WORDS * 64;
+	while(((uint64_t)1 << mHeader.BlockBits) * blockSize < numKeys * JUMP_KMER_FILTER_BITS_PER_KEY) mHeader.BlockBits++;
+
+	mBlockMask = ((uint64_t)1 << mHeader.BlockBits) - 1;
+
+	try {
+		mBits.assign(((size_t)1 << mHeader.BlockBits) * JUMP_KMER_FILTER_BLOCK_WORDS, 0);
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the k-mer filter." << endl;
+		exit(1);
+	}
+}
+
+// loads the filter from the specified file
+void CJumpKmerFilter::Load(const string& filename) {
+
+	uint64_t fileSize = 0;
+	CFileUtilities::GetFileSize(filename, fileSize);
+
+	FILE* in = NULL;
+	fopen_s(&in, filename.c_str(), "rb");
+
+	if(!in) {
+		cout << "ERROR: Unable to open the k-mer filter file (" << filename << ") for reading." << endl;
+		exit(1);
+	}
+
+	JumpKmerFilterHeader header;
+	memset((char*)&header, 0, sizeof(JumpKmerFilterHeader));
+	fread((char*)&header, sizeof(JumpKmerFilterHeader), 1, in);
+
+	const uint64_t numWords = ((uint64_t)1 << header.BlockBits) * JUMP_KMER_FILTER_BLOCK_WORDS;
+	if((memcmp(header.Signature, JUMP_KMER_FILTER_SIGNATURE, JUMP_KMER_FILTER_SIGNATURE_LEN) != 0) || (header.BlockBits > 40) ||
+		(fileSize != sizeof(JumpKmerFilterHeader) + numWords * SIZEOF_UINT64)) {
+		cout << "ERROR: The k-mer filter file (" << filename << ") is truncated or does not contain a valid k-mer filter." << endl;
+		exit(1);
+	}
+
+	// size the filter like the stored one and read the blocks
+	mHeader    = header;
+	mBlockMask = ((uint64_t)1 << mHeader.BlockBits) - 1;
+
+	try {
+		mBits.assign((size_t)numWords, 0);
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the k-mer filter." << endl;
+		exit(1);
+	}
+
+	fread((char*)&mBits[0], SIZEOF_UINT64, (size_t)numWords, in);
+	fclose(in);
+}
+
+// saves the filter to the specified file
+void CJumpKmerFilter::Save(const string& filename) const {
+
+	FILE* out = NULL;
+	fopen_s(&out, filename.c_str(), "wb");
+
+	if(!out) {
+		cout << "ERROR: Unable to open the k-mer filter file (" << filename << ") for writing." << endl;
+		exit(1);
+	}
+
+	fwrite((char*)&mHeader, sizeof(JumpKmerFilterHeader), 1, out);
+	fwrite((char*)&mBits[0], SIZEOF_UINT64, mBits.size(), out);
+	fclose(out);
+}
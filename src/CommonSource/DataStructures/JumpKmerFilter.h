@@ -0,0 +1,105 @@
+// ***************************************************************************
+// CJumpKmerFilter - a blocked Bloom filter of the over-represented k-mers in
+//                   a jump database. Lets the aligner skip seeds that would
+//                   only return capped or trimmed hash positions without
+//                   touching the keys or positions files.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "FileUtilities.h"
+#include "Mosaik.h"
+#include "SafeFunctions.h"
+
+using namespace std;
+
+// the k-mer filter file signature
+#define JUMP_KMER_FILTER_SIGNATURE     "MOSJMPKF"
+#define JUMP_KMER_FILTER_SIGNATURE_LEN 8
+
+// the number of filter bits per k-mer (about 0.1% false positives)
+#define JUMP_KMER_FILTER_BITS_PER_KEY 16
+
+// every k-mer sets its probe bits in one 512-bit block (a single cache line)
+#define JUMP_KMER_FILTER_BLOCK_WORDS 8
+#define JUMP_KMER_FILTER_BLOCK_BITS  9
+#define JUMP_KMER_FILTER_NUM_PROBES  7
+
+// the fixed-size header at the start of a k-mer filter file
+struct JumpKmerFilterHeader {
+	char Signature[JUMP_KMER_FILTER_SIGNATURE_LEN];
+	uint64_t NumKeys;
+	unsigned int PositionThreshold;
+	unsigned char BlockBits;
+	unsigned char Reserved[3];
+};
+
+class CJumpKmerFilter {
+public:
+	// constructor
+	CJumpKmerFilter(void);
+	// destructor
+	~CJumpKmerFilter(void);
+	// adds a k-mer to the filter
+	void Add(const uint64_t& key);
+	// returns true if the k-mer was added to the filter (false positives are possible)
+	inline bool Contains(const uint64_t& key) const;
+	// returns the number of hash positions a k-mer needs to be added to the filter
+	unsigned int GetPositionThreshold(void) const;
+	// creates an empty filter sized for the specified number of k-mers
+	void Initialize(const uint64_t numKeys, const unsigned int positionThreshold);
+	// loads the filter from the specified file
+	void Load(const string& filename);
+	// saves the filter to the specified file
+	void Save(const string& filename) const;
+private:
+	// returns the hashes that select the block and the probe bits of the k-mer
+	static inline void GetProbeHashes(const uint64_t& key, uint64_t& blockHash, uint64_t& probeHash);
+	// our filter layout
+	JumpKmerFilterHeader mHeader;
+	uint64_t mBlockMask;
+	// our filter blocks
+	vector<uint64_t> mBits;
+};
+
+// returns true if the k-mer was added to the filter (false positives are possible)
+inline bool CJumpKmerFilter::Contains(const uint64_t& key) const {
+
+	uint64_t blockHash = 0, probeHash = 0;
+	GetProbeHashes(key, blockHash, probeHash);
+
+	const uint64_t* pBlock = &mBits[(blockHash & mBlockMask) * JUMP_KMER_FILTER_BLOCK_WORDS];
+	const unsigned int probeMask = (1 << JUMP_KMER_FILTER_BLOCK_BITS) - 1;
+
+	for(unsigned int p = 0; p < JUMP_KMER_FILTER_NUM_PROBES; p++, probeHash >>= JUMP_KMER_FILTER_BLOCK_BITS) {
+		const unsigned int bit = (unsigned int)(probeHash & probeMask);
+		if((pBlock[bit >> 6] & ((uint64_t)1 << (bit & 63))) == 0) return false;
+	}
+
+	return true;
+}
+
+// returns the hashes that select the block and the probe bits of the k-mer
+inline void CJumpKmerFilter::GetProbeHashes(const uint64_t& key, uint64_t& blockHash, uint64_t& probeHash) {
+
+	// two rounds of the splitmix64 finalizer
+	uint64_t z = key + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	blockHash = z ^ (z >> 31);
+
+	z = blockHash + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	probeHash = z ^ (z >> 31);
+}
@@ -0,0 +1,234 @@
+// ***************************************************************************
+// CJumpPositionCodec - encodes and decodes the hash position lists stored in
+//                      version 2 & 3 jump databases: the positions are sorted
+//                      and stored as delta-encoded varints.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "Mosaik.h"
+
+using namespace std;
+
+// the jump database format versions (stored after the hash size in the metadata file)
+#define JUMP_FORMAT_VERSION_1 1
+#define JUMP_FORMAT_VERSION_2 2
+#define JUMP_FORMAT_VERSION_3 3
+
+// the strand layouts (stored after the key directory type in the metadata file)
+#define JUMP_STRANDS_FORWARD   0
+#define JUMP_STRANDS_CANONICAL 1
+// canonical keys in a dense key directory indexed by canonical rank (see CJumpCanonicalKeys)
+#define JUMP_STRANDS_CANONICAL_RANKED 2
+
+// the maximum number of bytes used by an encoded 32-bit varint
+#define JUMP_MAX_VARINT_LENGTH 5
+
+// the maximum length of a position list header (strand counts, reference counts & encoded lengths)
+#define JUMP_MAX_LIST_HEADER_LENGTH (6 * JUMP_MAX_VARINT_LENGTH)
+
+// the strands stored in a canonical position list (the lowest bits of the first header varint)
+#define JUMP_CANONICAL_KEY_ONLY     0
+#define JUMP_CANONICAL_REVERSE_ONLY 1
+#define JUMP_CANONICAL_BOTH_STRANDS 2
+#define JUMP_CANONICAL_STRAND_BITS  2
+
+// set in the first header varint when MosaikJump stored fewer positions than the reference contains (version 3)
+#define JUMP_LIST_TRUNCATED 1
+
+// the maximum number of subsample caps stored in the metadata file
+#define JUMP_MAX_SUBSAMPLE_CAPS 255
+
+// the decoded position list header (the forward layout only uses the first strand)
+struct JumpListHeader {
+	// the number of positions stored for each strand
+	unsigned int NumPositions[2];
+	// the number of positions of each strand in the reference (before the MosaikJump -mhp limit)
+	unsigned int NumReferencePositions[2];
+	// the length of the encoded deltas of each strand
+	unsigned int EncodedLength[2];
+	// toggles if each strand's encoded length is known (version 2 canonical lists only store the total)
+	bool HasStrandLengths;
+};
+
+class CJumpPositionCodec {
+public:
+	// decodes a position list header and returns the number of bytes read
+	static inline unsigned int DecodeListHeader(const unsigned char* pBuffer, const unsigned char formatVersion, const bool isCanonical, JumpListHeader& header);
+	// returns the end of the subsample tier that starts at the specified position
+	static inline unsigned int GetTierEnd(const vector<unsigned int>& subsampleCaps, const unsigned int tierBegin, const unsigned int numPositions);
+	// decodes a varint and returns the number of bytes read
+	static inline unsigned int DecodeVarint(const unsigned char* pBuffer, unsigned int& value);
+	// decodes a list of delta-encoded positions and returns the number of bytes read
+	static inline unsigned int DecodePositions(const unsigned char* pBuffer, const unsigned int numPositions, unsigned int* pPositions);
+	// encodes a version 3 position list header and returns the number of bytes written
+	static inline unsigned int EncodeListHeader(const JumpListHeader& header, const bool isCanonical, unsigned char* pBuffer);
+	// encodes a varint and returns the number of bytes written
+	static inline unsigned int EncodeVarint(unsigned int value, unsigned char* pBuffer);
+	// encodes a list of sorted positions as deltas and returns the number of bytes written
+	static inline unsigned int EncodePositions(const unsigned int* pPositions, const unsigned int numPositions, unsigned char* pBuffer);
+};
+
+// decodes a position list header and returns the number of bytes read
+inline unsigned int CJumpPositionCodec::DecodeListHeader(const unsigned char* pBuffer, const unsigned char formatVersion, const bool isCanonical, JumpListHeader& header) {
+
+	memset((char*)&header, 0, sizeof(JumpListHeader));
+	header.HasStrandLengths = true;
+
+	// version 3 headers flag the lists that were truncated by MosaikJump
+	unsigned int value = 0, numBytes = DecodeVarint(pBuffer, value);
+	bool isTruncated = false;
+
+	if(formatVersion >= JUMP_FORMAT_VERSION_3) {
+		isTruncated = ((value & JUMP_LIST_TRUNCATED) != 0);
+		value >>= 1;
+	}
+
+	// the lowest bits of a canonical header specify which strands are stored
+	unsigned int numStrands = 1;
+	if(isCanonical) {
+		const unsigned int strands = value & ((1 << JUMP_CANONICAL_STRAND_BITS) - 1);
+		const unsigned int count   = value >> JUMP_CANONICAL_STRAND_BITS;
+
+		header.NumPositions[0] = (strands == JUMP_CANONICAL_REVERSE_ONLY ? 0 : count);
+		header.NumPositions[1] = (strands == JUMP_CANONICAL_REVERSE_ONLY ? count : 0);
+
+		if(strands == JUMP_CANONICAL_BOTH_STRANDS) numBytes += DecodeVarint(pBuffer + numBytes, header.NumPositions[1]);
+		numStrands = 2;
+	} else header.NumPositions[0] = value;
+
+	for(unsigned int s = 0; s < numStrands; s++) {
+		header.NumReferencePositions[s] = header.NumPositions[s];
+		if(isTruncated && (header.NumPositions[s] > 0)) numBytes += DecodeVarint(pBuffer + numBytes, header.NumReferencePositions[s]);
+	}
+
+	// version 2 canonical lists only store the total encoded length
+	if((formatVersion < JUMP_FORMAT_VERSION_3) && isCanonical) {
+		header.HasStrandLengths = false;
+		return numBytes + DecodeVarint(pBuffer + numBytes, header.EncodedLength[0]);
+	}
+
+	for(unsigned int s = 0; s < numStrands; s++) {
+		if((s == 0) || (header.NumPositions[s] > 0)) numBytes += DecodeVarint(pBuffer + numBytes, header.EncodedLength[s]);
+	}
+
+	return numBytes;
+}
+
+// returns the end of the subsample tier that starts at the specified position
+inline unsigned int CJumpPositionCodec::GetTierEnd(const vector<unsigned int>& subsampleCaps, const unsigned int tierBegin, const unsigned int numPositions) {
+
+	// each tier is sorted on its own, so the first tiers form the subsample of every cap
+	vector<unsigned int>::const_iterator capIter = upper_bound(subsampleCaps.begin(), subsampleCaps.end(), tierBegin);
+	if((capIter == subsampleCaps.end()) || (*capIter >= numPositions)) return numPositions;
+	return *capIter;
+}
+
+// decodes a varint and returns the number of bytes read
+inline unsigned int CJumpPositionCodec::DecodeVarint(const unsigned char* pBuffer, unsigned int& value) {
+
+	// most deltas fit in one or two bytes
+	if(pBuffer[0] < 0x80) {
+		value = pBuffer[0];
+		return 1;
+	}
+
+	value = pBuffer[0] & 0x7f;
+	unsigned int numBytes = 1;
+	unsigned char shift   = 7;
+
+	while(true) {
+		const unsigned char b = pBuffer[numBytes++];
+		value |= (unsigned int)(b & 0x7f) << shift;
+		if((b < 0x80) || (numBytes == JUMP_MAX_VARINT_LENGTH)) break;
+		shift += 7;
+	}
+
+	return numBytes;
+}
+
+// decodes a list of delta-encoded positions and returns the number of bytes read
+inline unsigned int CJumpPositionCodec::DecodePositions(const unsigned char* pBuffer, const unsigned int numPositions, unsigned int* pPositions) {
+
+	unsigned int bufferOffset = 0, position = 0, delta = 0;
+
+	for(unsigned int i = 0; i < numPositions; i++) {
+		bufferOffset += DecodeVarint(pBuffer + bufferOffset, delta);
+		position     += delta;
+		pPositions[i] = position;
+	}
+
+	return bufferOffset;
+}
+
+// encodes a version 3 position list header and returns the number of bytes written
+inline unsigned int CJumpPositionCodec::EncodeListHeader(const JumpListHeader& header, const bool isCanonical, unsigned char* pBuffer) {
+
+	const unsigned int numStrands = (isCanonical ? 2 : 1);
+
+	// the reference counts are only stored when MosaikJump truncated a list
+	bool isTruncated = false;
+	for(unsigned int s = 0; s < numStrands; s++) {
+		if(header.NumReferencePositions[s] != header.NumPositions[s]) isTruncated = true;
+	}
+
+	// most k-mers only occur on one strand, so the second count is optional
+	unsigned int value = header.NumPositions[0], numBytes = 0;
+
+	if(isCanonical) {
+		if(header.NumPositions[1] == 0) {
+			value = (header.NumPositions[0] << JUMP_CANONICAL_STRAND_BITS) | JUMP_CANONICAL_KEY_ONLY;
+		} else if(header.NumPositions[0] == 0) {
+			value = (header.NumPositions[1] << JUMP_CANONICAL_STRAND_BITS) | JUMP_CANONICAL_REVERSE_ONLY;
+		} else value = (header.NumPositions[0] << JUMP_CANONICAL_STRAND_BITS) | JUMP_CANONICAL_BOTH_STRANDS;
+	}
+
+	numBytes = EncodeVarint((value << 1) | (isTruncated ? JUMP_LIST_TRUNCATED : 0), pBuffer);
+	if(isCanonical && (header.NumPositions[0] > 0) && (header.NumPositions[1] > 0)) numBytes += EncodeVarint(header.NumPositions[1], pBuffer + numBytes);
+
+	for(unsigned int s = 0; s < numStrands; s++) {
+		if(isTruncated && (header.NumPositions[s] > 0)) numBytes += EncodeVarint(header.NumReferencePositions[s], pBuffer + numBytes);
+	}
+
+	for(unsigned int s = 0; s < numStrands; s++) {
+		if((s == 0) || (header.NumPositions[s] > 0)) numBytes += EncodeVarint(header.EncodedLength[s], pBuffer + numBytes);
+	}
+
+	return numBytes;
+}
+
+// encodes a varint and returns the number of bytes written
+inline unsigned int CJumpPositionCodec::EncodeVarint(unsigned int value, unsigned char* pBuffer) {
+
+	unsigned int numBytes = 0;
+
+	while(value >= 0x80) {
+		pBuffer[numBytes++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+
+	pBuffer[numBytes++] = (unsigned char)value;
+	return numBytes;
+}
+
+// encodes a list of sorted positions as deltas and returns the number of bytes written
+inline unsigned int CJumpPositionCodec::EncodePositions(const unsigned int* pPositions, const unsigned int numPositions, unsigned char* pBuffer) {
+
+	unsigned int bufferOffset = 0, lastPosition = 0;
+
+	for(unsigned int i = 0; i < numPositions; i++) {
+		bufferOffset += EncodeVarint(pPositions[i] - lastPosition, pBuffer + bufferOffset);
+		lastPosition  = pPositions[i];
+	}
+
+	return bufferOffset;
+}
@@ -0,0 +1,123 @@
+// ***************************************************************************
+// CJumpSparseKeys - the sparse key directory used by jump databases with
+//                   large hash sizes. The keys are split into a bucket
+//                   directory (high bits) and sorted records containing the
+//                   low key bits and the positions file offset.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <cstring>
+#include "Mosaik.h"
+#include "LargeFileSupport.h"
+
+using namespace std;
+
+// the key directory types (stored after the format version in the metadata file)
+#define JUMP_KEYS_DENSE  0
+#define JUMP_KEYS_SPARSE 1
+
+// the sparse keys file signature
+#define JUMP_SPARSE_KEYS_SIGNATURE     "MOSJMPSK"
+#define JUMP_SPARSE_KEYS_SIGNATURE_LEN 8
+
+// the number of bytes used to store a positions file offset
+#define JUMP_SPARSE_OFFSET_LENGTH 5
+
+// the average number of hash positions per directory bucket
+#define JUMP_SPARSE_POSITIONS_PER_BUCKET 16
+
+// the maximum number of bits used by the bucket directory
+#define JUMP_SPARSE_MAX_DIRECTORY_BITS 30
+
+// the fixed-size header at the start of a sparse keys file
+struct JumpSparseKeysHeader {
+	char Signature[JUMP_SPARSE_KEYS_SIGNATURE_LEN];
+	uint64_t NumKeys;
+	unsigned char DirectoryBits;
+	unsigned char LowBytes;
+	unsigned char Reserved[6];
+};
+
+class CJumpSparseKeys {
+public:
+	// searches the records of a directory bucket for the low key bits, returns false if the key was not found
+	static inline bool FindOffset(const unsigned char* pRecords, unsigned int numRecords, const uint64_t& lowKey, const unsigned char lowBytes, off_type& offset);
+	// returns the number of directory bits for the specified number of hash positions
+	static inline unsigned char GetDirectoryBits(const uint64_t numHashPositions, const unsigned char hashSize);
+	// returns the offset of the bucket directory in the keys file
+	static inline uint64_t GetDirectoryOffset(void);
+	// returns the offset of the records in the keys file
+	static inline uint64_t GetRecordsOffset(const unsigned char directoryBits);
+	// returns the size of a record
+	static inline unsigned int GetRecordLength(const unsigned char lowBytes);
+	// stores the low key bits and the positions file offset in a record
+	static inline void PackRecord(const uint64_t& lowKey, const unsigned char lowBytes, const off_type& offset, unsigned char* pRecord);
+};
+
+// searches the records of a directory bucket for the low key bits, returns false if the key was not found
+inline bool CJumpSparseKeys::FindOffset(const unsigned char* pRecords, unsigned int numRecords, const uint64_t& lowKey, const unsigned char lowBytes, off_type& offset) {
+
+	const unsigned int recordLength = GetRecordLength(lowBytes);
+
+	// binary search on the low key bits (stored little endian)
+	unsigned int begin = 0, end = numRecords;
+	while(begin < end) {
+
+		const unsigned int middle = (begin + end) >> 1;
+		const unsigned char* pRecord = pRecords + middle * recordLength;
+
+		uint64_t recordKey = 0;
+		memcpy((char*)&recordKey, pRecord, lowBytes);
+
+		if(recordKey == lowKey) {
+			offset = 0;
+			memcpy((char*)&offset, pRecord + lowBytes, JUMP_SPARSE_OFFSET_LENGTH);
+			return true;
+		}
+
+		if(recordKey < lowKey) begin = middle + 1;
+		else end = middle;
+	}
+
+	return false;
+}
+
+// returns the number of directory bits for the specified number of hash positions
+inline unsigned char CJumpSparseKeys::GetDirectoryBits(const uint64_t numHashPositions, const unsigned char hashSize) {
+
+	const unsigned char keyBits = hashSize * 2;
+	unsigned char directoryBits = 1;
+
+	while((directoryBits < keyBits) && (directoryBits < JUMP_SPARSE_MAX_DIRECTORY_BITS) &&
+		(((uint64_t)JUMP_SPARSE_POSITIONS_PER_BUCKET << (directoryBits + 1)) <= numHashPositions)) directoryBits++;
+
+	return directoryBits;
+}
+
+// returns the offset of the bucket directory in the keys file
+inline uint64_t CJumpSparseKeys::GetDirectoryOffset(void) {
+	return sizeof(JumpSparseKeysHeader);
+}
+
+// returns the offset of the records in the keys file
+inline uint64_t CJumpSparseKeys::GetRecordsOffset(const unsigned char directoryBits) {
+	return GetDirectoryOffset() + (((uint64_t)1 << directoryBits) + 1) * SIZEOF_INT;
+}
+
+// returns the size of a record
+inline unsigned int CJumpSparseKeys::GetRecordLength(const unsigned char lowBytes) {
+	return lowBytes + JUMP_SPARSE_OFFSET_LENGTH;
+}
+
+// stores the low key bits and the positions file offset in a record
+inline void CJumpSparseKeys::PackRecord(const uint64_t& lowKey, const unsigned char lowBytes, const off_type& offset, unsigned char* pRecord) {
+	memcpy(pRecord, (const char*)&lowKey, lowBytes);
+	memcpy(pRecord + lowBytes, (const char*)&offset, JUMP_SPARSE_OFFSET_LENGTH);
+}
@@ -54,8 +54,36 @@ CMultiDnaHash::~CMultiDnaHash(void) {
 // redimension the hash table to the specified size
 void CMultiDnaHash::FreeMemory(void) {
 	mMemoryAllocated = false;
-	delete [] mHashes;
-	delete [] mHashPositions;
+
+	// the arrays of a loaded snapshot point into the snapshot buffer
+	if(mSnapshotBuffer) ReleaseSnapshot();
+	else {
+		delete [] mHashes;
+		delete [] mHashPositions;
+	}
+
+	mHashes        = NULL;
+	mHashPositions = NULL;
+}
+
+// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+bool CMultiDnaHash::AttachSnapshotSections(const vector<HashSnapshotSection>& sections) {
+
+	if((sections.size() != 2) || (sections[0].NumBytes != (uint64_t)mCapacity * SIZEOF_UINT64) ||
+		(sections[1].NumBytes != (uint64_t)mCapacity * DNA_HASH_NUM_STORED * SIZEOF_INT)) return false;
+
+	mHashes        = (uint64_t*)sections[0].pData;
+	mHashPositions = (unsigned int*)sections[1].pData;
+
+	return true;
+}
+
+// retrieves the hash table arrays that are stored in a snapshot
+bool CMultiDnaHash::GetSnapshotSections(vector<HashSnapshotSection>& sections) {
+	sections.clear();
+	sections.push_back(HashSnapshotSection((char*)mHashes,        (uint64_t)mCapacity * SIZEOF_UINT64));
+	sections.push_back(HashSnapshotSection((char*)mHashPositions, (uint64_t)mCapacity * DNA_HASH_NUM_STORED * SIZEOF_INT));
+	return true;
 }
 
 // adds a fragment to the hash table
@@ -176,6 +204,55 @@ void CMultiDnaHash::Get(const uint64_t& key, const unsigned int& queryPosition,
 	}
 }
 
+// retrieves the genome locations of all of the fragments (in order of the lookups)
+void CMultiDnaHash::GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt) {
+
+	const unsigned int numLookups = (unsigned int)lookups.size();
+	unsigned int positions[HASH_PREFETCH_DISTANCE];
+
+	// prefetch the first hash slots
+	for(unsigned int i = 0; (i < HASH_PREFETCH_DISTANCE) && (i < numLookups); i++) {
+		positions[i] = PrefetchIndexFor(lookups[i].Key);
+		PREFETCH_READ(mHashPositions + positions[i] * DNA_HASH_NUM_STORED);
+	}
+
+	for(unsigned int i = 0; i < numLookups; i++) {
+
+		HashLookup& lookup = lookups[i];
+		unsigned int position = positions[i % HASH_PREFETCH_DISTANCE];
+
+		// prefetch the hash slot that is resolved a few lookups from now
+		const unsigned int prefetchIndex = i + HASH_PREFETCH_DISTANCE;
+		if(prefetchIndex < numLookups) {
+			const unsigned int prefetchPosition = PrefetchIndexFor(lookups[prefetchIndex].Key);
+			PREFETCH_READ(mHashPositions + prefetchPosition * DNA_HASH_NUM_STORED);
+			positions[i % HASH_PREFETCH_DISTANCE] = prefetchPosition;
+		}
+
+		// use a fixed mhp occupancy
+		lookup.MhpOccupancy = 1.0;
+
+		if(!FindKey(lookup.Key, position)) continue;
+
+		// create new hash regions and add them to the tree
+		unsigned int startPos = position * DNA_HASH_NUM_STORED;
+		unsigned int endPos   = startPos + DNA_HASH_NUM_STORED;
+
+		for(unsigned int hashPos = startPos; hashPos < endPos; hashPos++) {
+
+			// if there is a position available, add the current position
+			if(mHashPositions[hashPos] == DNA_EMPTY_HASH_POSITION) break;
+
+			HashRegion island;
+			island.Begin         = mHashPositions[hashPos];
+			island.End           = mHashPositions[hashPos] + mHashSize - 1;
+			island.QueryBegin    = lookup.QueryPosition;
+			island.QueryEnd      = lookup.QueryPosition + mHashSize - 1;
+			hrt.Insert(island);
+		}
+	}
+}
+
 // runs when we need to resize the hash table
 void CMultiDnaHash::Resize(void) {
 
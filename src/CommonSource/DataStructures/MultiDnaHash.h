@@ -31,6 +31,8 @@ public:
 	void Clear(void);
 	// retrieves the genome location of the fragment
 	void Get(const uint64_t& key, const unsigned int& queryPosition, CHashRegionTree& hrt, double& mhpOccupancy);
+	// retrieves the genome locations of all of the fragments (in order of the lookups)
+	void GetBatch(vector<HashLookup>& lookups, CHashRegionTree& hrt);
 	// dumps the contents of the hash table to standard output
 	void Dump();
 	// frees all memory used by the hash table
@@ -38,7 +40,11 @@ public:
 	// randomize and trim hash positions
 	void RandomizeAndTrimHashPositions(unsigned short numHashPositions);
 
-private:	
+private:
+	// points the hash table arrays at the snapshot sections, returns false if the sections do not fit
+	bool AttachSnapshotSections(const vector<HashSnapshotSection>& sections);
+	// retrieves the hash table arrays that are stored in a snapshot
+	bool GetSnapshotSections(vector<HashSnapshotSection>& sections);
 	// runs when we need to resize the hash table
 	void Resize(void);
 	// stores track of hash positions
@@ -23,6 +23,8 @@ namespace MosaikReadFormat {
 		, mBufferPosition(0)
 		, mCompressionBuffer(NULL)
 		, mCompressionBufferLen(0)
+		, mpCompressor(NULL)
+		, mNumCompressionThreads(0)
 		, mPartitionSize(20000)
 		, mPartitionMembers(0)
 		, mpRefGapVector(NULL)
@@ -31,7 +33,10 @@ namespace MosaikReadFormat {
 		, mLastReferenceIndex(0)
 		, mLastReferencePosition(0)
 		, mStoreIndex(false)
+		, mpArchive(NULL)
 	{
+		pthread_mutex_init(&mPartitionMutex, NULL);
+
 		// set the buffer threshold
 		mBufferThreshold = mBufferLen - MEMORY_BUFFER_SIZE;
 
@@ -49,6 +54,7 @@ namespace MosaikReadFormat {
 		if(mIsOpen)            Close();
 		if(mBuffer)            delete [] mBuffer;
 		if(mCompressionBuffer) delete [] mCompressionBuffer;
+		pthread_mutex_destroy(&mPartitionMutex);
 	}
 
 	// adds a header tag
@@ -99,6 +105,22 @@ namespace MosaikReadFormat {
 		// flush the buffer
 		if(mPartitionMembers > 0) WritePartition();
 
+		// thread-local writers only need to report their statistics to the archive
+		if(mpArchive) {
+			mpArchive->MergeStatistics(*this);
+			mpArchive = NULL;
+			return;
+		}
+
+		// wait for the remaining partitions to be compressed and written
+		vector<off_type> compressorPartitionOffsets;
+		if(mpCompressor) {
+			mpCompressor->Flush();
+			compressorPartitionOffsets = mpCompressor->GetPartitionOffsets();
+			delete mpCompressor;
+			mpCompressor = NULL;
+		}
+
 		// =======================================
 		// save the reference sequence information
 		// =======================================
@@ -235,6 +257,10 @@ namespace MosaikReadFormat {
 		off_type indexFileOffset = 0;
 		if(mStoreIndex) {
 
+			// assign the file offsets of the partitions written by the compression threads
+			const unsigned int numCompressorIndexEntries = (unsigned int)mCompressorIndexEntries.size();
+			for(unsigned int i = 0; i < numCompressorIndexEntries; i++) mIndex[mCompressorIndexEntries[i]].Offset = compressorPartitionOffsets[i];
+
 			// get the current file offset
 			indexFileOffset = ftell64(mOutStream);
 
@@ -299,6 +325,11 @@ namespace MosaikReadFormat {
 		fclose(mOutStream);
 	}
 
+	// compresses the partitions in the specified number of threads
+	void CAlignmentWriter::EnableParallelCompression(const unsigned int numThreads) {
+		mNumCompressionThreads = numThreads;
+	}
+
 	// retrieves the number of bases written
 	uint64_t CAlignmentWriter::GetNumBases(void) const {
 		return mNumBases;
@@ -309,6 +340,22 @@ namespace MosaikReadFormat {
 		return mNumReads;
 	}
 
+	// adds the statistics from a closed thread-local writer
+	void CAlignmentWriter::MergeStatistics(const CAlignmentWriter& localWriter) {
+
+		pthread_mutex_lock(&mPartitionMutex);
+
+		mNumReads += localWriter.mNumReads;
+		mNumBases += localWriter.mNumBases;
+
+		vector<ReferenceSequence>::const_iterator lrsIter = localWriter.mReferenceSequences.begin();
+		vector<ReferenceSequence>::iterator rsIter;
+		for(rsIter = mReferenceSequences.begin(); rsIter != mReferenceSequences.end(); rsIter++, lrsIter++)
+			rsIter->NumAligned += lrsIter->NumAligned;
+
+		pthread_mutex_unlock(&mPartitionMutex);
+	}
+
 	// opens the alignment archive
 	void CAlignmentWriter::Open(const string& filename, const vector<ReferenceSequence>& referenceSequences, const vector<ReadGroup>& readGroups, const AlignmentStatus as) {
 
@@ -447,6 +494,37 @@ namespace MosaikReadFormat {
 			// write the number of read group tags (hard coded as 0 for now)
 			fputc(0, mOutStream);
 		}
+
+		// initialize our parallel partition compressor
+		if(mNumCompressionThreads > 1) mpCompressor = new CPartitionCompressor(mOutStream, mNumCompressionThreads);
+	}
+
+	// opens a thread-local writer that serializes reads into its own partitions and hands them to the specified archive
+	void CAlignmentWriter::OpenThreadLocal(CAlignmentWriter* pArchive) {
+
+		if(mIsOpen) {
+			cout << "ERROR: An attempt was made to open an already open alignment archive." << endl;
+			exit(1);
+		}
+
+		mIsOpen   = true;
+		mpArchive = pArchive;
+
+		// initialization
+		mBufferPosition     = 0;
+		mPartitionMembers   = 0;
+		mNumReads           = 0;
+		mNumBases           = 0;
+		mStatus             = pArchive->mStatus;
+		mPartitionSize      = pArchive->mPartitionSize;
+		mIsPairedEndArchive = pArchive->mIsPairedEndArchive;
+
+		// we only keep track of the number of aligned reads per reference sequence
+		mNumRefSeqs = pArchive->mNumRefSeqs;
+		mReferenceSequences.resize(mNumRefSeqs);
+
+		vector<ReferenceSequence>::iterator rsIter;
+		for(rsIter = mReferenceSequences.begin(); rsIter != mReferenceSequences.end(); rsIter++) rsIter->NumAligned = 0;
 	}
 
 	// saves the read to the alignment archive
@@ -776,36 +854,74 @@ namespace MosaikReadFormat {
 		mpRefGapVector = pRefGapVector;
 	}
 
-	// write partition to disk
-	void CAlignmentWriter::WritePartition(void) {
+	// writes a compressed partition to disk (thread-safe)
+	void CAlignmentWriter::SavePartition(const unsigned char* pCompressedPartition, const int compressedSize, const unsigned int uncompressedSize, const unsigned short numPartitionMembers, const unsigned int lastReferenceIndex, const unsigned int lastReferencePosition) {
+
+		pthread_mutex_lock(&mPartitionMutex);
+
+		// make sure that the partitions queued in the compression threads precede ours
+		if(mpCompressor) mpCompressor->Flush();
 
 		// store the partition index entry
 		if(mStoreIndex) {
 			IndexEntry ie;
 			ie.Offset         = ftell64(mOutStream);
-			ie.ReferenceIndex = mLastReferenceIndex;
-			ie.Position       = mLastReferencePosition;
+			ie.ReferenceIndex = lastReferenceIndex;
+			ie.Position       = lastReferencePosition;
 			mIndex.push_back(ie);
 		}
 
-		// check the compression buffer size
-		unsigned int requestedSize = (unsigned int)(mBufferPosition * 1.05);
-		CMemoryUtilities::CheckBufferSize(mCompressionBuffer, mCompressionBufferLen, requestedSize);
-
-		// compress the partition
-		int compressedSize = fastlz_compress_level(FASTLZ_BETTER_COMPRESSION, mBuffer, mBufferPosition, mCompressionBuffer);
-
 		// write the uncompressed partition entry size
-		fwrite((char*)&mBufferPosition, SIZEOF_INT, 1, mOutStream);
+		fwrite((char*)&uncompressedSize, SIZEOF_INT, 1, mOutStream);
 
 		// write the compressed partition entry size
 		fwrite((char*)&compressedSize, SIZEOF_INT, 1, mOutStream);
 
 		// write the partition member size
-		fwrite((char*)&mPartitionMembers, SIZEOF_SHORT, 1, mOutStream);
+		fwrite((char*)&numPartitionMembers, SIZEOF_SHORT, 1, mOutStream);
 
 		// write the partition
-		fwrite(mCompressionBuffer, compressedSize, 1, mOutStream);
+		fwrite(pCompressedPartition, compressedSize, 1, mOutStream);
+
+		pthread_mutex_unlock(&mPartitionMutex);
+	}
+
+	// write partition to disk
+	void CAlignmentWriter::WritePartition(void) {
+
+		// hand the partition to the compression threads
+		if(mpCompressor) {
+
+			// the file offset is assigned once the partition has been written
+			if(mStoreIndex) {
+				IndexEntry ie;
+				ie.Offset         = 0;
+				ie.ReferenceIndex = mLastReferenceIndex;
+				ie.Position       = mLastReferencePosition;
+
+				pthread_mutex_lock(&mPartitionMutex);
+				mCompressorIndexEntries.push_back((unsigned int)mIndex.size());
+				mIndex.push_back(ie);
+				pthread_mutex_unlock(&mPartitionMutex);
+			}
+
+			mpCompressor->SavePartition(mBuffer, mBufferLen, mBufferPosition, mPartitionMembers);
+			mBufferThreshold  = mBufferLen - MEMORY_BUFFER_SIZE;
+			mPartitionMembers = 0;
+			mBufferPosition   = 0;
+			return;
+		}
+
+		// check the compression buffer size
+		unsigned int requestedSize = (unsigned int)(mBufferPosition * 1.05);
+		CMemoryUtilities::CheckBufferSize(mCompressionBuffer, mCompressionBufferLen, requestedSize);
+
+		// compress the partition
+		int compressedSize = fastlz_compress_level(FASTLZ_BETTER_COMPRESSION, mBuffer, mBufferPosition, mCompressionBuffer);
+
+		// write the partition to our archive
+		CAlignmentWriter* pArchive = (mpArchive ? mpArchive : this);
+		pArchive->SavePartition(mCompressionBuffer, compressedSize, mBufferPosition, mPartitionMembers, mLastReferenceIndex, mLastReferencePosition);
 
 		mPartitionMembers = 0;
 		mBufferPosition   = 0;
@@ -25,6 +25,8 @@
 #include "MemoryUtilities.h"
 #include "Mosaik.h"
 #include "NaiveAlignmentSet.h"
+#include "PartitionCompressor.h"
+#include "PosixThreads.h"
 #include "Read.h"
 #include "ReadGroup.h"
 #include "ReferenceSequence.h"
@@ -56,12 +58,16 @@ namespace MosaikReadFormat {
 		void AddHeaderTag(const Tag& tag);
 		// closes the alignment archive
 		void Close(void);
+		// compresses the partitions in the specified number of threads
+		void EnableParallelCompression(const unsigned int numThreads);
 		// retrieves the number of bases written
 		uint64_t GetNumBases(void) const;
 		// retrieves the number of reads written
 		uint64_t GetNumReads(void) const;
 		// opens the alignment archive
 		void Open(const string& filename, const vector<ReferenceSequence>& referenceSequences, const vector<ReadGroup>& readGroups, const AlignmentStatus as);
+		// opens a thread-local writer that serializes reads into its own partitions and hands them to the specified archive
+		void OpenThreadLocal(CAlignmentWriter* pArchive);
 		// saves the read to the alignment archive
 		void SaveAlignedRead(const Mosaik::AlignedRead& ar);
 		// saves the alignment to the alignment archive
@@ -82,6 +88,10 @@ namespace MosaikReadFormat {
 		};
 		// adjusts the buffer
 		void AdjustBuffer(void);
+		// adds the statistics from a closed thread-local writer
+		void MergeStatistics(const CAlignmentWriter& localWriter);
+		// writes a compressed partition to disk (thread-safe)
+		void SavePartition(const unsigned char* pCompressedPartition, const int compressedSize, const unsigned int uncompressedSize, const unsigned short numPartitionMembers, const unsigned int lastReferenceIndex, const unsigned int lastReferencePosition);
 		// serializes the specified alignment
 		void WriteAlignment(const Alignment* pAl, const bool isLongRead, const bool isPairedEnd, const bool isFirstMate, const bool isResolvedAsPair);
 		// write partition to disk
@@ -105,6 +115,11 @@ namespace MosaikReadFormat {
 		// our output compression buffer
 		unsigned char* mCompressionBuffer;
 		unsigned int mCompressionBufferLen;
+		// our parallel partition compressor
+		CPartitionCompressor* mpCompressor;
+		unsigned int mNumCompressionThreads;
+		// the index entries whose file offsets are assigned by the compressor
+		vector<unsigned int> mCompressorIndexEntries;
 		// our partitioning setup
 		unsigned short mPartitionSize;
 		unsigned short mPartitionMembers;
@@ -126,5 +141,9 @@ namespace MosaikReadFormat {
 		bool mStoreIndex;
 		// our header tags
 		map<unsigned char, Tag> mHeaderTags;
+		// the archive that receives our partitions (thread-local writers only)
+		CAlignmentWriter* mpArchive;
+		// serializes the partitions handed over by the thread-local writers
+		pthread_mutex_t mPartitionMutex;
 	};
 }
@@ -0,0 +1,129 @@
+// ***************************************************************************
+// CReadPrefetcher - loads batches of reads from the MOSAIK read archive in
+//                   its own thread and hands them to the consumer threads.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "ReadPrefetcher.h"
+
+namespace MosaikReadFormat {
+
+	// constructor
+	CReadPrefetcher::CReadPrefetcher(CReadReader* pIn, const unsigned int batchSize, const unsigned int numBatches, uint64_t* pReadCounter)
+		: mpIn(pIn)
+		, mBatches(numBatches > 0 ? numBatches : 1)
+		, mpReadCounter(pReadCounter)
+		, mIsThreadRunning(false)
+		, mIsFinished(false)
+	{
+		// initialize our batches
+		const unsigned int numBatchReads = (batchSize > 0 ? batchSize : 1);
+		for(vector<ReadBatch>::iterator bIter = mBatches.begin(); bIter != mBatches.end(); ++bIter) {
+			bIter->Reads.resize(numBatchReads);
+			mEmptyBatches.push_back(&(*bIter));
+		}
+
+		pthread_mutex_init(&mQueueMutex, NULL);
+		pthread_cond_init(&mEmptyBatchCondition, NULL);
+		pthread_cond_init(&mLoadedBatchCondition, NULL);
+	}
+
+	// destructor
+	CReadPrefetcher::~CReadPrefetcher(void) {
+		if(mIsThreadRunning) WaitThread();
+		pthread_cond_destroy(&mLoadedBatchCondition);
+		pthread_cond_destroy(&mEmptyBatchCondition);
+		pthread_mutex_destroy(&mQueueMutex);
+	}
+
+	// retrieves the next batch of reads, returns false when all reads have been dispatched
+	bool CReadPrefetcher::GetNextBatch(ReadBatch*& pBatch) {
+
+		pthread_mutex_lock(&mQueueMutex);
+
+		while(mLoadedBatches.empty() && !mIsFinished)
+			pthread_cond_wait(&mLoadedBatchCondition, &mQueueMutex);
+
+		// quit if we've dispatched all of the reads
+		if(mLoadedBatches.empty()) {
+			pthread_mutex_unlock(&mQueueMutex);
+			pBatch = NULL;
+			return false;
+		}
+
+		pBatch = mLoadedBatches.front();
+		mLoadedBatches.pop_front();
+		if(mpReadCounter) *mpReadCounter = *mpReadCounter + pBatch->NumReads;
+
+		pthread_mutex_unlock(&mQueueMutex);
+
+		return true;
+	}
+
+	// activates the loading thread
+	void* CReadPrefetcher::LoadThread(void* arg) {
+		CReadPrefetcher* pPrefetcher = (CReadPrefetcher*)arg;
+		pPrefetcher->LoadBatches();
+		return 0;
+	}
+
+	// loads batches of reads until the read archive is exhausted
+	void CReadPrefetcher::LoadBatches(void) {
+
+		bool isFinished = false;
+		while(!isFinished) {
+
+			// wait for an empty batch
+			pthread_mutex_lock(&mQueueMutex);
+			while(mEmptyBatches.empty()) pthread_cond_wait(&mEmptyBatchCondition, &mQueueMutex);
+			ReadBatch* pBatch = mEmptyBatches.front();
+			mEmptyBatches.pop_front();
+			pthread_mutex_unlock(&mQueueMutex);
+
+			// read and uncompress the reads outside of the lock
+			const unsigned int batchSize = (unsigned int)pBatch->Reads.size();
+			pBatch->NumReads = 0;
+			while((pBatch->NumReads < batchSize) && mpIn->LoadNextRead(pBatch->Reads[pBatch->NumReads])) pBatch->NumReads++;
+			if(pBatch->NumReads < batchSize) isFinished = true;
+
+			// hand the batch to the consumer threads
+			pthread_mutex_lock(&mQueueMutex);
+
+			if(pBatch->NumReads > 0) mLoadedBatches.push_back(pBatch);
+			else mEmptyBatches.push_back(pBatch);
+
+			if(isFinished) {
+				mIsFinished = true;
+				pthread_cond_broadcast(&mLoadedBatchCondition);
+			} else pthread_cond_signal(&mLoadedBatchCondition);
+
+			pthread_mutex_unlock(&mQueueMutex);
+		}
+	}
+
+	// returns a processed batch so that it can be refilled
+	void CReadPrefetcher::ReleaseBatch(ReadBatch* pBatch) {
+		pthread_mutex_lock(&mQueueMutex);
+		mEmptyBatches.push_back(pBatch);
+		pthread_cond_signal(&mEmptyBatchCondition);
+		pthread_mutex_unlock(&mQueueMutex);
+	}
+
+	// starts the loading thread
+	void CReadPrefetcher::StartThread(void) {
+		pthread_create(&mThread, NULL, LoadThread, (void*)this);
+		mIsThreadRunning = true;
+	}
+
+	// waits for the loading thread to finish
+	void CReadPrefetcher::WaitThread(void) {
+		void* status = NULL;
+		pthread_join(mThread, &status);
+		mIsThreadRunning = false;
+	}
+}
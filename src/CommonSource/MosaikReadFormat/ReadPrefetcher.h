@@ -0,0 +1,71 @@
+// ***************************************************************************
+// CReadPrefetcher - loads batches of reads from the MOSAIK read archive in
+//                   its own thread and hands them to the consumer threads.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "PosixThreads.h"
+#include "Read.h"
+#include "ReadReader.h"
+
+using namespace std;
+
+namespace MosaikReadFormat {
+
+	// stores a batch of reads retrieved from the read archive
+	struct ReadBatch {
+		vector<Mosaik::Read> Reads;
+		unsigned int NumReads;
+
+		ReadBatch(void)
+			: NumReads(0)
+		{}
+	};
+
+	class CReadPrefetcher {
+	public:
+		// constructor
+		CReadPrefetcher(CReadReader* pIn, const unsigned int batchSize, const unsigned int numBatches, uint64_t* pReadCounter);
+		// destructor
+		~CReadPrefetcher(void);
+		// retrieves the next batch of reads, returns false when all reads have been dispatched
+		bool GetNextBatch(ReadBatch*& pBatch);
+		// returns a processed batch so that it can be refilled
+		void ReleaseBatch(ReadBatch* pBatch);
+		// starts the loading thread
+		void StartThread(void);
+		// waits for the loading thread to finish
+		void WaitThread(void);
+	private:
+		// activates the loading thread
+		static void* LoadThread(void* arg);
+		// loads batches of reads until the read archive is exhausted
+		void LoadBatches(void);
+		// our read archive
+		CReadReader* mpIn;
+		// our read batches
+		vector<ReadBatch> mBatches;
+		deque<ReadBatch*> mEmptyBatches;
+		deque<ReadBatch*> mLoadedBatches;
+		// the number of reads dispatched to the consumer threads
+		uint64_t* mpReadCounter;
+		// our loading thread
+		pthread_t mThread;
+		bool mIsThreadRunning;
+		// denotes that the read archive has been exhausted
+		bool mIsFinished;
+		// our thread synchronization
+		pthread_mutex_t mQueueMutex;
+		pthread_cond_t mEmptyBatchCondition;
+		pthread_cond_t mLoadedBatchCondition;
+	};
+}
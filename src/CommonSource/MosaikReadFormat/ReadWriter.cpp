@@ -23,6 +23,8 @@ namespace MosaikReadFormat {
 		, mBufferPosition(0)
 		, mCompressionBuffer(NULL)
 		, mCompressionBufferLen(0)
+		, mpCompressor(NULL)
+		, mNumCompressionThreads(0)
 		, mPartitionSize(20000)
 		, mPartitionMembers(0)
 		, mIsSOLiD(false)
@@ -82,6 +84,12 @@ namespace MosaikReadFormat {
 		// flush the buffer
 		if(mPartitionMembers > 0) WritePartition();
 
+		// wait for the remaining partitions to be compressed and written
+		if(mpCompressor) {
+			delete mpCompressor;
+			mpCompressor = NULL;
+		}
+
 		// =================
 		// update the header
 		// =================
@@ -97,6 +105,11 @@ namespace MosaikReadFormat {
 		fclose(mOutStream);
 	}
 
+	// compresses the partitions in the specified number of threads
+	void CReadWriter::EnableParallelCompression(const unsigned int numThreads) {
+		mNumCompressionThreads = numThreads;
+	}
+
 	// retrieves the number of bases written
 	uint64_t CReadWriter::GetNumBases(void) const {
 		return mNumBases;
@@ -205,6 +218,9 @@ namespace MosaikReadFormat {
 		fwrite(readGroup.PlatformUnit.c_str(), platformUnitLen, 1, mOutStream);
 		fwrite(readGroup.ReadGroupID.c_str(),  readGroupIDLen,  1, mOutStream);
 		fwrite(readGroup.SampleName.c_str(),   sampleNameLen,   1, mOutStream);
+
+		// initialize our parallel partition compressor
+		if(mNumCompressionThreads > 1) mpCompressor = new CPartitionCompressor(mOutStream, mNumCompressionThreads);
 	}
 
 	// saves the read to the read archive
@@ -316,6 +332,15 @@ namespace MosaikReadFormat {
 	// write partition to disk
 	void CReadWriter::WritePartition(void) {
 
+		// hand the partition to the compression threads
+		if(mpCompressor) {
+			mpCompressor->SavePartition(mBuffer, mBufferLen, mBufferPosition, mPartitionMembers);
+			mBufferThreshold  = mBufferLen - MEMORY_BUFFER_SIZE;
+			mPartitionMembers = 0;
+			mBufferPosition   = 0;
+			return;
+		}
+
 		// check the compression buffer size
 		unsigned int requestedSize = (unsigned int)(mBufferPosition * 1.05);
 		CMemoryUtilities::CheckBufferSize(mCompressionBuffer, mCompressionBufferLen, requestedSize);
@@ -17,6 +17,7 @@
 #include "FileUtilities.h"
 #include "ReadGroup.h"
 #include "MemoryUtilities.h"
+#include "PartitionCompressor.h"
 #include "Read.h"
 #include "ReadStatus.h"
 #include "SequencingTechnologies.h"
@@ -41,6 +42,8 @@ namespace MosaikReadFormat {
 		~CReadWriter(void);
 		// closes the read archive
 		void Close(void);
+		// compresses the partitions in the specified number of threads
+		void EnableParallelCompression(const unsigned int numThreads);
 		// retrieves the number of bases written
 		uint64_t GetNumBases(void) const;
 		// retrieves the number of reads written
@@ -69,6 +72,9 @@ namespace MosaikReadFormat {
 		// our output compression buffer
 		unsigned char* mCompressionBuffer;
 		unsigned int mCompressionBufferLen;
+		// our parallel partition compressor
+		CPartitionCompressor* mpCompressor;
+		unsigned int mNumCompressionThreads;
 		// our partitioning setup
 		unsigned short mPartitionSize;
 		unsigned short mPartitionMembers;
@@ -29,7 +29,16 @@ CBandedSmithWaterman::CBandedSmithWaterman(float matchScore, float mismatchScore
 , mCurrentAnchorSize(0)
 , mCurrentAQSumSize(0)
 , mBandwidth(bandWidth)
-, mPointers(NULL)
+, mTraceback(NULL)
+, mRowBegins(NULL)
+, mRowEnds(NULL)
+, mBlockedColumns(NULL)
+, mRowGapOpenPenalties(NULL)
+, mCurrentRowSize(0)
+#ifdef __SSE2__
+, mDiagonalBuffers(NULL)
+, mCurrentDiagonalSize(0)
+#endif
 , mMatchScore(matchScore)
 , mMismatchScore(mismatchScore)
 , mGapOpenPenalty(gapOpenPenalty)
@@ -53,7 +62,14 @@ CBandedSmithWaterman::CBandedSmithWaterman(float matchScore, float mismatchScore
 
 // destructor
 CBandedSmithWaterman::~CBandedSmithWaterman(void) {
-	if(mPointers)              delete [] mPointers;
+	if(mTraceback)             delete [] mTraceback;
+	if(mRowBegins)             delete [] mRowBegins;
+	if(mRowEnds)               delete [] mRowEnds;
+	if(mBlockedColumns)        delete [] mBlockedColumns;
+	if(mRowGapOpenPenalties)   delete [] mRowGapOpenPenalties;
+#ifdef __SSE2__
+	if(mDiagonalBuffers)       delete [] mDiagonalBuffers;
+#endif
 	if(mAnchorGapScores)       delete [] mAnchorGapScores;
 	if(mBestScores)            delete [] mBestScores;
 	if(mReversedAnchor)        delete [] mReversedAnchor;
@@ -102,8 +118,27 @@ void CBandedSmithWaterman::Align(Alignment& alignment, const char* s1, const uns
 
 	unsigned int bestColumn	= 0;
 	unsigned int bestRow	= 0;
-	float bestScore         = FLOAT_NEGATIVE_INFINITY;
-	float currentQueryGapScore;
+
+	const unsigned int numRows = DefineBandRows(s2, s1Length, s2Length, hr, columnOffset);
+
+#ifdef __SSE2__
+	if(mBandwidth >= BSW_MIN_VECTOR_BANDWIDTH) FillAntiDiagonals(s1, s2, numRows, hr.QueryBegin, columnOffset, bestRow, bestColumn);
+	else FillRows(s1, s2, numRows, hr.QueryBegin, rowOffset, columnOffset, bestRow, bestColumn);
+#else
+	FillRows(s1, s2, numRows, hr.QueryBegin, rowOffset, columnOffset, bestRow, bestColumn);
+#endif
+
+	// =========================================
+	// Banded Smith-Waterman backtrace algorithm
+	// =========================================
+
+	Traceback(alignment, s1, s2, s2Length, bestRow, bestColumn, rowOffset, columnOffset);
+}
+
+// records the band columns that are visited in each row, returns the number of rows
+unsigned int CBandedSmithWaterman::DefineBandRows(const char* s2, const unsigned int s1Length, const unsigned int s2Length, const HashRegion& hr, const unsigned int columnOffset) {
+
+	unsigned int numRows = 0;
 
 	// rowNum and column indicate the row and column numbers in the Smith-Waterman matrix respectively
 	unsigned int rowNum    = hr.QueryBegin;
@@ -114,20 +149,14 @@ void CBandedSmithWaterman::Align(Alignment& alignment, const char* s1, const uns
 
 	// upper triangle matrix in Banded Smith-Waterman
 	for( ; numBlankElements > 0; numBlankElements--, rowNum++){
-		// in the upper triangle matrix, we always start at the 0th column
-		columnNum = 0;
 
+		// in the upper triangle matrix, we always start at the 0th column
 		// columnEnd indicates how many columns which should be dealt with in the current row
-		unsigned int columnEnd = min((mBandwidth - numBlankElements), (s1Length - columnNum + 1) );
-		currentQueryGapScore = FLOAT_NEGATIVE_INFINITY;
-		for( unsigned int j = 0; j < columnEnd; j++){
-			float score = CalculateScore(s1, s2, rowNum, columnNum, currentQueryGapScore, rowOffset, columnOffset);
-			UpdateBestScore(bestRow, bestColumn, bestScore, rowNum, columnNum, score);
-			columnNum++;
-		}
+		const unsigned int columnEnd = min((mBandwidth - numBlankElements), (s1Length + 1));
+		AddBandRow(numRows, rowNum, 0, columnEnd, columnOffset, -1, s2);
 
 		// replace the columnNum to the middle column in the Smith-Waterman matrix
-		columnNum = columnNum - (mBandwidth / 2);
+		columnNum = columnEnd - (mBandwidth / 2);
 	}
 
 	// complete matrix in Banded Smith-Waterman
@@ -136,44 +165,231 @@ void CBandedSmithWaterman::Align(Alignment& alignment, const char* s1, const uns
 		columnNum = columnNum - (mBandwidth / 2);
 
 		// there are mBandwidth columns which should be dealt with in each row
-		currentQueryGapScore = FLOAT_NEGATIVE_INFINITY;
-
-		for(unsigned int j = 0; j < mBandwidth; j++){
-			float score = CalculateScore(s1, s2, rowNum, columnNum, currentQueryGapScore, rowOffset, columnOffset);
-			UpdateBestScore(bestRow, bestColumn, bestScore, rowNum, columnNum, score);
-			columnNum++;
-		}
+		AddBandRow(numRows, rowNum, columnNum, mBandwidth, columnOffset, -1, s2);
 
 		// replace the columnNum to the middle column in the Smith-Waterman matrix
 		// because mBandwidth is an odd number, everytime the following equation shifts a column (pluses 1).
-		columnNum = columnNum - (mBandwidth / 2);
+		columnNum = columnNum + mBandwidth - (mBandwidth / 2);
 	}
 
-	// lower triangle matrix
+	// lower triangle matrix: each row resets the best score after its last column
 	numBlankElements = min(mBandwidth, (s2Length - rowNum));
 	columnNum = columnNum - (mBandwidth / 2);
 	for(unsigned int i = 0; numBlankElements > 0; i++, rowNum++, numBlankElements--) {
 
-		mBestScores[ mBandwidth - i ] = FLOAT_NEGATIVE_INFINITY;;
-		// columnEnd indicates how many columns which should be dealt with
-		currentQueryGapScore = FLOAT_NEGATIVE_INFINITY;
+		const unsigned int numColumns = (columnNum < s1Length ? s1Length - columnNum : 0);
+		AddBandRow(numRows, rowNum, columnNum, numColumns, columnOffset, mBandwidth - i, s2);
 
-		for( unsigned int j = columnNum; j < s1Length; j++){
+		// replace the columnNum to the middle column in the Smith-Waterman matrix
+		columnNum = columnNum + numColumns - mBandwidth + i + 2;
+	}
+
+	// the row before the band and the padding rows do not contain any visited columns
+	for(unsigned int i = 0; i <= BSW_ROW_PADDING; i++) {
+		const unsigned int slot = (i == 0 ? 0 : numRows + i);
+		mRowBegins[slot]           = mBandwidth + 2;
+		mRowEnds[slot]             = -1;
+		mBlockedColumns[slot]      = -1;
+		mRowGapOpenPenalties[slot] = mGapOpenPenalty;
+	}
+
+	return numRows;
+}
+
+// fills the band row by row
+void CBandedSmithWaterman::FillRows(const char* s1, const char* s2, const unsigned int numRows, const unsigned int queryBegin, const unsigned int rowOffset, const unsigned int columnOffset, unsigned int& bestRow, unsigned int& bestColumn) {
+
+	float bestScore = FLOAT_NEGATIVE_INFINITY;
+	float currentQueryGapScore;
+
+	for(unsigned int slot = 1; slot <= numRows; slot++) {
+
+		const unsigned int rowNum = queryBegin + slot - 1;
+		if(mBlockedColumns[slot] >= 0) mBestScores[mBlockedColumns[slot]] = FLOAT_NEGATIVE_INFINITY;
+
+		currentQueryGapScore = FLOAT_NEGATIVE_INFINITY;
+		for(int column = mRowBegins[slot]; column <= mRowEnds[slot]; column++) {
+			const unsigned int columnNum = column + rowNum - columnOffset;
 			float score = CalculateScore(s1, s2, rowNum, columnNum, currentQueryGapScore, rowOffset, columnOffset);
 			UpdateBestScore(bestRow, bestColumn, bestScore, rowNum, columnNum, score);
-			columnNum++;
 		}
+	}
+}
 
-		// replace the columnNum to the middle column in the Smith-Waterman matrix
-		columnNum = columnNum - mBandwidth + i + 2;
+#ifdef __SSE2__
+// fills the band along its anti-diagonals using SSE2
+// N.B. the band cell (r, c) lies on anti-diagonal 2r + c. Its left (r, c - 1) and upper (r - 1, c + 1)
+// neighbors lie on the previous anti-diagonal and its diagonal neighbor (r - 1, c) on the one before,
+// so four rows of an anti-diagonal are scored at once. Every cell receives exactly the same score as
+// in FillRows and the best cell is the last maximum in row order.
+void CBandedSmithWaterman::FillAntiDiagonals(const char* s1, const char* s2, const unsigned int numRows, const unsigned int queryBegin, const unsigned int columnOffset, unsigned int& bestRow, unsigned int& bestColumn) {
+
+	const int bandwidth  = (int)mBandwidth;
+	const int numColumns = bandwidth + 2;
+	const int lastRow    = (int)numRows - 1;
+
+	// the anchor position of a band cell is its anti-diagonal minus its row plus this offset
+	const int anchorOffset = (int)(queryBegin - columnOffset);
+
+	// assign the anti-diagonal buffers (the row before the band is stored at index 0)
+	// N.B. the buffers start one entry late so that the row above the first row can be addressed
+	const unsigned int bufferSize = numRows + 2 + BSW_ROW_PADDING;
+	uninitialized_fill(mDiagonalBuffers, mDiagonalBuffers + 7 * bufferSize, FLOAT_NEGATIVE_INFINITY);
+
+	float* pBestScores[3];
+	float* pQueryGapScores[2];
+	float* pAnchorGapScores[2];
+
+	for(unsigned int i = 0; i < 3; i++) pBestScores[i] = mDiagonalBuffers + i * bufferSize + 1;
+	for(unsigned int i = 0; i < 2; i++) {
+		pQueryGapScores[i]  = mDiagonalBuffers + (3 + i) * bufferSize + 1;
+		pAnchorGapScores[i] = mDiagonalBuffers + (5 + i) * bufferSize + 1;
 	}
 
-	// =========================================
-	// Banded Smith-Waterman backtrace algorithm
-	// =========================================
+	const __m128 vZero              = _mm_setzero_ps();
+	const __m128 vNegativeInfinity  = _mm_set1_ps(FLOAT_NEGATIVE_INFINITY);
+	const __m128 vGapExtend         = _mm_set1_ps(mGapExtendPenalty);
+	const __m128i vAllBits          = _mm_set1_epi32(-1);
+	const __m128i vOne              = _mm_set1_epi32(1);
+	const __m128i vLaneColumns      = _mm_set_epi32(6, 4, 2, 0);
+	const __m128i vFirstColumn      = _mm_setzero_si128();
+	const __m128i vLastColumn       = _mm_set1_epi32(bandwidth + 1);
+	const __m128i vLeft             = _mm_set1_epi32(Directions_LEFT);
+	const __m128i vDiagonal         = _mm_set1_epi32(Directions_DIAGONAL);
+	const __m128i vUp               = _mm_set1_epi32(Directions_UP);
+	const __m128i vVerticalExtend   = _mm_set1_epi32(BSW_TRACEBACK_VERTICAL_EXTEND);
+	const __m128i vHorizontalExtend = _mm_set1_epi32(BSW_TRACEBACK_HORIZONTAL_EXTEND);
+
+	float bestScore    = FLOAT_NEGATIVE_INFINITY;
+	int bestBandRow    = -1;
+	int bestBandColumn = 0;
 
-	Traceback(alignment, s1, s2, s2Length, bestRow, bestColumn, rowOffset, columnOffset);
+	float scores[4];
+	float similarityScores[4];
+	float anchorGapOpenPenalties[4];
+
+	for(int d = -2; d <= 2 * lastRow + bandwidth + 1; d++) {
+
+		// the anti-diagonal holds the rows whose band column is between 0 and mBandwidth + 1
+		const int firstDiagonalRow = max(-1, FloorHalf(d - bandwidth));
+		const int lastDiagonalRow  = min(lastRow, FloorHalf(d));
+
+		for(int r = firstDiagonalRow; r <= lastDiagonalRow; r += 4) {
+
+			const int slot = r + 1;
+
+			// determine which lanes hold band cells that are visited by the forward algorithm
+			const __m128i vColumns   = _mm_sub_epi32(_mm_set1_epi32(d - 2 * r), vLaneColumns);
+			const __m128i vRowBegins = _mm_loadu_si128((const __m128i*)(mRowBegins + slot));
+			const __m128i vRowEnds   = _mm_loadu_si128((const __m128i*)(mRowEnds + slot));
+			const __m128i vBlocked   = _mm_loadu_si128((const __m128i*)(mBlockedColumns + slot));
+
+			const __m128 vIsVisited = _mm_castsi128_ps(_mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(vRowBegins, vColumns), _mm_cmpgt_epi32(vColumns, vRowEnds)), vAllBits));
+			const int isVisited = _mm_movemask_ps(vIsVisited);
+
+			// retrieve the similarity scores and the homo-polymer gap scores
+			for(int k = 0; k < 4; k++) {
+
+				similarityScores[k]       = 0.0f;
+				anchorGapOpenPenalties[k] = mGapOpenPenalty;
+				if((isVisited & (1 << k)) == 0) continue;
+
+				const unsigned int rowNum    = queryBegin + r + k;
+				const unsigned int columnNum = (unsigned int)(d - r - k + anchorOffset);
+
+				similarityScores[k] = mScoringMatrix[s1[columnNum] - 'A'][s2[rowNum] - 'A'];
+				if(mUseHomoPolymerGapOpenPenalty && (columnNum > 1) && (s1[columnNum] == s1[columnNum - 1]))
+					anchorGapOpenPenalties[k] = mHomoPolymerGapOpenPenalty;
+			}
+
+			// retrieve the neighboring scores: the column that the current row reset hides its cell
+			const __m128 vIsBlockedDiagonal = _mm_castsi128_ps(_mm_cmpeq_epi32(vColumns, vBlocked));
+			const __m128 vIsBlockedUp       = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_add_epi32(vColumns, vOne), vBlocked));
+
+			__m128 vDiagonalScore = _mm_loadu_ps(pBestScores[2] + slot - 1);
+			__m128 vUpScore       = _mm_loadu_ps(pBestScores[1] + slot - 1);
+			vDiagonalScore = _mm_or_ps(_mm_and_ps(vIsBlockedDiagonal, vNegativeInfinity), _mm_andnot_ps(vIsBlockedDiagonal, vDiagonalScore));
+			vUpScore       = _mm_or_ps(_mm_and_ps(vIsBlockedUp, vNegativeInfinity), _mm_andnot_ps(vIsBlockedUp, vUpScore));
+
+			const __m128 vTotalSimilarityScore = _mm_add_ps(vDiagonalScore, _mm_loadu_ps(similarityScores));
+
+			// open a gap in the query sequence
+			const __m128 vQueryGapExtendScore = _mm_sub_ps(_mm_loadu_ps(pQueryGapScores[1] + slot), vGapExtend);
+			const __m128 vQueryGapOpenScore   = _mm_sub_ps(_mm_loadu_ps(pBestScores[1] + slot), _mm_loadu_ps(mRowGapOpenPenalties + slot));
+			const __m128 vQueryGapScore       = _mm_max_ps(vQueryGapExtendScore, vQueryGapOpenScore);
+
+			// open a gap in the reference sequence
+			const __m128 vAnchorGapExtendScore = _mm_sub_ps(_mm_loadu_ps(pAnchorGapScores[1] + slot - 1), vGapExtend);
+			const __m128 vAnchorGapOpenScore   = _mm_sub_ps(vUpScore, _mm_loadu_ps(anchorGapOpenPenalties));
+			const __m128 vAnchorGapScore       = _mm_max_ps(vAnchorGapExtendScore, vAnchorGapOpenScore);
+
+			// calculate the best score and direction
+			const __m128 vBestScore = _mm_max_ps(_mm_max_ps(vTotalSimilarityScore, vQueryGapScore), _mm_max_ps(vAnchorGapScore, vZero));
+
+			// diagonal (445364713) > stop (238960195) > up (214378647) > left (166504495)
+			const __m128i vIsSimilarity = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, vTotalSimilarityScore));
+			const __m128i vIsQueryGap   = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, vQueryGapScore));
+			const __m128i vIsStop       = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, vZero));
+
+			__m128i vTraceback = _mm_or_si128(_mm_and_si128(vIsQueryGap, vLeft), _mm_andnot_si128(vIsQueryGap, vDiagonal));
+			vTraceback = _mm_or_si128(_mm_and_si128(vIsSimilarity, vUp), _mm_andnot_si128(vIsSimilarity, vTraceback));
+			vTraceback = _mm_andnot_si128(vIsStop, vTraceback);
+			vTraceback = _mm_or_si128(vTraceback, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(vAnchorGapExtendScore, vAnchorGapOpenScore)), vVerticalExtend));
+			vTraceback = _mm_or_si128(vTraceback, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(vQueryGapExtendScore, vQueryGapOpenScore)), vHorizontalExtend));
+			vTraceback = _mm_and_si128(vTraceback, _mm_castps_si128(vIsVisited));
+
+			vTraceback = _mm_packs_epi32(vTraceback, vTraceback);
+			vTraceback = _mm_packus_epi16(vTraceback, vTraceback);
+			unsigned int traceback = (unsigned int)_mm_cvtsi128_si32(vTraceback);
+
+			const int numLanes = min(4, lastDiagonalRow - r + 1);
+			for(int k = 0; k < numLanes; k++, traceback >>= 8)
+				mTraceback[(slot + k) * numColumns + d - 2 * (r + k)] = (unsigned char)traceback;
+
+			// the cells that are not visited keep the initial scores (negative infinity outside the band)
+			const __m128 vIsOutsideBand = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(vColumns, vFirstColumn), _mm_cmpeq_epi32(vColumns, vLastColumn)));
+			const __m128 vUnvisitedScore = _mm_and_ps(vIsOutsideBand, vNegativeInfinity);
+
+			_mm_storeu_ps(pBestScores[0] + slot, _mm_or_ps(_mm_and_ps(vIsVisited, vBestScore), _mm_andnot_ps(vIsVisited, vUnvisitedScore)));
+			_mm_storeu_ps(pQueryGapScores[0] + slot, _mm_or_ps(_mm_and_ps(vIsVisited, vQueryGapScore), _mm_andnot_ps(vIsVisited, vNegativeInfinity)));
+			_mm_storeu_ps(pAnchorGapScores[0] + slot, _mm_or_ps(_mm_and_ps(vIsVisited, vAnchorGapScore), _mm_andnot_ps(vIsVisited, vNegativeInfinity)));
+
+			// the best cell is the last maximum in row order
+			int isCandidate = _mm_movemask_ps(_mm_and_ps(vIsVisited, _mm_cmpge_ps(vBestScore, _mm_set1_ps(bestScore))));
+			if(isCandidate == 0) continue;
+
+			_mm_storeu_ps(scores, vBestScore);
+			for(int k = 0; isCandidate != 0; k++, isCandidate >>= 1) {
+
+				if((isCandidate & 1) == 0) continue;
+
+				const int row    = r + k;
+				const int column = d - 2 * row;
+
+				if((scores[k] > bestScore) || ((scores[k] == bestScore) && ((row > bestBandRow) || ((row == bestBandRow) && (column > bestBandColumn))))) {
+					bestScore      = scores[k];
+					bestBandRow    = row;
+					bestBandColumn = column;
+				}
+			}
+		}
+
+		// advance the anti-diagonal buffers
+		float* pOldestScores = pBestScores[2];
+		pBestScores[2] = pBestScores[1];
+		pBestScores[1] = pBestScores[0];
+		pBestScores[0] = pOldestScores;
+
+		swap(pQueryGapScores[0], pQueryGapScores[1]);
+		swap(pAnchorGapScores[0], pAnchorGapScores[1]);
+	}
+
+	if(bestBandRow >= 0) {
+		bestRow    = queryBegin + bestBandRow;
+		bestColumn = bestBandColumn + bestRow - columnOffset;
+	}
 }
+#endif
 
 // calculates the score during the forward algorithm
 float CBandedSmithWaterman::CalculateScore(const char* s1, const char* s2, const unsigned int rowNum, const unsigned int columnNum, float& currentQueryGapScore, const unsigned int rowOffset, const unsigned int columnOffset) {
@@ -199,9 +415,11 @@ float CBandedSmithWaterman::CalculateScore(const char* s1, const char* s2, const
 		if((rowNum > 1) && (s2[rowNum] == s2[rowNum - 1]))
 			queryGapOpenScore = mBestScores[column - 1] - mHomoPolymerGapOpenPenalty;
 
+	unsigned char gapExtensions = 0;
+
 	if(queryGapExtendScore > queryGapOpenScore) {
 		currentQueryGapScore = queryGapExtendScore;
-		mPointers[position].mSizeOfHorizontalGaps = mPointers[position - 1].mSizeOfHorizontalGaps + 1;
+		gapExtensions |= BSW_TRACEBACK_HORIZONTAL_EXTEND;
 	} else currentQueryGapScore = queryGapOpenScore;
 
 	// ====================================
@@ -218,7 +436,7 @@ float CBandedSmithWaterman::CalculateScore(const char* s1, const char* s2, const
 
 	if(anchorGapExtendScore > anchorGapOpenScore) {
 		mAnchorGapScores[column] = anchorGapExtendScore;
-		mPointers[position].mSizeOfVerticalGaps = mPointers[position - mBandwidth - 1].mSizeOfVerticalGaps + 1;
+		gapExtensions |= BSW_TRACEBACK_VERTICAL_EXTEND;
 	} else mAnchorGapScores[column] = anchorGapOpenScore;
 
 	// ======================================
@@ -230,10 +448,13 @@ float CBandedSmithWaterman::CalculateScore(const char* s1, const char* s2, const
 
 	// determine the traceback direction
 	// diagonal (445364713) > stop (238960195) > up (214378647) > left (166504495)
-	if(mBestScores[column] == 0)                         mPointers[position].Direction = Directions_STOP;
-	else if(mBestScores[column] == totalSimilarityScore) mPointers[position].Direction = Directions_UP;
-	else if(mBestScores[column] == currentQueryGapScore) mPointers[position].Direction = Directions_LEFT;
-	else                                                 mPointers[position].Direction = Directions_DIAGONAL;
+	DirectionType direction;
+	if(mBestScores[column] == 0)                         direction = Directions_STOP;
+	else if(mBestScores[column] == totalSimilarityScore) direction = Directions_UP;
+	else if(mBestScores[column] == currentQueryGapScore) direction = Directions_LEFT;
+	else                                                 direction = Directions_DIAGONAL;
+
+	mTraceback[position] = direction | gapExtensions;
 
 	return mBestScores[column];
 }
@@ -419,10 +640,10 @@ void CBandedSmithWaterman::ReinitializeMatrices(const PositionType& positionType
 	if( (numColumns * numRows) > mCurrentMatrixSize ) {
 
 		mCurrentMatrixSize = numColumns * numRows;
-		if(mPointers) delete [] mPointers;
+		if(mTraceback) delete [] mTraceback;
 
 		try {
-			mPointers = new ElementInfo[mCurrentMatrixSize];
+			mTraceback = new unsigned char[mCurrentMatrixSize];
 		} catch(const bad_alloc&) {
 			printf("ERROR: Unable to allocate enough memory for the banded Smith-Waterman algorithm.\n");
 			exit(1);
@@ -430,12 +651,43 @@ void CBandedSmithWaterman::ReinitializeMatrices(const PositionType& positionType
 	}
 
 	// initialize our backtrace matrix
-	ElementInfo defaultElement;
-	defaultElement.Direction = Directions_STOP;
-	defaultElement.mSizeOfHorizontalGaps = 1;
-	defaultElement.mSizeOfVerticalGaps   = 1;
+	memset(mTraceback, Directions_STOP, numColumns * numRows);
+
+	// update the size of the band row arrays
+	if( (numRows + BSW_ROW_PADDING) > mCurrentRowSize ) {
 
-	uninitialized_fill(mPointers, mPointers + mCurrentMatrixSize, defaultElement);
+		mCurrentRowSize = numRows + BSW_ROW_PADDING;
+		if(mRowBegins)           delete [] mRowBegins;
+		if(mRowEnds)             delete [] mRowEnds;
+		if(mBlockedColumns)      delete [] mBlockedColumns;
+		if(mRowGapOpenPenalties) delete [] mRowGapOpenPenalties;
+
+		try {
+			mRowBegins           = new int[mCurrentRowSize];
+			mRowEnds             = new int[mCurrentRowSize];
+			mBlockedColumns      = new int[mCurrentRowSize];
+			mRowGapOpenPenalties = new float[mCurrentRowSize];
+		} catch(const bad_alloc&) {
+			printf("ERROR: Unable to allocate enough memory for the banded Smith-Waterman algorithm.\n");
+			exit(1);
+		}
+	}
+
+#ifdef __SSE2__
+	// update the size of the anti-diagonal buffers
+	if( (7 * (numRows + 1 + BSW_ROW_PADDING)) > mCurrentDiagonalSize ) {
+
+		mCurrentDiagonalSize = 7 * (numRows + 1 + BSW_ROW_PADDING);
+		if(mDiagonalBuffers) delete [] mDiagonalBuffers;
+
+		try {
+			mDiagonalBuffers = new float[mCurrentDiagonalSize];
+		} catch(const bad_alloc&) {
+			printf("ERROR: Unable to allocate enough memory for the banded Smith-Waterman algorithm.\n");
+			exit(1);
+		}
+	}
+#endif
 
 	// update the sequence character arrays
 	if( ( s1Length + s2Length ) > mCurrentAQSumSize ) {
@@ -480,9 +732,9 @@ void CBandedSmithWaterman::Traceback(Alignment& alignment, const char* s1, const
 	while(keepProcessing) {
 		unsigned int nVerticalGap = 0;
 		unsigned int nHorizontalGap = 0;
-		switch(mPointers[currentPosition].Direction){
+		switch(mTraceback[currentPosition] & BSW_TRACEBACK_DIRECTION_MASK){
 			case Directions_DIAGONAL:
-				nVerticalGap = mPointers[currentPosition].mSizeOfVerticalGaps;
+				nVerticalGap = GetGapLength(currentPosition, BSW_TRACEBACK_VERTICAL_EXTEND, mBandwidth + 1);
 				for(unsigned int i = 0; i < nVerticalGap; i++){
 					mReversedAnchor[gappedAnchorLen++] = GAP;
 					mReversedQuery[gappedQueryLen++]   = s2[currentRow];
@@ -514,7 +766,7 @@ void CBandedSmithWaterman::Traceback(Alignment& alignment, const char* s1, const
 				break;
 
 			case Directions_LEFT:
-				nHorizontalGap =  mPointers[currentPosition].mSizeOfHorizontalGaps;
+				nHorizontalGap = GetGapLength(currentPosition, BSW_TRACEBACK_HORIZONTAL_EXTEND, 1);
 				for(unsigned int i = 0; i < nHorizontalGap; i++){
 
 					mReversedAnchor[gappedAnchorLen++] = s1[currentColumn];
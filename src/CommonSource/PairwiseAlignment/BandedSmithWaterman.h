@@ -17,20 +17,29 @@
 #include "Mosaik.h"
 #include "HashRegion.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 #define MOSAIK_NUM_NUCLEOTIDES 26
 #define GAP '-'
 
+// the banded traceback stores the direction in the lower two bits followed by the gap extension flags
+#define BSW_TRACEBACK_DIRECTION_MASK 3
+#define BSW_TRACEBACK_VERTICAL_EXTEND 4
+#define BSW_TRACEBACK_HORIZONTAL_EXTEND 8
+
+// the number of padding entries after the last band row
+#define BSW_ROW_PADDING 8
+
+// narrower bands (including the default of 9) do not fill enough of each anti-diagonal to beat the row-wise fill
+#define BSW_MIN_VECTOR_BANDWIDTH 11
+
 typedef unsigned char DirectionType;
 typedef unsigned char PositionType;
 
-struct ElementInfo {
-	unsigned int Direction             : 2;
-	unsigned int mSizeOfVerticalGaps   : 15;
-	unsigned int mSizeOfHorizontalGaps : 15;
-};
-
 class CBandedSmithWaterman {
 public:
 	// constructor
@@ -42,6 +51,18 @@ public:
 	// enables homo-polymer scoring
 	void EnableHomoPolymerGapPenalty(float hpGapOpenPenalty);
 private:
+	// records a band row that is visited by the forward algorithm
+	inline void AddBandRow(unsigned int& numRows, const unsigned int rowNum, const unsigned int columnNum, const unsigned int numColumns, const unsigned int columnOffset, const int blockedColumn, const char* s2);
+	// records the band columns that are visited in each row, returns the number of rows
+	unsigned int DefineBandRows(const char* s2, const unsigned int s1Length, const unsigned int s2Length, const HashRegion& hr, const unsigned int columnOffset);
+#ifdef __SSE2__
+	// fills the band along its anti-diagonals using SSE2
+	void FillAntiDiagonals(const char* s1, const char* s2, const unsigned int numRows, const unsigned int queryBegin, const unsigned int columnOffset, unsigned int& bestRow, unsigned int& bestColumn);
+	// returns the largest integer that is not greater than half of the specified value
+	static inline int FloorHalf(const int value);
+#endif
+	// fills the band row by row
+	void FillRows(const char* s1, const char* s2, const unsigned int numRows, const unsigned int queryBegin, const unsigned int rowOffset, const unsigned int columnOffset, unsigned int& bestRow, unsigned int& bestColumn);
 	// calculates the score during the forward algorithm
 	float CalculateScore(const char* s1, const char* s2, const unsigned int rowNum, const unsigned int columnNum, float& currentQueryGapScore, const unsigned int rowOffset, const unsigned int columnOffset);
 	// creates a simple scoring matrix to align the nucleotides and the ambiguity code N
@@ -50,6 +71,8 @@ private:
 	static void CorrectHomopolymerGapOrder(Alignment& al);
 	// returns the maximum floating point number
 	static inline float MaxFloats(const float& a, const float& b, const float& c);
+	// returns the length of the gap that ends at the specified traceback position
+	inline unsigned int GetGapLength(unsigned int position, const unsigned char extendFlag, const unsigned int positionDelta) const;
 	// reinitializes the matrices
 	void ReinitializeMatrices(const PositionType& positionType, const unsigned int& s1Length, const unsigned int& s2Length, const HashRegion& hr);
 	// performs the backtrace algorithm
@@ -68,8 +91,20 @@ private:
 	const static DirectionType Directions_LEFT;
 	const static DirectionType Directions_DIAGONAL;
 	const static DirectionType Directions_UP;
-	// store the backtrace pointers
-	ElementInfo* mPointers;
+	// store the backtrace directions and gap extension flags
+	unsigned char* mTraceback;
+	// store the first and last band column, the column reset to negative infinity (or -1) and
+	// the horizontal gap open penalty of each row (the row before the band is stored first)
+	int* mRowBegins;
+	int* mRowEnds;
+	int* mBlockedColumns;
+	float* mRowGapOpenPenalties;
+	unsigned int mCurrentRowSize;
+#ifdef __SSE2__
+	// store the scores of the last anti-diagonals (indexed by row)
+	float* mDiagonalBuffers;
+	unsigned int mCurrentDiagonalSize;
+#endif
 	// define our position types
 	const static PositionType Position_REF_AND_QUERY_ZERO;
 	const static PositionType Position_REF_ZERO;
@@ -103,6 +138,38 @@ inline float CBandedSmithWaterman::MaxFloats(const float& a, const float& b, con
 	return max;
 }
 
+// records a band row that is visited by the forward algorithm
+inline void CBandedSmithWaterman::AddBandRow(unsigned int& numRows, const unsigned int rowNum, const unsigned int columnNum, const unsigned int numColumns, const unsigned int columnOffset, const int blockedColumn, const char* s2) {
+
+	const unsigned int slot = ++numRows;
+
+	mRowBegins[slot]      = (int)(columnOffset - rowNum + columnNum);
+	mRowEnds[slot]        = mRowBegins[slot] + (int)numColumns - 1;
+	mBlockedColumns[slot] = blockedColumn;
+
+	// compute the homo-polymer gap score if enabled
+	mRowGapOpenPenalties[slot] = mGapOpenPenalty;
+	if(mUseHomoPolymerGapOpenPenalty && (rowNum > 1) && (s2[rowNum] == s2[rowNum - 1]))
+		mRowGapOpenPenalties[slot] = mHomoPolymerGapOpenPenalty;
+}
+
+// returns the length of the gap that ends at the specified traceback position
+inline unsigned int CBandedSmithWaterman::GetGapLength(unsigned int position, const unsigned char extendFlag, const unsigned int positionDelta) const {
+	unsigned int length = 1;
+	while((mTraceback[position] & extendFlag) != 0) {
+		length++;
+		position -= positionDelta;
+	}
+	return length;
+}
+
+#ifdef __SSE2__
+// returns the largest integer that is not greater than half of the specified value
+inline int CBandedSmithWaterman::FloorHalf(const int value) {
+	return (value >= 0 ? value / 2 : -((1 - value) / 2));
+}
+#endif
+
 // updates the best score during the forward algorithm
 inline void CBandedSmithWaterman::UpdateBestScore(unsigned int& bestRow, unsigned int& bestColumn, float& bestScore, const unsigned int rowNum, const unsigned int columnNum, const float score) {
 
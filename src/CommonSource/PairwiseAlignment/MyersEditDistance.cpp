@@ -0,0 +1,132 @@
+// ***************************************************************************
+// CMyersEditDistance - calculates the smallest edit distance between a read
+//                      and any substring of a reference window using the
+//                      bit-parallel algorithm of Myers (1999).
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "MyersEditDistance.h"
+
+// constructor
+CMyersEditDistance::CMyersEditDistance(void)
+: mBitVectors(NULL)
+, mCurrentBitVectorSize(0)
+, mNumWords(0)
+{}
+
+// destructor
+CMyersEditDistance::~CMyersEditDistance(void) {
+	if(mBitVectors) delete [] mBitVectors;
+}
+
+// creates the match masks for the query and resets the vertical deltas
+// N.B. bases other than A, C, G and T match everything, so the distance never exceeds
+// the number of mismatched and gapped bases counted by the Smith-Waterman aligners
+void CMyersEditDistance::InitializeQuery(const char* s2, const unsigned int s2Length) {
+
+	mNumWords = (s2Length + MYERS_WORD_SIZE - 1) / MYERS_WORD_SIZE;
+
+	// reinitialize our bit vectors
+	const unsigned int bitVectorSize = mNumWords * (MYERS_NUM_BASES + 2);
+
+	if(bitVectorSize > mCurrentBitVectorSize) {
+
+		mCurrentBitVectorSize = bitVectorSize;
+		if(mBitVectors) delete [] mBitVectors;
+
+		try {
+			mBitVectors = new uint64_t[mCurrentBitVectorSize];
+		} catch(const bad_alloc&) {
+			cout << "ERROR: Unable to allocate enough memory for the edit distance prefilter." << endl;
+			exit(1);
+		}
+	}
+
+	memset(mBitVectors, 0, mNumWords * MYERS_NUM_BASES * sizeof(uint64_t));
+
+	for(unsigned int i = 0; i < s2Length; i++) {
+		const uint64_t bit      = (uint64_t)1 << (i % MYERS_WORD_SIZE);
+		const unsigned int word = i / MYERS_WORD_SIZE;
+		const unsigned int b    = GetBaseIndex(s2[i]);
+
+		if(b == MYERS_NUM_BASES) {
+			for(unsigned int k = 0; k < MYERS_NUM_BASES; k++) mBitVectors[k * mNumWords + word] |= bit;
+		} else mBitVectors[b * mNumWords + word] |= bit;
+	}
+
+	// every query position starts one edit below the previous one
+	uint64_t* pPositiveDeltas = mBitVectors + mNumWords * MYERS_NUM_BASES;
+	uint64_t* pNegativeDeltas = pPositiveDeltas + mNumWords;
+
+	for(unsigned int w = 0; w < mNumWords; w++) {
+		pPositiveDeltas[w] = ~(uint64_t)0;
+		pNegativeDeltas[w] = 0;
+	}
+}
+
+// returns the smallest edit distance between the query and any substring of the anchor
+// N.B. the query words are processed as blocks (Hyyro 2003) that pass their horizontal delta to the
+// next word. The anchor may start anywhere, so the first word always receives a zero delta.
+unsigned int CMyersEditDistance::CalculateMinDistance(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const unsigned int maxDistance) {
+
+	if(s2Length == 0) return 0;
+
+	InitializeQuery(s2, s2Length);
+
+	uint64_t* pPositiveDeltas = mBitVectors + mNumWords * MYERS_NUM_BASES;
+	uint64_t* pNegativeDeltas = pPositiveDeltas + mNumWords;
+
+	const uint64_t allMatches  = ~(uint64_t)0;
+	const uint64_t highBit     = (uint64_t)1 << (MYERS_WORD_SIZE - 1);
+	const uint64_t lastRowBit  = (uint64_t)1 << ((s2Length - 1) % MYERS_WORD_SIZE);
+	const unsigned int lastWord = mNumWords - 1;
+
+	unsigned int score    = s2Length;
+	unsigned int minScore = s2Length;
+
+	for(unsigned int j = 0; (j < s1Length) && (minScore > maxDistance); j++) {
+
+		const unsigned int b = GetBaseIndex(s1[j]);
+		const uint64_t* pMatches = (b == MYERS_NUM_BASES ? NULL : mBitVectors + b * mNumWords);
+
+		int horizontalDelta = 0;
+
+		for(unsigned int w = 0; w < mNumWords; w++) {
+
+			const uint64_t pv = pPositiveDeltas[w];
+			const uint64_t mv = pNegativeDeltas[w];
+
+			uint64_t eq = (pMatches ? pMatches[w] : allMatches);
+			const uint64_t xv = eq | mv;
+			if(horizontalDelta < 0) eq |= 1;
+
+			const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+			uint64_t ph = mv | ~(xh | pv);
+			uint64_t mh = pv & xh;
+
+			// the horizontal delta of the last row in this word
+			const uint64_t outBit = (w == lastWord ? lastRowBit : highBit);
+			const int outDelta = ((ph & outBit) != 0 ? 1 : ((mh & outBit) != 0 ? -1 : 0));
+
+			ph <<= 1;
+			mh <<= 1;
+			if(horizontalDelta < 0) mh |= 1;
+			else if(horizontalDelta > 0) ph |= 1;
+
+			pPositiveDeltas[w] = mh | ~(xv | ph);
+			pNegativeDeltas[w] = ph & xv;
+
+			horizontalDelta = outDelta;
+		}
+
+		score += horizontalDelta;
+		if(score < minScore) minScore = score;
+	}
+
+	return minScore;
+}
@@ -0,0 +1,63 @@
+// ***************************************************************************
+// CMyersEditDistance - calculates the smallest edit distance between a read
+//                      and any substring of a reference window using the
+//                      bit-parallel algorithm of Myers (1999).
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <cstring>
+#include <iostream>
+#include "Mosaik.h"
+
+using namespace std;
+
+// the number of query positions stored in each bit-vector word
+#define MYERS_WORD_SIZE 64
+
+// the match masks are stored for A, C, G and T
+#define MYERS_NUM_BASES 4
+
+class CMyersEditDistance {
+public:
+	// constructor
+	CMyersEditDistance(void);
+	// destructor
+	~CMyersEditDistance(void);
+	// returns the smallest edit distance between the query and any substring of the anchor
+	// N.B. stops as soon as a distance of at most maxDistance is found
+	unsigned int CalculateMinDistance(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const unsigned int maxDistance);
+
+private:
+	// returns the match mask index of the specified base (MYERS_NUM_BASES for everything else)
+	static inline unsigned int GetBaseIndex(const char base);
+	// creates the match masks for the query and resets the vertical deltas
+	void InitializeQuery(const char* s2, const unsigned int s2Length);
+	// the match masks of each base followed by the positive and negative vertical deltas
+	uint64_t* mBitVectors;
+	unsigned int mCurrentBitVectorSize;
+	// the number of words needed for the current query
+	unsigned int mNumWords;
+};
+
+// returns the match mask index of the specified base (MYERS_NUM_BASES for everything else)
+inline unsigned int CMyersEditDistance::GetBaseIndex(const char base) {
+	switch(base) {
+		case 'A':
+			return 0;
+		case 'C':
+			return 1;
+		case 'G':
+			return 2;
+		case 'T':
+			return 3;
+		default:
+			return MYERS_NUM_BASES;
+	}
+}
@@ -34,6 +34,13 @@ CSmithWatermanGotoh::CSmithWatermanGotoh(float matchScore, float mismatchScore,
 , mReversedAnchor(NULL)
 , mReversedQuery(NULL)
 , mUseHomoPolymerGapOpenPenalty(false)
+#ifdef __SSE2__
+, mStripedVectors(NULL)
+, mCurrentStripedSize(0)
+, mNumSegments(0)
+, mTraceback(NULL)
+, mCurrentTracebackSize(0)
+#endif
 {
 	CreateScoringMatrix();
 }
@@ -46,6 +53,10 @@ CSmithWatermanGotoh::~CSmithWatermanGotoh(void) {
 	if(mBestScores)            delete [] mBestScores;
 	if(mReversedAnchor)        delete [] mReversedAnchor;
 	if(mReversedQuery)         delete [] mReversedQuery;
+#ifdef __SSE2__
+	if(mStripedVectors)        delete [] mStripedVectors;
+	if(mTraceback)             delete [] mTraceback;
+#endif
 }
 
 // aligns the query sequence to the reference using the Smith Waterman Gotoh algorithm
@@ -56,6 +67,91 @@ void CSmithWatermanGotoh::Align(Alignment& alignment, const char* s1, const unsi
 		exit(1);
 	}
 
+#ifdef __SSE2__
+	AlignStriped(alignment, s1, s1Length, s2, s2Length);
+#else
+	AlignScalar(alignment, s1, s1Length, s2, s2Length);
+#endif
+}
+
+// returns the best local alignment score and the query position where it ends without performing the traceback
+// N.B. the best cell is the same one that Align would trace back from
+float CSmithWatermanGotoh::CalculateBestScore(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, unsigned int& queryEnd) {
+
+	if((s1Length == 0) || (s2Length == 0)) {
+		cout << "ERROR: Found a read with a zero length." << endl;
+		exit(1);
+	}
+
+	unsigned int BestColumn = 0;
+	unsigned int BestRow    = 0;
+
+#ifdef __SSE2__
+	const float BestScore = FillStriped(s1, s1Length, s2, s2Length, false, BestRow, BestColumn);
+#else
+	// reinitialize our query-dependent arrays
+	ReserveQueryScores(s2Length);
+
+	// initialize the gap score and score vectors
+	uninitialized_fill(mQueryGapScores, mQueryGapScores + s2Length + 1, FLOAT_NEGATIVE_INFINITY);
+	memset((char*)mBestScores, 0, SIZEOF_FLOAT * (s2Length + 1));
+
+	float BestScore = FLOAT_NEGATIVE_INFINITY;
+
+	for(unsigned int i = 1; i <= s1Length; i++) {
+
+		float currentAnchorGapScore = FLOAT_NEGATIVE_INFINITY;
+		float bestScoreDiagonal     = mBestScores[0];
+
+		// compute the homo-polymer gap score if enabled
+		float anchorGapOpenPenalty = mGapOpenPenalty;
+		if(mUseHomoPolymerGapOpenPenalty && (i > 1) && (s1[i - 1] == s1[i - 2]))
+			anchorGapOpenPenalty = mHomoPolymerGapOpenPenalty;
+
+		for(unsigned int j = 1; j <= s2Length; j++) {
+
+			const float totalSimilarityScore = bestScoreDiagonal + mScoringMatrix[s1[i - 1] - 'A'][s2[j - 1] - 'A'];
+
+			// compute the homo-polymer gap score if enabled
+			float queryGapOpenPenalty = mGapOpenPenalty;
+			if(mUseHomoPolymerGapOpenPenalty && (j > 1) && (s2[j - 1] == s2[j - 2]))
+				queryGapOpenPenalty = mHomoPolymerGapOpenPenalty;
+
+			const float queryGapExtendScore = mQueryGapScores[j] - mGapExtendPenalty;
+			const float queryGapOpenScore   = mBestScores[j] - queryGapOpenPenalty;
+			mQueryGapScores[j] = (queryGapExtendScore > queryGapOpenScore ? queryGapExtendScore : queryGapOpenScore);
+
+			const float referenceGapExtendScore = currentAnchorGapScore - mGapExtendPenalty;
+			const float referenceGapOpenScore   = mBestScores[j - 1] - anchorGapOpenPenalty;
+			currentAnchorGapScore = (referenceGapExtendScore > referenceGapOpenScore ? referenceGapExtendScore : referenceGapOpenScore);
+
+			bestScoreDiagonal = mBestScores[j];
+			mBestScores[j] = MaxFloats(totalSimilarityScore, mQueryGapScores[j], currentAnchorGapScore);
+
+			if(mBestScores[j] > BestScore) {
+				BestRow    = i;
+				BestColumn = j;
+				BestScore  = mBestScores[j];
+			}
+		}
+	}
+#endif
+
+	queryEnd = BestColumn - 1;
+	return BestScore;
+}
+
+// returns the largest score reduction that a single mismatched or gapped base can cause
+// N.B. a mismatch costs the match it replaces and an inserted query base also costs its gap penalty
+float CSmithWatermanGotoh::GetMaxMismatchPenalty(void) const {
+	float gapPenalty = max(mGapOpenPenalty, mGapExtendPenalty);
+	if(mUseHomoPolymerGapOpenPenalty) gapPenalty = max(gapPenalty, mHomoPolymerGapOpenPenalty);
+	return max(mMatchScore - mMismatchScore, mMatchScore + gapPenalty);
+}
+
+// aligns the query sequence to the reference using the full dynamic programming matrices
+void CSmithWatermanGotoh::AlignScalar(Alignment& alignment, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length) {
+
 	unsigned int referenceLen      = s1Length + 1;
 	unsigned int queryLen          = s2Length + 1;
 	unsigned int sequenceSumLength = s1Length + s2Length;
@@ -98,48 +194,10 @@ void CSmithWatermanGotoh::Align(Alignment& alignment, const char* s1, const unsi
 	//
 
 	// reinitialize our query-dependent arrays
-	if(s2Length > mCurrentQuerySize) {
-
-		// calculate the new query array size
-		mCurrentQuerySize = s2Length;
-
-		// delete the old arrays
-		if(mQueryGapScores) delete [] mQueryGapScores;
-		if(mBestScores)     delete [] mBestScores;
-
-		// initialize the arrays
-		try {
-
-			mQueryGapScores = new float[mCurrentQuerySize + 1];
-			mBestScores     = new float[mCurrentQuerySize + 1];
-
-		} catch(const bad_alloc&) {
-			cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
-			exit(1);
-		}
-	}
+	ReserveQueryScores(s2Length);
 
 	// reinitialize our reference+query-dependent arrays
-	if(sequenceSumLength > mCurrentAQSumSize) {
-
-		// calculate the new reference array size
-		mCurrentAQSumSize = sequenceSumLength;
-
-		// delete the old arrays
-		if(mReversedAnchor) delete [] mReversedAnchor;
-		if(mReversedQuery)  delete [] mReversedQuery;
-
-		// initialize the arrays
-		try {
-
-			mReversedAnchor = new char[mCurrentAQSumSize + 1];	// reversed sequence #1
-			mReversedQuery  = new char[mCurrentAQSumSize + 1];	// reversed sequence #2
-
-		} catch(const bad_alloc&) {
-			cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
-			exit(1);
-		}
-	}
+	ReserveReversedSequences(sequenceSumLength);
 
 	// initialize the gap score and score vectors
 	uninitialized_fill(mQueryGapScores, mQueryGapScores + queryLen, FLOAT_NEGATIVE_INFINITY);
@@ -274,9 +332,97 @@ void CSmithWatermanGotoh::Align(Alignment& alignment, const char* s1, const unsi
 		}
 	}
 
-	// define the reference and query sequences
-	mReversedAnchor[gappedAnchorLen] = 0;
-	mReversedQuery[gappedQueryLen]   = 0;
+	// catch sequences with different lengths
+	if(gappedAnchorLen != gappedQueryLen) {
+		cout << "ERROR: The aligned sequences have different lengths after Smith-Waterman-Gotoh algorithm." << endl;
+		exit(1);
+	}
+
+	SetAlignment(alignment, gappedAnchorLen, ci, BestRow, cj, BestColumn, s2Length, numMismatches, hasGap);
+}
+
+#ifdef __SSE2__
+// aligns the query sequence to the reference using a striped SSE2 kernel and a compact traceback
+// N.B. the query positions are striped across four float lanes (Farrar 2007). Every cell receives
+// exactly the same score as in AlignScalar, so the best cell and the traceback are identical.
+void CSmithWatermanGotoh::AlignStriped(Alignment& alignment, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length) {
+
+	unsigned int BestColumn = 0;
+	unsigned int BestRow    = 0;
+
+	FillStriped(s1, s1Length, s2, s2Length, true, BestRow, BestColumn);
+
+	ReserveReversedSequences(s1Length + s2Length);
+
+	//
+	// traceback
+	//
+
+	// aligned sequences
+	int gappedAnchorLen  = 0;   // length of sequence #1 after alignment
+	int gappedQueryLen   = 0;   // length of sequence #2 after alignment
+	int numMismatches    = 0;   // the mismatched nucleotide count
+
+	char c1, c2;
+
+	int ci = BestRow;
+	int cj = BestColumn;
+
+	// traceback flag
+	bool keepProcessing = true;
+	bool hasGap = false;
+
+	while(keepProcessing) {
+
+		// diagonal (445364713) > stop (238960195) > up (214378647) > left (166504495)
+		switch(GetStripedTraceback(ci, cj) & SW_TRACEBACK_DIRECTION_MASK) {
+
+			case Directions_DIAGONAL:
+				c1 = s1[--ci];
+				c2 = s2[--cj];
+
+				mReversedAnchor[gappedAnchorLen++] = c1;
+				mReversedQuery[gappedQueryLen++]   = c2;
+
+				// increment our mismatch counter
+				if(mScoringMatrix[c1 - 'A'][c2 - 'A'] == mMismatchScore) numMismatches++;	
+				break;
+
+			case Directions_STOP:
+				keepProcessing = false;
+				break;
+
+			case Directions_UP:
+				{
+					// the gap continues upwards while its cells extended the gap above them
+					unsigned int len = 1;
+					while((GetStripedTraceback(ci - len + 1, cj) & SW_TRACEBACK_VERTICAL_EXTEND) != 0) len++;
+
+					for(unsigned int l = 0; l < len; l++) {
+						mReversedAnchor[gappedAnchorLen++] = s1[--ci];
+						mReversedQuery[gappedQueryLen++]   = GAP;
+						numMismatches++;
+					}
+				}
+				hasGap = true;
+				break;
+
+			case Directions_LEFT:
+				{
+					// the gap continues leftwards while its cells extended the gap beside them
+					unsigned int len = 1;
+					while((GetStripedTraceback(ci, cj - len + 1) & SW_TRACEBACK_HORIZONTAL_EXTEND) != 0) len++;
+
+					for(unsigned int l = 0; l < len; l++) {
+						mReversedAnchor[gappedAnchorLen++] = GAP;
+						mReversedQuery[gappedQueryLen++]   = s2[--cj];
+						numMismatches++;
+					}
+				}
+				hasGap = true;
+				break;
+		}
+	}
 
 	// catch sequences with different lengths
 	if(gappedAnchorLen != gappedQueryLen) {
@@ -284,24 +430,317 @@ void CSmithWatermanGotoh::Align(Alignment& alignment, const char* s1, const unsi
 		exit(1);
 	}
 
+	SetAlignment(alignment, gappedAnchorLen, ci, BestRow, cj, BestColumn, s2Length, numMismatches, hasGap);
+}
+
+// fills the striped matrices and returns the best score along with its cell
+// N.B. the traceback is only stored when requested; the score-only pass skips its
+// direction and gap extension bookkeeping entirely.
+float CSmithWatermanGotoh::FillStriped(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const bool storeTraceback, unsigned int& bestRow, unsigned int& bestColumn) {
+
+	const unsigned int numSegments = (s2Length + 3) / 4;
+	mNumSegments = numSegments;
+
+	// reinitialize our striped vectors: seven row vectors and the query profiles
+	const unsigned int stripedSize = numSegments * (7 + MOSAIK_NUM_NUCLEOTIDES);
+
+	if(stripedSize > mCurrentStripedSize) {
+
+		mCurrentStripedSize = stripedSize;
+		if(mStripedVectors) delete [] mStripedVectors;
+
+		try {
+			mStripedVectors = new __m128[mCurrentStripedSize];
+		} catch(const bad_alloc&) {
+			cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
+			exit(1);
+		}
+	}
+
+	// reinitialize our traceback
+	const unsigned int tracebackSize = s1Length * numSegments * 4;
+
+	if(storeTraceback && (tracebackSize > mCurrentTracebackSize)) {
+
+		mCurrentTracebackSize = tracebackSize;
+		if(mTraceback) delete [] mTraceback;
+
+		try {
+			mTraceback = new unsigned char[mCurrentTracebackSize];
+		} catch(const bad_alloc&) {
+			cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
+			exit(1);
+		}
+	}
+
+	// assign the striped row vectors
+	__m128* pBestScores            = mStripedVectors;
+	__m128* pQueryGapScores        = pBestScores + numSegments;
+	__m128* pAnchorGapScores       = pQueryGapScores + numSegments;
+	__m128* pSimilarityScores      = pAnchorGapScores + numSegments;
+	__m128* pQueryGapExtensions    = pSimilarityScores + numSegments;
+	__m128* pQueryGapOpenPenalties = pQueryGapExtensions + numSegments;
+	__m128* pQueryMasks            = pQueryGapOpenPenalties + numSegments;
+
+	for(unsigned int r = 0; r < MOSAIK_NUM_NUCLEOTIDES; r++) mpQueryProfiles[r] = NULL;
+
+	// initialize the striped query-dependent vectors
+	float gapOpenPenalties[4];
+	unsigned int queryMasks[4];
+
+	for(unsigned int s = 0; s < numSegments; s++) {
+		for(unsigned int k = 0; k < 4; k++) {
+			const unsigned int position = k * numSegments + s;
+
+			// compute the homo-polymer gap score if enabled
+			gapOpenPenalties[k] = mGapOpenPenalty;
+			if(mUseHomoPolymerGapOpenPenalty && (position > 0) && (position < s2Length) && (s2[position] == s2[position - 1]))
+				gapOpenPenalties[k] = mHomoPolymerGapOpenPenalty;
+
+			queryMasks[k] = (position < s2Length ? 0xffffffff : 0);
+		}
+
+		pBestScores[s]            = _mm_setzero_ps();
+		pQueryGapScores[s]        = _mm_set1_ps(FLOAT_NEGATIVE_INFINITY);
+		pQueryGapOpenPenalties[s] = _mm_loadu_ps(gapOpenPenalties);
+		pQueryMasks[s]            = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)queryMasks));
+	}
+
+	const __m128 vZero             = _mm_setzero_ps();
+	const __m128 vNegativeInfinity = _mm_set1_ps(FLOAT_NEGATIVE_INFINITY);
+	const __m128 vGapExtend        = _mm_set1_ps(mGapExtendPenalty);
+	const __m128i vLeft            = _mm_set1_epi32(Directions_LEFT);
+	const __m128i vDiagonal        = _mm_set1_epi32(Directions_DIAGONAL);
+	const __m128i vUp              = _mm_set1_epi32(Directions_UP);
+	const __m128i vVerticalExtend  = _mm_set1_epi32(SW_TRACEBACK_VERTICAL_EXTEND);
+	const __m128i vHorizontalExtend = _mm_set1_epi32(SW_TRACEBACK_HORIZONTAL_EXTEND);
+
+	float BestScore = FLOAT_NEGATIVE_INFINITY;
+
+	for(unsigned int i = 1; i <= s1Length; i++) {
+
+		const __m128* pProfile = GetQueryProfile(s1[i - 1], s2, s2Length);
+
+		// compute the homo-polymer gap score if enabled
+		float anchorGapOpenPenalty = mGapOpenPenalty;
+		if(mUseHomoPolymerGapOpenPenalty && (i > 1) && (s1[i - 1] == s1[i - 2]))
+			anchorGapOpenPenalty = mHomoPolymerGapOpenPenalty;
+
+		const __m128 vAnchorGapOpen = _mm_set1_ps(anchorGapOpenPenalty);
+
+		// the first query position opens its gap from the zero column
+		float firstAnchorGapScore = FLOAT_NEGATIVE_INFINITY - mGapExtendPenalty;
+		if(0.0f - anchorGapOpenPenalty >= firstAnchorGapScore) firstAnchorGapScore = 0.0f - anchorGapOpenPenalty;
+		const __m128 vFirstAnchorGapScore = _mm_set_ss(firstAnchorGapScore);
+
+		__m128 vAnchorGapScore    = _mm_move_ss(vNegativeInfinity, vFirstAnchorGapScore);
+		__m128 vBestScoreDiagonal = ShiftStripedLanes(pBestScores[numSegments - 1], vZero);
+
+		// fill the row assuming that no anchor gap crosses a segment boundary
+		for(unsigned int s = 0; s < numSegments; s++) {
+
+			const __m128 vPreviousBestScore = pBestScores[s];
+
+			const __m128 vQueryGapExtendScore = _mm_sub_ps(pQueryGapScores[s], vGapExtend);
+			const __m128 vQueryGapOpenScore   = _mm_sub_ps(vPreviousBestScore, pQueryGapOpenPenalties[s]);
+			const __m128 vQueryGapScore       = _mm_max_ps(vQueryGapExtendScore, vQueryGapOpenScore);
+
+			pQueryGapScores[s]     = vQueryGapScore;
+			pQueryGapExtensions[s] = _mm_cmpgt_ps(vQueryGapExtendScore, vQueryGapOpenScore);
+
+			const __m128 vTotalSimilarityScore = _mm_add_ps(vBestScoreDiagonal, pProfile[s]);
+			pSimilarityScores[s] = vTotalSimilarityScore;
+
+			const __m128 vBestScore = _mm_max_ps(_mm_max_ps(vTotalSimilarityScore, vQueryGapScore), _mm_max_ps(vAnchorGapScore, vZero));
+			pBestScores[s]      = vBestScore;
+			pAnchorGapScores[s] = vAnchorGapScore;
+
+			vAnchorGapScore    = _mm_max_ps(_mm_sub_ps(vBestScore, vAnchorGapOpen), _mm_sub_ps(vAnchorGapScore, vGapExtend));
+			vBestScoreDiagonal = vPreviousBestScore;
+		}
+
+		// carry the anchor gaps across the segment boundaries until they no longer improve a cell
+		vAnchorGapScore = ShiftStripedLanes(vAnchorGapScore, vFirstAnchorGapScore);
+
+		for(unsigned int s = 0;;) {
+
+			const __m128 vPreviousAnchorGapScore = pAnchorGapScores[s];
+			if(_mm_movemask_ps(_mm_cmpgt_ps(vAnchorGapScore, vPreviousAnchorGapScore)) == 0) break;
+
+			vAnchorGapScore     = _mm_max_ps(vAnchorGapScore, vPreviousAnchorGapScore);
+			pAnchorGapScores[s] = vAnchorGapScore;
+
+			const __m128 vBestScore = _mm_max_ps(pBestScores[s], vAnchorGapScore);
+			pBestScores[s] = vBestScore;
+
+			vAnchorGapScore = _mm_max_ps(_mm_sub_ps(vBestScore, vAnchorGapOpen), _mm_sub_ps(vAnchorGapScore, vGapExtend));
+
+			if(++s == numSegments) {
+				s = 0;
+				vAnchorGapScore = ShiftStripedLanes(vAnchorGapScore, vFirstAnchorGapScore);
+			}
+		}
+
+		// determine the traceback directions and gap extensions
+		// diagonal (445364713) > stop (238960195) > up (214378647) > left (166504495)
+		if(storeTraceback) {
+
+			unsigned char* pTraceback  = mTraceback + (i - 1) * numSegments * 4;
+			__m128 vLeftBestScore       = ShiftStripedLanes(pBestScores[numSegments - 1], vZero);
+			__m128 vLeftAnchorGapScore  = ShiftStripedLanes(pAnchorGapScores[numSegments - 1], vNegativeInfinity);
+
+			for(unsigned int s = 0; s < numSegments; s++) {
+
+				const __m128 vBestScore = pBestScores[s];
+
+				const __m128 vAnchorGapExtension = _mm_cmpgt_ps(_mm_sub_ps(vLeftAnchorGapScore, vGapExtend), _mm_sub_ps(vLeftBestScore, vAnchorGapOpen));
+				const __m128i vIsUp       = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, pQueryGapScores[s]));
+				const __m128i vIsDiagonal = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, pSimilarityScores[s]));
+				const __m128i vIsStop     = _mm_castps_si128(_mm_cmpeq_ps(vBestScore, vZero));
+
+				__m128i vTraceback = _mm_or_si128(_mm_and_si128(vIsUp, vUp), _mm_andnot_si128(vIsUp, vLeft));
+				vTraceback = _mm_or_si128(_mm_and_si128(vIsDiagonal, vDiagonal), _mm_andnot_si128(vIsDiagonal, vTraceback));
+				vTraceback = _mm_andnot_si128(vIsStop, vTraceback);
+				vTraceback = _mm_or_si128(vTraceback, _mm_and_si128(_mm_castps_si128(pQueryGapExtensions[s]), vVerticalExtend));
+				vTraceback = _mm_or_si128(vTraceback, _mm_and_si128(_mm_castps_si128(vAnchorGapExtension), vHorizontalExtend));
+
+				vTraceback = _mm_packs_epi32(vTraceback, vTraceback);
+				vTraceback = _mm_packus_epi16(vTraceback, vTraceback);
+				const int traceback = _mm_cvtsi128_si32(vTraceback);
+				memcpy(pTraceback + s * 4, &traceback, 4);
+
+				vLeftBestScore      = vBestScore;
+				vLeftAnchorGapScore = pAnchorGapScores[s];
+			}
+		}
+
+		// find the best score in this row
+		__m128 vRowBestScore = vZero;
+		for(unsigned int s = 0; s < numSegments; s++)
+			vRowBestScore = _mm_max_ps(vRowBestScore, _mm_and_ps(pBestScores[s], pQueryMasks[s]));
+
+		vRowBestScore = _mm_max_ps(vRowBestScore, _mm_shuffle_ps(vRowBestScore, vRowBestScore, _MM_SHUFFLE(2, 3, 0, 1)));
+		vRowBestScore = _mm_max_ps(vRowBestScore, _mm_shuffle_ps(vRowBestScore, vRowBestScore, _MM_SHUFFLE(1, 0, 3, 2)));
+		const float rowBestScore = _mm_cvtss_f32(vRowBestScore);
+
+		// set the traceback start at the first query position with the best score in this row
+		if(rowBestScore > BestScore) {
+
+			unsigned int bestPosition = s2Length;
+
+			for(unsigned int s = 0; (s < numSegments) && (bestPosition >= numSegments); s++) {
+				int isBest = _mm_movemask_ps(_mm_and_ps(_mm_cmpeq_ps(pBestScores[s], vRowBestScore), pQueryMasks[s]));
+				for(unsigned int k = 0; isBest != 0; k++, isBest >>= 1) {
+					const unsigned int position = k * numSegments + s;
+					if(((isBest & 1) != 0) && (position < bestPosition)) bestPosition = position;
+				}
+			}
+
+			bestRow    = i;
+			bestColumn = bestPosition + 1;
+			BestScore  = rowBestScore;
+		}
+	}
+
+	return BestScore;
+}
+
+// returns the striped query profile for the specified reference base
+const __m128* CSmithWatermanGotoh::GetQueryProfile(const char referenceBase, const char* s2, const unsigned int s2Length) {
+
+	const unsigned int r = referenceBase - 'A';
+	if(mpQueryProfiles[r]) return mpQueryProfiles[r];
+
+	// the profiles follow the seven striped row vectors
+	__m128* pProfile = mStripedVectors + mNumSegments * (7 + r);
+	float scores[4];
+
+	for(unsigned int s = 0; s < mNumSegments; s++) {
+		for(unsigned int k = 0; k < 4; k++) {
+			const unsigned int position = k * mNumSegments + s;
+			scores[k] = (position < s2Length ? mScoringMatrix[r][s2[position] - 'A'] : FLOAT_NEGATIVE_INFINITY);
+		}
+		pProfile[s] = _mm_loadu_ps(scores);
+	}
+
+	mpQueryProfiles[r] = pProfile;
+	return pProfile;
+}
+#endif
+
+// reserves the gap score and best score vectors used by the scalar fill
+void CSmithWatermanGotoh::ReserveQueryScores(const unsigned int s2Length) {
+
+	if(s2Length <= mCurrentQuerySize) return;
+
+	// calculate the new query array size
+	mCurrentQuerySize = s2Length;
+
+	// delete the old arrays
+	if(mQueryGapScores) delete [] mQueryGapScores;
+	if(mBestScores)     delete [] mBestScores;
+
+	// initialize the arrays
+	try {
+
+		mQueryGapScores = new float[mCurrentQuerySize + 1];
+		mBestScores     = new float[mCurrentQuerySize + 1];
+
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
+		exit(1);
+	}
+}
+
+// reserves the buffers used for the reversed alignment
+void CSmithWatermanGotoh::ReserveReversedSequences(const unsigned int sequenceSumLength) {
+
+	if(sequenceSumLength <= mCurrentAQSumSize) return;
+
+	// calculate the new reference array size
+	mCurrentAQSumSize = sequenceSumLength;
+
+	// delete the old arrays
+	if(mReversedAnchor) delete [] mReversedAnchor;
+	if(mReversedQuery)  delete [] mReversedQuery;
+
+	// initialize the arrays
+	try {
+
+		mReversedAnchor = new char[mCurrentAQSumSize + 1];	// reversed sequence #1
+		mReversedQuery  = new char[mCurrentAQSumSize + 1];	// reversed sequence #2
+
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the Smith-Waterman algorithm." << endl;
+		exit(1);
+	}
+}
+
+// copies the reversed alignment and its coordinates into the alignment
+void CSmithWatermanGotoh::SetAlignment(Alignment& alignment, const int gappedLength, const unsigned int referenceBegin, const unsigned int bestRow, const unsigned int queryBegin, const unsigned int bestColumn, const unsigned int s2Length, const int numMismatches, const bool hasGap) {
+
+	// define the reference and query sequences
+	mReversedAnchor[gappedLength] = 0;
+	mReversedQuery[gappedLength]  = 0;
+
 	// reverse the strings and assign them to our alignment structure
-	reverse(mReversedAnchor, mReversedAnchor + gappedAnchorLen);
-	reverse(mReversedQuery,  mReversedQuery  + gappedQueryLen);
+	reverse(mReversedAnchor, mReversedAnchor + gappedLength);
+	reverse(mReversedQuery,  mReversedQuery  + gappedLength);
 
 	alignment.Reference = mReversedAnchor;
 	alignment.Query     = mReversedQuery;
 
 	// set the reference endpoints
-	alignment.ReferenceBegin = ci;
-	alignment.ReferenceEnd   = BestRow - 1;
+	alignment.ReferenceBegin = referenceBegin;
+	alignment.ReferenceEnd   = bestRow - 1;
 
 	// set the query endpoints
 	if(alignment.IsReverseStrand) {
-		alignment.QueryBegin = s2Length - BestColumn;
-		alignment.QueryEnd   = s2Length - cj - 1;
+		alignment.QueryBegin = s2Length - bestColumn;
+		alignment.QueryEnd   = s2Length - queryBegin - 1;
 	} else {
-		alignment.QueryBegin = cj;
-		alignment.QueryEnd   = BestColumn - 1;
+		alignment.QueryBegin = queryBegin;
+		alignment.QueryEnd   = bestColumn - 1;
 	}
 
 	// set the query length and number of mismatches
@@ -16,11 +16,20 @@
 #include "Alignment.h"
 #include "Mosaik.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 #define MOSAIK_NUM_NUCLEOTIDES 26
 #define GAP '-'
 
+// the striped traceback stores the direction in the lower two bits followed by the gap extension flags
+#define SW_TRACEBACK_DIRECTION_MASK 3
+#define SW_TRACEBACK_VERTICAL_EXTEND 4
+#define SW_TRACEBACK_HORIZONTAL_EXTEND 8
+
 class CSmithWatermanGotoh {
 public:
 	// constructor
@@ -29,14 +38,38 @@ public:
 	~CSmithWatermanGotoh(void);
 	// aligns the query sequence to the reference using the Smith Waterman Gotoh algorithm
 	void Align(Alignment& alignment, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length);
+	// returns the best local alignment score and the query position where it ends without performing the traceback
+	float CalculateBestScore(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, unsigned int& queryEnd);
+	// returns the largest score reduction that a single mismatched or gapped base can cause
+	float GetMaxMismatchPenalty(void) const;
 	// enables homo-polymer scoring
 	void EnableHomoPolymerGapPenalty(float hpGapOpenPenalty);
 
 #ifndef WINUNIT
 private:
+#endif
+	// aligns the query sequence to the reference using the full dynamic programming matrices
+	void AlignScalar(Alignment& alignment, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length);
+#ifdef __SSE2__
+	// aligns the query sequence to the reference using a striped SSE2 kernel and a compact traceback
+	void AlignStriped(Alignment& alignment, const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length);
+	// fills the striped matrices and returns the best score along with its cell
+	float FillStriped(const char* s1, const unsigned int s1Length, const char* s2, const unsigned int s2Length, const bool storeTraceback, unsigned int& bestRow, unsigned int& bestColumn);
+	// returns the striped query profile for the specified reference base
+	const __m128* GetQueryProfile(const char referenceBase, const char* s2, const unsigned int s2Length);
+	// returns the striped traceback entry for the specified cell
+	inline unsigned char GetStripedTraceback(const unsigned int row, const unsigned int column) const;
+	// shifts the striped lanes up by one query segment and inserts the first lane
+	static inline __m128 ShiftStripedLanes(const __m128 v, const __m128 first);
 #endif
 	// creates a simple scoring matrix to align the nucleotides and the ambiguity code N
 	void CreateScoringMatrix(void);
+	// reserves the gap score and best score vectors used by the scalar fill
+	void ReserveQueryScores(const unsigned int s2Length);
+	// reserves the buffers used for the reversed alignment
+	void ReserveReversedSequences(const unsigned int sequenceSumLength);
+	// copies the reversed alignment and its coordinates into the alignment
+	void SetAlignment(Alignment& alignment, const int gappedLength, const unsigned int referenceBegin, const unsigned int bestRow, const unsigned int queryBegin, const unsigned int bestColumn, const unsigned int s2Length, const int numMismatches, const bool hasGap);
 	// corrects the homopolymer gap order for forward alignments
 	static void CorrectHomopolymerGapOrder(Alignment& al);
 	// returns the maximum floating point number
@@ -79,6 +112,18 @@ private:
 	bool mUseHomoPolymerGapOpenPenalty;
 	// specifies the homo-polymer gap open penalty
 	float mHomoPolymerGapOpenPenalty;
+#ifdef __SSE2__
+	// stores the striped row vectors and the query profiles
+	__m128* mStripedVectors;
+	unsigned int mCurrentStripedSize;
+	// the number of vectors in each striped row
+	unsigned int mNumSegments;
+	// points to the query profile of each reference base (NULL until it is needed)
+	__m128* mpQueryProfiles[MOSAIK_NUM_NUCLEOTIDES];
+	// stores the striped traceback for every cell beyond the first row and column
+	unsigned char* mTraceback;
+	unsigned int mCurrentTracebackSize;
+#endif
 };
 
 // returns the maximum floating point number
@@ -89,3 +134,17 @@ inline float CSmithWatermanGotoh::MaxFloats(const float& a, const float& b, cons
 	if(c > max) max = c;
 	return max;
 }
+
+#ifdef __SSE2__
+// returns the striped traceback entry for the specified cell
+inline unsigned char CSmithWatermanGotoh::GetStripedTraceback(const unsigned int row, const unsigned int column) const {
+	if((row == 0) || (column == 0)) return Directions_STOP;
+	const unsigned int queryPosition = column - 1;
+	return mTraceback[(row - 1) * mNumSegments * 4 + (queryPosition % mNumSegments) * 4 + queryPosition / mNumSegments];
+}
+
+// shifts the striped lanes up by one query segment and inserts the first lane
+inline __m128 CSmithWatermanGotoh::ShiftStripedLanes(const __m128 v, const __m128 first) {
+	return _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)), first);
+}
+#endif
@@ -0,0 +1,153 @@
+// ***************************************************************************
+// DiagonalSeedConsolidatorTest.cpp - provides unit tests for
+//                                    CDiagonalSeedConsolidator.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include <algorithm>
+#include <vector>
+#include "DiagonalSeedConsolidator.h"
+#include "HashRegionTree.h"
+#include "WinUnit.h"
+
+using namespace std;
+
+// the hash size and the maximum indel size used by CHashRegionTree
+#define TEST_HASH_SIZE  10
+#define TEST_INDEL_SIZE 3
+
+// orders the hash hits like the aligner does: by query position and then by reference position
+static bool SortByQuery(const HashRegion& a, const HashRegion& b) {
+	if(a.QueryBegin != b.QueryBegin) return a.QueryBegin < b.QueryBegin;
+	return a.Begin < b.Begin;
+}
+
+// adds the hash hits of consecutive query positions that align to the same diagonal
+static void AddSeeds(vector<HashRegion>& seeds, const unsigned int referenceBegin, const unsigned short queryBegin, const unsigned short numSeeds) {
+	for(unsigned short i = 0; i < numSeeds; i++) {
+		HashRegion seed;
+		seed.Begin      = referenceBegin + i;
+		seed.End        = seed.Begin + TEST_HASH_SIZE - 1;
+		seed.QueryBegin = queryBegin + i;
+		seed.QueryEnd   = seed.QueryBegin + TEST_HASH_SIZE - 1;
+		seeds.push_back(seed);
+	}
+}
+
+// consolidates the hash hits with both the AVL tree and the diagonal sort and returns
+// the number of hash regions if both produce the same regions (-1 otherwise)
+static int GetNumIdenticalRegions(vector<HashRegion> seeds, const unsigned int queryLength) {
+
+	sort(seeds.begin(), seeds.end(), SortByQuery);
+
+	AVLTree::CHashRegionTree tree(queryLength, TEST_HASH_SIZE);
+	CDiagonalSeedConsolidator consolidator;
+
+	for(vector<HashRegion>::iterator sIter = seeds.begin(); sIter != seeds.end(); ++sIter) {
+		tree.Insert(*sIter);
+		consolidator.Add(*sIter);
+	}
+
+	vector<HashRegion> regions;
+	consolidator.Consolidate(queryLength, TEST_HASH_SIZE, TEST_INDEL_SIZE, regions);
+
+	if(tree.GetCount() != regions.size()) return -1;
+
+	tree.GotoFirstEntry();
+	for(vector<HashRegion>::const_iterator rIter = regions.begin(); rIter != regions.end(); ++rIter) {
+		const HashRegion* pTreeRegion = tree.GetTraversalHashRegion();
+		if((pTreeRegion->Begin != rIter->Begin) || (pTreeRegion->End != rIter->End) || (pTreeRegion->QueryBegin != rIter->QueryBegin)
+			|| (pTreeRegion->QueryEnd != rIter->QueryEnd)) return -1;
+		tree.GetNextEntry();
+	}
+
+	return (int)regions.size();
+}
+
+BEGIN_TEST(CDiagonalSeedConsolidator_ConsolidateOverlappingSeeds) {
+	vector<HashRegion> seeds;
+
+	// a fully seeded read
+	AddSeeds(seeds, 1000, 0, 91);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 1, _T("Failed the fully seeded test.\n"));
+
+	// missing hash hits shorter than the hash size are bridged
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 20);
+	AddSeeds(seeds, 1025, 25, 30);
+	AddSeeds(seeds, 1058, 58, 33);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 1, _T("Failed the bridged seed test.\n"));
+
+	// missing hash hits longer than the hash size split the region
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 20);
+	AddSeeds(seeds, 1040, 40, 51);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 2, _T("Failed the split seed test.\n"));
+
+	// two distant loci
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 91);
+	AddSeeds(seeds, 50000, 0, 91);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 2, _T("Failed the distant loci test.\n"));
+}
+END_TEST
+
+BEGIN_TEST(CDiagonalSeedConsolidator_ConsolidateIndelSeeds) {
+	vector<HashRegion> seeds;
+
+	// insertions of one to three bases in the read
+	for(unsigned short indelSize = 1; indelSize <= TEST_INDEL_SIZE; indelSize++) {
+		seeds.clear();
+		AddSeeds(seeds, 1000, 0, 41);
+		AddSeeds(seeds, 1050, 50 + indelSize, 41 - indelSize);
+		WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 1, _T("Failed the insertion test.\n"));
+	}
+
+	// deletions of one to three bases from the read
+	for(unsigned short indelSize = 1; indelSize <= TEST_INDEL_SIZE; indelSize++) {
+		seeds.clear();
+		AddSeeds(seeds, 1000, 0, 41);
+		AddSeeds(seeds, 1050 + indelSize, 50, 41);
+		WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 1, _T("Failed the deletion test.\n"));
+	}
+
+	// an indel longer than the maximum indel size is not joined
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 41);
+	AddSeeds(seeds, 1055, 50, 41);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 2, _T("Failed the long deletion test.\n"));
+
+	// a second locus whose region starts between the two halves of an insertion
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 41);
+	AddSeeds(seeds, 1050, 52, 39);
+	AddSeeds(seeds, 1020, 0, 41);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 2, _T("Failed the interleaved insertion test.\n"));
+}
+END_TEST
+
+BEGIN_TEST(CDiagonalSeedConsolidator_ConsolidateRepetitiveSeeds) {
+	vector<HashRegion> seeds;
+
+	// a tandem repeat with a period shorter than the hash size
+	for(unsigned int copy = 0; copy < 5; copy++) AddSeeds(seeds, 1000 + 4 * copy, 0, 91);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 5, _T("Failed the short period repeat test.\n"));
+
+	// a tandem repeat with a period longer than the hash size
+	seeds.clear();
+	for(unsigned int copy = 0; copy < 3; copy++) AddSeeds(seeds, 1000 + 13 * copy, 0, 91);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100), 3, _T("Failed the long period repeat test.\n"));
+
+	// a repeat that only covers part of the read
+	seeds.clear();
+	AddSeeds(seeds, 1000, 0, 91);
+	AddSeeds(seeds, 1030, 40, 20);
+	AddSeeds(seeds, 1060, 40, 20);
+	WIN_ASSERT_EQUAL(GetNumIdenticalRegions(seeds, 100) > 0, true, _T("Failed the partial repeat test.\n"));
+}
+END_TEST
@@ -0,0 +1,135 @@
+// ***************************************************************************
+// MyersEditDistanceTest.cpp - provides unit tests for CMyersEditDistance.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include <string>
+#include <vector>
+#include "MyersEditDistance.h"
+#include "WinUnit.h"
+
+using namespace std;
+
+// returns true if the base is A, C, G or T
+static bool IsCanonical(const char base) {
+	return (base == 'A') || (base == 'C') || (base == 'G') || (base == 'T');
+}
+
+// returns the smallest edit distance between the query and any substring of the anchor
+// using the O(nm) semiglobal dynamic programming algorithm
+static unsigned int GetDynamicProgrammingDistance(const string& anchor, const string& query, const bool isWildcardEnabled) {
+
+	const unsigned int queryLength = (unsigned int)query.size();
+	vector<unsigned int> previous(queryLength + 1), current(queryLength + 1);
+	for(unsigned int i = 0; i <= queryLength; i++) previous[i] = i;
+
+	unsigned int minDistance = queryLength;
+	for(unsigned int j = 0; j < anchor.size(); j++) {
+		current[0] = 0;
+		for(unsigned int i = 1; i <= queryLength; i++) {
+			const bool isWildcard = isWildcardEnabled && (!IsCanonical(query[i - 1]) || !IsCanonical(anchor[j]));
+			unsigned int distance = previous[i - 1] + ((isWildcard || (query[i - 1] == anchor[j])) ? 0 : 1);
+			if(previous[i] + 1 < distance) distance = previous[i] + 1;
+			if(current[i - 1] + 1 < distance) distance = current[i - 1] + 1;
+			current[i] = distance;
+		}
+		if(current[queryLength] < minDistance) minDistance = current[queryLength];
+		previous.swap(current);
+	}
+
+	return minDistance;
+}
+
+// returns the next value of a simple linear congruential generator
+static unsigned int GetRandomNumber(unsigned int& seed) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+// creates a reproducible sequence from the specified alphabet
+static string CreateSequence(unsigned int& seed, const unsigned int length, const char* alphabet) {
+	const unsigned int alphabetLength = (unsigned int)strlen(alphabet);
+	string s;
+	for(unsigned int i = 0; i < length; i++) s += alphabet[GetRandomNumber(seed) % alphabetLength];
+	return s;
+}
+
+// copies part of the anchor and introduces mismatches, insertions and deletions
+static string CreateQuery(unsigned int& seed, const string& anchor, const unsigned int begin, const unsigned int length) {
+	string s;
+	for(unsigned int i = begin; i < begin + length; i++) {
+		const unsigned int r = GetRandomNumber(seed) % 30;
+		// deletion
+		if(r == 0) continue;
+		// insertion
+		if(r == 1) s += "ACGT"[GetRandomNumber(seed) % 4];
+		// mismatch
+		s += (r == 2 ? "ACGT"[GetRandomNumber(seed) % 4] : anchor[i]);
+	}
+	return s;
+}
+
+BEGIN_TEST(CMyersEditDistance_CalculateMinDistance) {
+	CMyersEditDistance ed;
+	const string anchor = "GGGGACGTACGTGGGG";
+
+	WIN_ASSERT_ZERO(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "ACGTACGT", 8, 0), _T("Failed the exact match test.\n"));
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "ACGAACGT", 8, 0), 1, _T("Failed the mismatch test.\n"));
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "ACGTCGT", 7, 0), 1, _T("Failed the deletion test.\n"));
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "ACGTTACGT", 9, 0), 1, _T("Failed the insertion test.\n"));
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "TTTTTT", 6, 0), 4, _T("Failed the unrelated query test.\n"));
+	WIN_ASSERT_ZERO(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "", 0, 0), _T("Failed the empty query test.\n"));
+
+	// the search stops as soon as the distance is within the threshold
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "ACGAACGT", 8, 3) <= 3, true, _T("Failed the early termination test.\n"));
+	WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), "TTTTTT", 6, 3), 4, _T("Failed the threshold test.\n"));
+}
+END_TEST
+
+BEGIN_TEST(CMyersEditDistance_CalculateMinDistanceLongReads) {
+	CMyersEditDistance ed;
+	unsigned int seed = 42;
+
+	// spans one, two and several bit-vector words
+	const unsigned int queryLengths[] = { 36, 63, 64, 65, 100, 127, 128, 129, 200, 250 };
+
+	for(unsigned int q = 0; q < 10; q++) {
+		for(unsigned int i = 0; i < 10; i++) {
+			const string anchor = CreateSequence(seed, queryLengths[q] + 60, "ACGT");
+			const string query  = (i == 9 ? CreateSequence(seed, queryLengths[q], "ACGT") : CreateQuery(seed, anchor, 30, queryLengths[q]));
+
+			const unsigned int expected = GetDynamicProgrammingDistance(anchor, query, false);
+			WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), query.c_str(), query.size(), 0), expected, _T("Failed the long read test.\n"));
+
+			const unsigned int maxDistance = expected / 2;
+			WIN_ASSERT_EQUAL(ed.CalculateMinDistance(anchor.c_str(), anchor.size(), query.c_str(), query.size(), maxDistance), expected, _T("Failed the long read threshold test.\n"));
+		}
+	}
+}
+END_TEST
+
+BEGIN_TEST(CMyersEditDistance_CalculateMinDistanceAmbiguousBases) {
+	CMyersEditDistance ed;
+	unsigned int seed = 7;
+
+	const unsigned int queryLengths[] = { 36, 65, 100, 129, 200 };
+
+	for(unsigned int q = 0; q < 5; q++) {
+		for(unsigned int i = 0; i < 10; i++) {
+			string anchor = CreateSequence(seed, queryLengths[q] + 60, "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTN");
+			string query  = CreateQuery(seed, anchor, 30, queryLengths[q]);
+			for(unsigned int j = 0; j < query.size(); j += 1 + GetRandomNumber(seed) % 40) query[j] = 'N';
+
+			// non-ACGT bases match everything, so the distance is a lower bound on the distance where they mismatch
+			const unsigned int distance = ed.CalculateMinDistance(anchor.c_str(), anchor.size(), query.c_str(), query.size(), 0);
+			WIN_ASSERT_EQUAL(distance, GetDynamicProgrammingDistance(anchor, query, true), _T("Failed the wildcard test.\n"));
+			WIN_ASSERT_EQUAL(distance <= GetDynamicProgrammingDistance(anchor, query, false), true, _T("Failed the lower bound test.\n"));
+		}
+	}
+}
+END_TEST
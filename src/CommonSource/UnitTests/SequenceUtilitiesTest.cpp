@@ -28,6 +28,29 @@ BEGIN_TEST(CSequenceUtilities_Chomp) {
 }
 END_TEST
 
+BEGIN_TEST(CSequenceUtilities_CountMismatches) {
+	char s1[32], s2[32];
+
+	// shorter than one 16 base block
+	sprintf_s(s1, 32, "ACGTACGTA");
+	sprintf_s(s2, 32, "ACCTACGNA");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::CountMismatches(s1, s2, strlen(s1)), 2, _T("Failed the short mismatch test.\n"));
+
+	// exactly one 16 base block
+	sprintf_s(s1, 32, "ACGTACGTACGTACGT");
+	sprintf_s(s2, 32, "TCGTACGXACGTACGA");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::CountMismatches(s1, s2, strlen(s1)), 3, _T("Failed the 16 base mismatch test.\n"));
+	WIN_ASSERT_ZERO(CSequenceUtilities::CountMismatches(s1, s1, strlen(s1)), _T("Failed the 16 base identity test.\n"));
+
+	// one 16 base block followed by the remaining bases
+	sprintf_s(s1, 32, "ACGTACGTACGTACGTACGTAC");
+	sprintf_s(s2, 32, "ACGNACGTACGTACGTACNTAA");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::CountMismatches(s1, s2, strlen(s1)), 3, _T("Failed the long mismatch test.\n"));
+	WIN_ASSERT_EQUAL(CSequenceUtilities::CountMismatches(s1, s2, 16), 1, _T("Failed the partial length mismatch test.\n"));
+	WIN_ASSERT_ZERO(CSequenceUtilities::CountMismatches(s1, s2, 3), _T("Failed the prefix mismatch test.\n"));
+}
+END_TEST
+
 BEGIN_TEST(CSequenceUtilities_GetReverseComplement) {
 	char expected[32], s[32];
 	sprintf_s(expected, 32, "GGGGAAAAAAAATTTATATAT");
@@ -38,6 +61,32 @@ BEGIN_TEST(CSequenceUtilities_GetReverseComplement) {
 }
 END_TEST
 
+BEGIN_TEST(CSequenceUtilities_HasOnlyCanonicalBases) {
+	char s[32];
+
+	// shorter than one 16 base block
+	sprintf_s(s, 32, "ACGTTGCA");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), true, _T("Failed the short canonical test.\n"));
+	sprintf_s(s, 32, "ACGTNGCA");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), false, _T("Failed the short N test.\n"));
+
+	// exactly one 16 base block
+	sprintf_s(s, 32, "ACGTACGTACGTACGT");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), true, _T("Failed the 16 base canonical test.\n"));
+	sprintf_s(s, 32, "ACGTACGTACGTACGa");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), false, _T("Failed the 16 base lowercase test.\n"));
+
+	// one 16 base block followed by the remaining bases
+	sprintf_s(s, 32, "ACGTACGTACGTACGTACGTAC");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), true, _T("Failed the long canonical test.\n"));
+	sprintf_s(s, 32, "ACGTACGXACGTACGTACGTAC");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), false, _T("Failed the long block X test.\n"));
+	sprintf_s(s, 32, "ACGTACGTACGTACGTACGNAC");
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, strlen(s)), false, _T("Failed the long remainder N test.\n"));
+	WIN_ASSERT_EQUAL(CSequenceUtilities::HasOnlyCanonicalBases(s, 19), true, _T("Failed the partial length canonical test.\n"));
+}
+END_TEST
+
 BEGIN_TEST(CSequenceUtilities_LowercaseSequence) {
 	string s              = "OSCAR";
 	const string expected = "oscar";
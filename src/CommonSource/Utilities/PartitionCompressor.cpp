@@ -0,0 +1,179 @@
+// ***************************************************************************
+// CPartitionCompressor - compresses archive partitions in a pool of worker
+//                        threads and writes them to disk in submission order.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#include "PartitionCompressor.h"
+
+// constructor
+CPartitionCompressor::CPartitionCompressor(FILE* outStream, const unsigned int numThreads)
+	: mOutStream(outStream)
+	, mNumSubmitted(0)
+	, mNumWritten(0)
+	, mIsWriting(false)
+	, mIsFinished(false)
+{
+	const unsigned int numCompressionThreads = (numThreads > 0 ? numThreads : 1);
+	mPartitions.resize(numCompressionThreads * PARTITIONS_PER_COMPRESSION_THREAD);
+
+	pthread_mutex_init(&mMutex, NULL);
+	pthread_cond_init(&mQueuedCondition, NULL);
+	pthread_cond_init(&mWrittenCondition, NULL);
+
+	// start our compression threads
+	mThreads.resize(numCompressionThreads);
+	for(unsigned int i = 0; i < numCompressionThreads; i++)
+		pthread_create(&mThreads[i], NULL, StartThread, (void*)this);
+}
+
+// destructor
+CPartitionCompressor::~CPartitionCompressor(void) {
+
+	Flush();
+
+	// stop our compression threads
+	pthread_mutex_lock(&mMutex);
+	mIsFinished = true;
+	pthread_cond_broadcast(&mQueuedCondition);
+	pthread_mutex_unlock(&mMutex);
+
+	void* status = NULL;
+	for(unsigned int i = 0; i < (unsigned int)mThreads.size(); i++) pthread_join(mThreads[i], &status);
+
+	// clean up
+	for(vector<Partition>::iterator pIter = mPartitions.begin(); pIter != mPartitions.end(); ++pIter) {
+		if(pIter->Buffer)            delete [] pIter->Buffer;
+		if(pIter->CompressionBuffer) delete [] pIter->CompressionBuffer;
+	}
+
+	pthread_cond_destroy(&mWrittenCondition);
+	pthread_cond_destroy(&mQueuedCondition);
+	pthread_mutex_destroy(&mMutex);
+}
+
+// compresses partitions until the compressor is destroyed
+void CPartitionCompressor::CompressPartitions(void) {
+
+	pthread_mutex_lock(&mMutex);
+
+	while(true) {
+
+		// wait for a queued partition
+		while(mQueuedPartitions.empty() && !mIsFinished) pthread_cond_wait(&mQueuedCondition, &mMutex);
+		if(mQueuedPartitions.empty()) break;
+
+		Partition& p = mPartitions[mQueuedPartitions.front()];
+		mQueuedPartitions.pop_front();
+		p.State = PartitionState_COMPRESSING;
+		pthread_mutex_unlock(&mMutex);
+
+		// compress the partition
+		unsigned int requestedSize = (unsigned int)(p.NumBytes * 1.05);
+		CMemoryUtilities::CheckBufferSize(p.CompressionBuffer, p.CompressionBufferLen, requestedSize);
+		p.CompressedSize = fastlz_compress_level(FASTLZ_BETTER_COMPRESSION, p.Buffer, p.NumBytes, p.CompressionBuffer);
+
+		// write every partition that is next in line
+		pthread_mutex_lock(&mMutex);
+		p.State = PartitionState_COMPRESSED;
+		if(!mIsWriting) WritePartitions();
+	}
+
+	pthread_mutex_unlock(&mMutex);
+}
+
+// waits until all of the submitted partitions have been written
+void CPartitionCompressor::Flush(void) {
+	pthread_mutex_lock(&mMutex);
+	while(mNumWritten != mNumSubmitted) pthread_cond_wait(&mWrittenCondition, &mMutex);
+	pthread_mutex_unlock(&mMutex);
+}
+
+// returns the file offsets of the written partitions (in submission order)
+const vector<off_type>& CPartitionCompressor::GetPartitionOffsets(void) const {
+	return mPartitionOffsets;
+}
+
+// queues the partition for compression and swaps in an empty buffer of at least the same size
+void CPartitionCompressor::SavePartition(unsigned char*& pBuffer, unsigned int& bufferLen, const unsigned int numBytes, const unsigned short numMembers) {
+
+	const unsigned int numPartitions = (unsigned int)mPartitions.size();
+
+	// wait until the next partition in the ring buffer has been written
+	pthread_mutex_lock(&mMutex);
+	const unsigned int partitionIndex = (unsigned int)(mNumSubmitted % numPartitions);
+	Partition& p = mPartitions[partitionIndex];
+	while(p.State != PartitionState_EMPTY) pthread_cond_wait(&mWrittenCondition, &mMutex);
+	pthread_mutex_unlock(&mMutex);
+
+	// swap the filled buffer with the empty partition buffer
+	CMemoryUtilities::CheckBufferSize(p.Buffer, p.BufferLen, bufferLen);
+
+	unsigned char* pEmptyBuffer = p.Buffer;
+	unsigned int emptyBufferLen = p.BufferLen;
+
+	p.Buffer     = pBuffer;
+	p.BufferLen  = bufferLen;
+	p.NumBytes   = numBytes;
+	p.NumMembers = numMembers;
+
+	pBuffer   = pEmptyBuffer;
+	bufferLen = emptyBufferLen;
+
+	// queue the partition
+	pthread_mutex_lock(&mMutex);
+	p.State = PartitionState_QUEUED;
+	mQueuedPartitions.push_back(partitionIndex);
+	mNumSubmitted++;
+	pthread_cond_signal(&mQueuedCondition);
+	pthread_mutex_unlock(&mMutex);
+}
+
+// activates a compression thread
+void* CPartitionCompressor::StartThread(void* arg) {
+	CPartitionCompressor* pCompressor = (CPartitionCompressor*)arg;
+	pCompressor->CompressPartitions();
+	return 0;
+}
+
+// writes the compressed partitions that are next in line (called with the mutex held)
+void CPartitionCompressor::WritePartitions(void) {
+
+	const unsigned int numPartitions = (unsigned int)mPartitions.size();
+	mIsWriting = true;
+
+	while(mNumWritten != mNumSubmitted) {
+
+		Partition& p = mPartitions[(unsigned int)(mNumWritten % numPartitions)];
+		if(p.State != PartitionState_COMPRESSED) break;
+
+		// write the partition outside of the lock
+		pthread_mutex_unlock(&mMutex);
+
+		mPartitionOffsets.push_back(ftell64(mOutStream));
+
+		// write the uncompressed partition entry size
+		fwrite((char*)&p.NumBytes, SIZEOF_INT, 1, mOutStream);
+
+		// write the compressed partition entry size
+		fwrite((char*)&p.CompressedSize, SIZEOF_INT, 1, mOutStream);
+
+		// write the partition member size
+		fwrite((char*)&p.NumMembers, SIZEOF_SHORT, 1, mOutStream);
+
+		// write the partition
+		fwrite(p.CompressionBuffer, p.CompressedSize, 1, mOutStream);
+
+		pthread_mutex_lock(&mMutex);
+		p.State = PartitionState_EMPTY;
+		mNumWritten++;
+		pthread_cond_broadcast(&mWrittenCondition);
+	}
+
+	mIsWriting = false;
+}
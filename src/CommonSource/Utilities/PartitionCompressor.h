@@ -0,0 +1,97 @@
+// ***************************************************************************
+// CPartitionCompressor - compresses archive partitions in a pool of worker
+//                        threads and writes them to disk in submission order.
+// ---------------------------------------------------------------------------
+// (c) 2006 - 2009 Michael Strmberg
+// Marth Lab, Department of Biology, Boston College
+// ---------------------------------------------------------------------------
+// Dual licenced under the GNU General Public License 2.0+ license or as
+// a commercial license with the Marth Lab.
+// ***************************************************************************
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdio>
+#include "fastlz.h"
+#include "LargeFileSupport.h"
+#include "MemoryUtilities.h"
+#include "Mosaik.h"
+#include "PosixThreads.h"
+
+using namespace std;
+
+#ifndef FASTLZ_BETTER_COMPRESSION
+#define FASTLZ_BETTER_COMPRESSION 2
+#endif
+
+// the number of partitions that can be queued per compression thread
+#define PARTITIONS_PER_COMPRESSION_THREAD 2
+
+class CPartitionCompressor {
+public:
+	// constructor
+	CPartitionCompressor(FILE* outStream, const unsigned int numThreads);
+	// destructor
+	~CPartitionCompressor(void);
+	// waits until all of the submitted partitions have been written
+	void Flush(void);
+	// returns the file offsets of the written partitions (in submission order)
+	const vector<off_type>& GetPartitionOffsets(void) const;
+	// queues the partition for compression and swaps in an empty buffer of at least the same size
+	void SavePartition(unsigned char*& pBuffer, unsigned int& bufferLen, const unsigned int numBytes, const unsigned short numMembers);
+private:
+	// our partition states
+	enum PartitionState {
+		PartitionState_EMPTY,
+		PartitionState_QUEUED,
+		PartitionState_COMPRESSING,
+		PartitionState_COMPRESSED
+	};
+	// stores a partition and its compressed counterpart
+	struct Partition {
+		unsigned char* Buffer;
+		unsigned int BufferLen;
+		unsigned int NumBytes;
+		unsigned char* CompressionBuffer;
+		unsigned int CompressionBufferLen;
+		int CompressedSize;
+		unsigned short NumMembers;
+		PartitionState State;
+
+		Partition(void)
+			: Buffer(NULL)
+			, BufferLen(0)
+			, NumBytes(0)
+			, CompressionBuffer(NULL)
+			, CompressionBufferLen(0)
+			, CompressedSize(0)
+			, NumMembers(0)
+			, State(PartitionState_EMPTY)
+		{}
+	};
+	// compresses partitions until the compressor is destroyed
+	void CompressPartitions(void);
+	// activates a compression thread
+	static void* StartThread(void* arg);
+	// writes the compressed partitions that are next in line (called with the mutex held)
+	void WritePartitions(void);
+	// our output stream
+	FILE* mOutStream;
+	// our partition ring buffer
+	vector<Partition> mPartitions;
+	deque<unsigned int> mQueuedPartitions;
+	uint64_t mNumSubmitted;
+	uint64_t mNumWritten;
+	bool mIsWriting;
+	// the file offsets of the written partitions
+	vector<off_type> mPartitionOffsets;
+	// our compression threads
+	vector<pthread_t> mThreads;
+	bool mIsFinished;
+	// our thread synchronization
+	pthread_mutex_t mMutex;
+	pthread_cond_t mQueuedCondition;
+	pthread_cond_t mWrittenCondition;
+};
@@ -10,6 +10,62 @@
 
 #include "SequenceUtilities.h"
 
+// Returns the number of positions where the two sequences differ
+unsigned int CSequenceUtilities::CountMismatches(const char* s1, const char* s2, const unsigned int length) {
+
+	unsigned int numMismatches = 0;
+	unsigned int i = 0;
+
+#ifdef __SSE2__
+	// compare 16 bases at a time
+	for(; (i + 16) <= length; i += 16) {
+		const __m128i v1 = _mm_loadu_si128((const __m128i*)(s1 + i));
+		const __m128i v2 = _mm_loadu_si128((const __m128i*)(s2 + i));
+		const unsigned int isEqual = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2));
+		numMismatches += __builtin_popcount(isEqual ^ 0xffff);
+	}
+#endif
+
+	for(; i < length; i++)
+		if(s1[i] != s2[i]) numMismatches++;
+
+	return numMismatches;
+}
+
+// Returns true if the sequence only contains the bases A, C, G and T
+bool CSequenceUtilities::HasOnlyCanonicalBases(const char* seqBases, const unsigned int seqLength) {
+
+	unsigned int i = 0;
+
+#ifdef __SSE2__
+	// check 16 bases at a time
+	const __m128i vA = _mm_set1_epi8('A');
+	const __m128i vC = _mm_set1_epi8('C');
+	const __m128i vG = _mm_set1_epi8('G');
+	const __m128i vT = _mm_set1_epi8('T');
+
+	for(; (i + 16) <= seqLength; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i*)(seqBases + i));
+		const __m128i isCanonical = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vA), _mm_cmpeq_epi8(v, vC)), _mm_or_si128(_mm_cmpeq_epi8(v, vG), _mm_cmpeq_epi8(v, vT)));
+		if(_mm_movemask_epi8(isCanonical) != 0xffff) return false;
+	}
+#endif
+
+	for(; i < seqLength; i++) {
+		switch(seqBases[i]) {
+			case 'A':
+			case 'C':
+			case 'G':
+			case 'T':
+				break;
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
 // Performs an in-place reverse complement conversion
 void CSequenceUtilities::GetReverseComplement(char* seqBases, const unsigned int seqLength) {
 
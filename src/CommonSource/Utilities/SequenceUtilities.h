@@ -15,10 +15,18 @@
 #include <map>
 #include <string>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 class CSequenceUtilities {
 public:
+	// Returns the number of positions where the two sequences differ
+	static unsigned int CountMismatches(const char* s1, const char* s2, const unsigned int length);
+	// Returns true if the sequence only contains the bases A, C, G and T
+	static bool HasOnlyCanonicalBases(const char* seqBases, const unsigned int seqLength);
 	// Performs an in-place reverse complement conversion
 	static void GetReverseComplement(char* seqBases, const unsigned int seqLength);
 	// Performs an in-place sequence reversal using a C string
@@ -31,6 +31,7 @@ unsigned char DEFAULT_HASH_SIZE      = 15;
 unsigned char DEFAULT_NUM_MISMATCHES = 4;
 unsigned int DEFAULT_BANDWIDTH       = 9;
 unsigned int DEFAULT_NUM_THREADS     = 1;
+unsigned int DEFAULT_READ_BATCH_SIZE = 1024;
 
 #define MIN_HASH_SIZE     4
 #define MAX_HASH_SIZE     32
@@ -54,6 +55,7 @@ struct ConfigurationSettings {
 	bool HasGapExtendPenalty;
 	bool HasGapOpenPenalty;
 	bool HasHashSize;
+	bool HasHashSnapshotFilename;
 	bool HasHomoPolymerGapOpenPenalty;
 	bool HasJumpCacheMemory;
 	bool HasLocalAlignmentSearchRadius;
@@ -61,18 +63,24 @@ struct ConfigurationSettings {
 	bool HasMismatchScore;
 	bool HasMode;
 	bool HasNumThreads;
+	bool HasReadBatchSize;
 	bool HasReadsFilename;
 	bool HasReferencesFilename;
 	bool KeepJumpKeysOnDisk;
 	bool KeepJumpPositionsOnDisk;
+	bool MapJumpDB;
+	bool PrefetchJumpDB;
+	bool FilterFrequentKmers;
 	bool LimitHashPositions;
 	bool RecordUnalignedReads;
 	bool UseAlignedLengthForMismatches;
+	bool UseDiagonalSeedSorting;
 	bool UseJumpDB;
 
 	// filenames
 	string AlignmentsFilename;
 	string BasespaceReferencesFilename;
+	string HashSnapshotFilename;
 	string JumpFilenameStub;
 	string ReadsFilename;
 	string ReferencesFilename;
@@ -98,6 +106,7 @@ struct ConfigurationSettings {
 	unsigned int MinimumAlignment;
 	unsigned int NumMismatches;
 	unsigned int NumThreads;
+	unsigned int ReadBatchSize;
 
 	// constructor
 	ConfigurationSettings()
@@ -116,6 +125,7 @@ struct ConfigurationSettings {
 		, HasGapExtendPenalty(false)
 		, HasGapOpenPenalty(false)
 		, HasHashSize(false)
+		, HasHashSnapshotFilename(false)
 		, HasHomoPolymerGapOpenPenalty(false)
 		, HasJumpCacheMemory(false)
 		, HasLocalAlignmentSearchRadius(false)
@@ -123,13 +133,18 @@ struct ConfigurationSettings {
 		, HasMismatchScore(false)
 		, HasMode(false)
 		, HasNumThreads(false)
+		, HasReadBatchSize(false)
 		, HasReadsFilename(false)
 		, HasReferencesFilename(false)
 		, KeepJumpKeysOnDisk(false)
 		, KeepJumpPositionsOnDisk(false)
+		, MapJumpDB(false)
+		, PrefetchJumpDB(false)
+		, FilterFrequentKmers(false)
 		, LimitHashPositions(false)
 		, RecordUnalignedReads(false)
 		, UseAlignedLengthForMismatches(false)
+		, UseDiagonalSeedSorting(false)
 		, UseJumpDB(false)
 		, Algorithm(DEFAULT_ALGORITHM)
 		, Mode(DEFAULT_MODE)
@@ -137,6 +152,7 @@ struct ConfigurationSettings {
 		, JumpCacheMemory(0)
 		, NumMismatches(DEFAULT_NUM_MISMATCHES)
 		, NumThreads(DEFAULT_NUM_THREADS)
+		, ReadBatchSize(DEFAULT_READ_BATCH_SIZE)
 	{}
 };
 
@@ -191,6 +207,9 @@ int main(int argc, char* argv[]) {
 	OptionGroup* pPerformanceOpts = COptions::CreateOptionGroup("Performance");
 	COptions::AddValueOption("-p",  "processors", "use the specified number of processors", "", settings.HasNumThreads, settings.NumThreads, pPerformanceOpts);
 	COptions::AddValueOption("-bw", "bandwidth",  "specifies the Smith-Waterman bandwidth", "", settings.HasBandwidth,  settings.Bandwidth,  pPerformanceOpts, DEFAULT_BANDWIDTH);
+	COptions::AddValueOption("-rb", "# of reads", "retrieves reads in batches of the specified size", "", settings.HasReadBatchSize, settings.ReadBatchSize, pPerformanceOpts, DEFAULT_READ_BATCH_SIZE);
+	COptions::AddOption("-dss", "consolidates hash hits by sorting them by diagonal (repeat reads can gain a few alignments)", settings.UseDiagonalSeedSorting, pPerformanceOpts);
+	COptions::AddValueOption("-hsf", "filename", "loads the hash table snapshot (creates it when missing)", "", settings.HasHashSnapshotFilename, settings.HashSnapshotFilename, pPerformanceOpts);
 
 	// add the jump database options
 	OptionGroup* pJumpOpts = COptions::CreateOptionGroup("Jump database");
@@ -198,6 +217,9 @@ int main(int argc, char* argv[]) {
 	COptions::AddValueOption("-jc", "# of hashes",   "caches the most recently used hashes", "", settings.HasJumpCacheMemory,        settings.JumpCacheMemory,  pJumpOpts);
 	COptions::AddOption("-kd",                       "keeps the keys file on disk",              settings.KeepJumpKeysOnDisk,                                 pJumpOpts);
 	COptions::AddOption("-pd",                       "keeps the positions file on disk",         settings.KeepJumpPositionsOnDisk,                            pJumpOpts);
+	COptions::AddOption("-jmm",                      "memory maps the keys & positions files",   settings.MapJumpDB,                                          pJumpOpts);
+	COptions::AddOption("-jpf",                      "prefetches the memory mapped files",       settings.PrefetchJumpDB,                                     pJumpOpts);
+	COptions::AddOption("-jhf",                      "skips every position of the k-mers above the MosaikJump -hf threshold instead of subsampling them with -mhp, so reads in repeats can lose alignments", settings.FilterFrequentKmers,                   pJumpOpts);
 
 	// add the reporting options
 	OptionGroup* pReportingOpts = COptions::CreateOptionGroup("Reporting");
@@ -227,7 +249,7 @@ int main(int argc, char* argv[]) {
 		foundError = true;
 	}
 
-	if((settings.HasJumpCacheMemory || settings.KeepJumpKeysOnDisk || settings.KeepJumpPositionsOnDisk) && !settings.UseJumpDB) {
+	if((settings.HasJumpCacheMemory || settings.KeepJumpKeysOnDisk || settings.KeepJumpPositionsOnDisk || settings.MapJumpDB || settings.FilterFrequentKmers) && !settings.UseJumpDB) {
 		errorBuilder << ERROR_SPACER << "Jump database settings were specified, but the jump database was not explicitly chosen. Please use the -j parameter." << endl;
 		foundError = true;
 	}
@@ -241,10 +263,30 @@ int main(int argc, char* argv[]) {
 		CFileUtilities::CheckFile(metaFilename.c_str(), true);
 		CFileUtilities::CheckFile(positionsFilename.c_str(), true);
 
+		if(settings.FilterFrequentKmers) {
+			string filterFilename = settings.JumpFilenameStub + "_filter.jmp";
+			CFileUtilities::CheckFile(filterFilename.c_str(), true);
+		}
+
 		if(!settings.KeepJumpKeysOnDisk && !settings.KeepJumpPositionsOnDisk && settings.HasJumpCacheMemory) 
 			settings.HasJumpCacheMemory = false;
 	}
 
+	if(settings.HasHashSnapshotFilename && settings.UseJumpDB) {
+		errorBuilder << ERROR_SPACER << "Hash table snapshots (-hsf) cannot be combined with the jump database (-j)." << endl;
+		foundError = true;
+	}
+
+	if(settings.MapJumpDB && (settings.KeepJumpKeysOnDisk || settings.KeepJumpPositionsOnDisk)) {
+		errorBuilder << ERROR_SPACER << "The memory mapped jump database (-jmm) cannot be combined with the -kd or -pd parameters." << endl;
+		foundError = true;
+	}
+
+	if(settings.PrefetchJumpDB && !settings.MapJumpDB) {
+		errorBuilder << ERROR_SPACER << "Prefetching (-jpf) is only available for memory mapped jump databases. Please use the -jmm parameter." << endl;
+		foundError = true;
+	}
+
 	if(!settings.CheckNumMismatches && !settings.CheckMismatchPercent && !settings.CheckAlignmentQuality) {
 		settings.CheckNumMismatches = true;
 	}
@@ -333,6 +375,12 @@ int main(int argc, char* argv[]) {
 		foundError = true;
 	}
 
+	// set the read batch size
+	if(settings.HasReadBatchSize && (settings.ReadBatchSize < 1)) {
+		errorBuilder << ERROR_SPACER << "The read batch size should be at least 1. Use the -rb parameter to change the read batch size." << endl;
+		foundError = true;
+	}
+
 	// set the Smith-Waterman bandwidth
 	if(settings.HasBandwidth && ((settings.Bandwidth % 2) != 1)) {
 		errorBuilder << ERROR_SPACER << "The bandwidth must be an odd number. Use the -bw parameter to change the bandwidth." << endl;
@@ -505,12 +553,27 @@ int main(int argc, char* argv[]) {
 	// enable the jump database
 	if(settings.UseJumpDB) ma.EnableJumpDB(settings.JumpFilenameStub, settings.JumpCacheMemory, !settings.KeepJumpKeysOnDisk, !settings.KeepJumpPositionsOnDisk);
 
+	// memory map the jump database
+	if(settings.MapJumpDB) ma.EnableMemoryMappedJumpDB(settings.PrefetchJumpDB);
+
+	// skip the seeds of high-frequency k-mers
+	if(settings.FilterFrequentKmers) ma.EnableJumpKmerFilter();
+
 	// enable the local alignment search
 	if(settings.HasLocalAlignmentSearchRadius) ma.EnableLocalAlignmentSearch(settings.LocalAlignmentSearchRadius);
 
 	// set the Smith-Waterman bandwidth
 	if(settings.HasBandwidth) ma.EnableBandedSmithWaterman(settings.Bandwidth);
 
+	// set the read batch size
+	ma.EnableBatchedReadDispatch(settings.ReadBatchSize);
+
+	// consolidate the hash hits by diagonal sorting
+	if(settings.UseDiagonalSeedSorting) ma.EnableDiagonalSeedSorting();
+
+	// load or create the hash table snapshot
+	if(settings.HasHashSnapshotFilename) ma.EnableHashSnapshot(settings.HashSnapshotFilename);
+
 	// =============
 	// set filenames
 	// =============
@@ -565,6 +628,9 @@ int main(int argc, char* argv[]) {
 	if(settings.EnableColorspace)         cout << "- Aligning in colorspace (SOLiD)" << endl;
 	if(settings.HasNumThreads)            cout << "- Using " << (short)settings.NumThreads << (settings.NumThreads > 1 ? " processors" : " processor") << endl;
 	if(settings.HasBandwidth)             cout << "- Using a Smith-Waterman bandwidth of " << settings.Bandwidth << endl;
+	if(settings.HasReadBatchSize)         cout << "- Retrieving reads in batches of " << settings.ReadBatchSize << endl;
+	if(settings.UseDiagonalSeedSorting)   cout << "- Consolidating hash hits by diagonal sorting" << endl;
+	if(settings.HasHashSnapshotFilename)  cout << "- Using the hash table snapshot " << settings.HashSnapshotFilename << endl;
 
 	if(settings.EnableAlignmentCandidateThreshold) 
 		cout << "- Using an alignment candidate threshold of " << (unsigned short)settings.AlignmentCandidateThreshold << "bp." << endl;
@@ -579,7 +645,8 @@ int main(int argc, char* argv[]) {
 		if(settings.HasJumpCacheMemory) cout << " with a " << settings.JumpCacheMemory << " element cache";
 		cout << ".";
 
-		if(!settings.KeepJumpKeysOnDisk && !settings.KeepJumpPositionsOnDisk)     cout << " Storing keys & positions in memory.";
+		if(settings.MapJumpDB)                                                    cout << " Memory mapping keys & positions" << (settings.PrefetchJumpDB ? " (prefetched)." : ".");
+		else if(!settings.KeepJumpKeysOnDisk && !settings.KeepJumpPositionsOnDisk) cout << " Storing keys & positions in memory.";
 		else if(!settings.KeepJumpKeysOnDisk && settings.KeepJumpPositionsOnDisk) cout << " Storing keys in memory.";
 		else if(settings.KeepJumpKeysOnDisk && !settings.KeepJumpPositionsOnDisk) cout << " Storing positions in memory.";
 		cout << endl;
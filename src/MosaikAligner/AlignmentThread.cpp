@@ -11,10 +11,8 @@
 #include "AlignmentThread.h"
 
 // register our thread mutexes
-pthread_mutex_t CAlignmentThread::mGetReadMutex;
 pthread_mutex_t CAlignmentThread::mReportUnalignedMate1Mutex;
 pthread_mutex_t CAlignmentThread::mReportUnalignedMate2Mutex;
-pthread_mutex_t CAlignmentThread::mSaveReadMutex;
 pthread_mutex_t CAlignmentThread::mStatisticsMutex;
 
 // define our constants
@@ -39,6 +37,12 @@ CAlignmentThread::CAlignmentThread(AlignerAlgorithmType& algorithmType, FilterSe
 	, mBSW(CPairwiseUtilities::MatchScore, CPairwiseUtilities::MismatchScore, CPairwiseUtilities::GapOpenPenalty, CPairwiseUtilities::GapExtendPenalty, settings.Bandwidth)
 	, mReferenceBegin(pRefBegin)
 	, mReferenceEnd(pRefEnd)
+	, mHashRegionTree(0, settings.HashSize)
+	, mReverseHashRegionTree(0, settings.HashSize)
+	, mIsCanonicalHash(pDnaHash->IsCanonical())
+	, mIsUsingScorePrefilter(false)
+	, mMaxMismatchPenalty(mSW.GetMaxMismatchPenalty())
+	, mIsUsingEditDistancePrefilter(false)
 {
 	// calculate our base quality LUT
 	for(unsigned char i = 0; i < 100; i++) mBaseQualityLUT[i] = pow(10.0, -i / 10.0);
@@ -46,8 +50,46 @@ CAlignmentThread::CAlignmentThread(AlignerAlgorithmType& algorithmType, FilterSe
 	// set our flags
 	if(algorithmMode == AlignerMode_ALL) mFlags.IsAligningAllReads = true;
 
+	// initialize our hash LUTs: ambiguity codes use the same values as the reference
+	// hash (X is hashed as C). Windows containing N, J or unrecognized characters are skipped,
+	// just like the reference hashers skip N, so a read with an N loses the seeds that cover it
+	const char translation[26] = { 0, 3, 1, 3, -1, -1, 2, 3, -1, -1, 3, -1, 0, -1, -1, -1, -1, 0, 2, 3, -1, 0, 3, 1, 3, -1 };
+
+	for(unsigned int i = 0; i < 256; i++) {
+		mForwardHashLUT[i] = -1;
+		mReverseHashLUT[i] = -1;
+	}
+
+	for(unsigned char i = 0; i < 26; i++) {
+		mForwardHashLUT['A' + i] = translation[i];
+		mReverseHashLUT['A' + i] = translation[i];
+	}
+
+	// the reverse strand read is only complemented in basespace
+	if(!mFlags.EnableColorspace) {
+		mReverseHashLUT['A'] = 3;
+		mReverseHashLUT['C'] = 2;
+		mReverseHashLUT['G'] = 1;
+		mReverseHashLUT['T'] = 0;
+	}
+
+	// consolidate the hash hits by diagonal sorting
+	if(flags.UseDiagonalSeedSorting) {
+		mHashRegionTree.EnableDiagonalSeedSorting();
+		mReverseHashRegionTree.EnableDiagonalSeedSorting();
+	}
+
 	// assign the reference sequences to the colorspace utilities object
 	mCS.SetReferenceSequences(pBsRefSeqs);
+
+	// the score-only pass bounds the aligned length and the mismatches of an alignment from its best cell
+	// N.B. colorspace alignments change both when converted to basespace
+	const bool canBoundMismatches = (mFilters.UseMismatchFilter || mFilters.UseMismatchPercentFilter) && !mFlags.UseAlignedReadLengthForMismatchCalculation;
+	const bool canBoundLength     = mFilters.UseMinAlignmentFilter || mFilters.UseMinAlignmentPercentFilter;
+	mIsUsingScorePrefilter = !mFlags.EnableColorspace && (canBoundMismatches || canBoundLength) && (mMaxMismatchPenalty > CPairwiseUtilities::MatchScore);
+
+	// the edit distance of the whole read bounds the mismatches of any alignment in the window
+	mIsUsingEditDistancePrefilter = !mFlags.EnableColorspace && canBoundMismatches;
 }
 
 // destructor
@@ -62,7 +104,7 @@ void* CAlignmentThread::StartThread(void* arg) {
 
 	// align reads
 	CAlignmentThread at(pTD->Algorithm, pTD->Filters, pTD->Flags, pTD->Mode, pTD->pReference, pTD->ReferenceLen, pTD->pDnaHash, pTD->Settings, pTD->pRefBegin, pTD->pRefEnd, pTD->pBsRefSeqs);
-	at.AlignReadArchive(pTD->pIn, pTD->pOut, pTD->pUnalignedStream, pTD->pReadCounter, pTD->IsPairedEnd);
+	at.AlignReadArchive(pTD->pIn, pTD->pOut, pTD->pUnalignedStream, pTD->IsPairedEnd);
 
 	vector<ReferenceSequence>::iterator refIter;
 
@@ -90,7 +132,7 @@ void* CAlignmentThread::StartThread(void* arg) {
 }
 
 // aligns the read archive
-void CAlignmentThread::AlignReadArchive(MosaikReadFormat::CReadReader* pIn, MosaikReadFormat::CAlignmentWriter* pOut, FILE* pUnalignedStream, uint64_t* pReadCounter, bool isPairedEnd) {
+void CAlignmentThread::AlignReadArchive(MosaikReadFormat::CReadPrefetcher* pIn, MosaikReadFormat::CAlignmentWriter* pOut, FILE* pUnalignedStream, bool isPairedEnd) {
 
 	// create our local alignment models
 	const bool isUsing454      = (mSettings.SequencingTechnology == ST_454      ? true : false);
@@ -114,19 +156,31 @@ void CAlignmentThread::AlignReadArchive(MosaikReadFormat::CReadReader* pIn, Mosa
 	// decide if we need to calculate the correction coefficient
 	const bool calculateCorrectionCoefficient = mFlags.IsUsingJumpDB && mFlags.IsUsingHashPositionThreshold;
 
+	// initialize our read batch
+	// N.B. the batches are recycled by the prefetcher to reuse their string buffers
+	MosaikReadFormat::ReadBatch* pReadBatch = NULL;
+	unsigned int batchIndex = 0;
+
+	// serialize our aligned reads into thread-local partitions
+	// N.B. only the handoff of compressed partitions to the archive is synchronized
+	MosaikReadFormat::CAlignmentWriter localOut;
+	localOut.OpenThreadLocal(pOut);
+
 	// keep reading until no reads remain
-	Mosaik::Read mr;
 	CNaiveAlignmentSet mate1Alignments(mReferenceLength, (isUsingIllumina || isUsingSOLiD)), mate2Alignments(mReferenceLength, (isUsingIllumina || isUsingSOLiD));
 
 	while(true) {
 
-		pthread_mutex_lock(&mGetReadMutex);
-		bool hasMoreReads = pIn->LoadNextRead(mr);
-		if(hasMoreReads) *pReadCounter = *pReadCounter + 1;
-		pthread_mutex_unlock(&mGetReadMutex);
+		// retrieve the next batch of reads once the current batch is exhausted
+		if(!pReadBatch || (batchIndex == pReadBatch->NumReads)) {
+			if(pReadBatch) pIn->ReleaseBatch(pReadBatch);
+
+			// quit if we've processed all of the reads
+			if(!pIn->GetNextBatch(pReadBatch)) break;
+			batchIndex = 0;
+		}
 
-		// quit if we've processed all of the reads
-		if(!hasMoreReads) break;
+		Mosaik::Read& mr = pReadBatch->Reads[batchIndex++];
 
 		// specify if this is a paired-end read
 		const unsigned short numMate1Bases = (unsigned short)mr.Mate1.Bases.Length();
@@ -369,11 +423,12 @@ void CAlignmentThread::AlignReadArchive(MosaikReadFormat::CReadReader* pIn, Mosa
 		// if any of the two mates aligned, save the read
 		if(isMate1Aligned || isMate2Aligned) {
 			mStatisticsCounters.AlignedReads++;
-			pthread_mutex_lock(&mSaveReadMutex);
-			pOut->SaveRead(mr, mate1Alignments, mate2Alignments);
-			pthread_mutex_unlock(&mSaveReadMutex);
+			localOut.SaveRead(mr, mate1Alignments, mate2Alignments);
 		}
 	}
+
+	// flush the remaining reads to the archive
+	localOut.Close();
 }
 
 // aligns the read against the reference sequence and returns true if the read was aligned
@@ -448,6 +503,12 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 		// used for all algorithms except fast
 		vector<HashRegion> forwardRegions, reverseRegions;
 
+		// hash both strands in one pass over the forward read
+		CreateHashes(mForwardRead, queryLength);
+
+		// canonical hashes retrieve the hash hits of both strands with one lookup per read position
+		if(mIsCanonicalHash) GetCanonicalHashRegions(queryLength, alignments.GetFwdMhpOccupancyList(), alignments.GetRevMhpOccupancyList());
+
 		// used for fast algorithm
 		HashRegion fastHashRegion;
 		bool isFastHashRegionReverseStrand = false;
@@ -461,8 +522,8 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 			int64_t forwardHashRegionLength = 0, reverseHashRegionLength = 0;
 			int64_t* pHashRegionLength = NULL;
 
-			GetFastReadCandidate(forwardHashRegion, mForwardRead, queryLength, alignments.GetFwdMhpOccupancyList());
-			GetFastReadCandidate(reverseHashRegion, mReverseRead, queryLength, alignments.GetRevMhpOccupancyList());
+			GetFastReadCandidate(forwardHashRegion, false, queryLength, alignments.GetFwdMhpOccupancyList());
+			GetFastReadCandidate(reverseHashRegion, true,  queryLength, alignments.GetRevMhpOccupancyList());
 
 			// detect failed hashes
 			if((forwardHashRegion.End == 0) && (reverseHashRegion.End == 0)) {
@@ -492,8 +553,8 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 
 		} else {
 
-			GetReadCandidates(forwardRegions, mForwardRead, queryLength, alignments.GetFwdMhpOccupancyList());
-			GetReadCandidates(reverseRegions, mReverseRead, queryLength, alignments.GetRevMhpOccupancyList());
+			GetReadCandidates(forwardRegions, false, queryLength, alignments.GetFwdMhpOccupancyList());
+			GetReadCandidates(reverseRegions, true,  queryLength, alignments.GetRevMhpOccupancyList());
 
 			// detect failed hashes
 			if(forwardRegions.empty() && reverseRegions.empty()) {
@@ -513,10 +574,10 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 			al.IsReverseStrand = isFastHashRegionReverseStrand;
 
 			// perform a Smith-Waterman alignment
-			AlignRegion(fastHashRegion, al, fastHashRead, queryLength, numExtensionBases);
+			const bool canPassFilters = AlignRegion(fastHashRegion, al, fastHashRead, queryLength, numExtensionBases);
 
 			// add the alignment to the vector if it passes the filters
-			if(ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
+			if(canPassFilters && ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
 
 			// increment our candidates counter
 			mStatisticsCounters.AlignmentCandidates++;
@@ -536,10 +597,10 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 				//al.IsReverseStrand = false;
 
 				// perform a Smith-Waterman alignment
-				AlignRegion(forwardRegions[i], al, mForwardRead, queryLength, numExtensionBases);
+				const bool canPassFilters = AlignRegion(forwardRegions[i], al, mForwardRead, queryLength, numExtensionBases);
 
 				// add the alignment to the alignments vector
-				if(ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
+				if(canPassFilters && ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
 
 				// increment our candidates counter
 				mStatisticsCounters.AlignmentCandidates++;
@@ -572,10 +633,10 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 					al.IsReverseStrand = true;
 
 					// perform a Smith-Waterman alignment
-					AlignRegion(reverseRegions[i], al, mReverseRead, queryLength, numExtensionBases);
+					const bool canPassFilters = AlignRegion(reverseRegions[i], al, mReverseRead, queryLength, numExtensionBases);
 
 					// add the alignment to the alignments vector
-					if(ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
+					if(canPassFilters && ApplyReadFilters(al, qualities, queryLength)) alignments.Add(al);
 
 					// increment our candidates counter
 					mStatisticsCounters.AlignmentCandidates++;
@@ -602,7 +663,9 @@ bool CAlignmentThread::AlignRead(CNaiveAlignmentSet& alignments, const char* que
 }
 
 // aligns the read against a specified hash region using Smith-Waterman-Gotoh
-void CAlignmentThread::AlignRegion(const HashRegion& r, Alignment& alignment, char* query, unsigned int queryLength, unsigned int extensionBases) {
+// N.B. returns false without performing the traceback when the score-only pass shows that the
+// region cannot produce an alignment that passes the read filters
+bool CAlignmentThread::AlignRegion(const HashRegion& r, Alignment& alignment, char* query, unsigned int queryLength, unsigned int extensionBases) {
 
 	// define the begin coordinate of our alignment region
 	unsigned int begin = r.End;
@@ -640,34 +703,52 @@ void CAlignmentThread::AlignRegion(const HashRegion& r, Alignment& alignment, ch
 	// perform a Smith-Waterman alignment on our region
 	char* pAnchor = mReference + begin;
 
-	// determine if the specified bandwidth is enough to accurately align using the banded algorithm
-	bool hasEnoughBandwidth = false;
-	HashRegion diagonalRegion = r;
+	// skip the dynamic programming when the read matches the reference exactly on the seed diagonal
+	if(!AlignUngapped(r, alignment, pAnchor, begin, end, query, queryLength)) {
 
-	if(mFlags.UseBandedSmithWaterman) {
+		// reject the window when the read is too far from every substring to pass the mismatch filters
+		if(mIsUsingEditDistancePrefilter && !CanPassMismatchFilters(pAnchor, (end - begin + 1), query, queryLength)) return false;
 
-		diagonalRegion.Begin -= begin;
-		diagonalRegion.End   -= begin;
+		// determine if the specified bandwidth is enough to accurately align using the banded algorithm
+		bool hasEnoughBandwidth = false;
+		HashRegion diagonalRegion = r;
 
-		unsigned int rowStart = min(diagonalRegion.Begin, (unsigned int)diagonalRegion.QueryBegin);
+		if(mFlags.UseBandedSmithWaterman) {
 
-		diagonalRegion.Begin      -= rowStart;
-		diagonalRegion.QueryBegin -= rowStart;
+			diagonalRegion.Begin -= begin;
+			diagonalRegion.End   -= begin;
 
-		hasEnoughBandwidth = (queryLength - diagonalRegion.QueryBegin) > mSettings.Bandwidth;
-		hasEnoughBandwidth = hasEnoughBandwidth && (((end - begin + 1) - diagonalRegion.Begin) > mSettings.Bandwidth / 2);
-	}
+			unsigned int rowStart = min(diagonalRegion.Begin, (unsigned int)diagonalRegion.QueryBegin);
 
-	if(mFlags.UseBandedSmithWaterman && hasEnoughBandwidth) {
-		mBSW.Align(alignment, pAnchor, (end - begin + 1), query, queryLength, diagonalRegion);
-	} else {
-		mSW.Align(alignment, pAnchor, (end - begin + 1), query, queryLength);
+			diagonalRegion.Begin      -= rowStart;
+			diagonalRegion.QueryBegin -= rowStart;
+
+			hasEnoughBandwidth = (queryLength - diagonalRegion.QueryBegin) > mSettings.Bandwidth;
+			hasEnoughBandwidth = hasEnoughBandwidth && (((end - begin + 1) - diagonalRegion.Begin) > mSettings.Bandwidth / 2);
+		}
+
+		if(mFlags.UseBandedSmithWaterman && hasEnoughBandwidth) {
+			mBSW.Align(alignment, pAnchor, (end - begin + 1), query, queryLength, diagonalRegion);
+		} else {
+
+			// score the region first when its seeds cover less than half of the read
+			// N.B. such regions rarely pass the filters, while well-seeded ones would pay for both passes
+			if(mIsUsingScorePrefilter && ((r.End - r.Begin + 1) < (queryLength / 2))) {
+				unsigned int queryEnd = 0;
+				const float bestScore = mSW.CalculateBestScore(pAnchor, (end - begin + 1), query, queryLength, queryEnd);
+				if(!CanPassReadFilters(bestScore, queryEnd, queryLength)) return false;
+			}
+
+			mSW.Align(alignment, pAnchor, (end - begin + 1), query, queryLength);
+		}
 	}
 
 	// adjust the reference start positions
 	alignment.ReferenceIndex = referenceIndex;
 	alignment.ReferenceBegin += begin - refBegin;
 	alignment.ReferenceEnd   += begin - refBegin;
+
+	return true;
 }
 
 // returns true if the alignment passes all of the user-specified filters
@@ -713,70 +794,256 @@ bool CAlignmentThread::ApplyReadFilters(Alignment& al, const char* qualities, co
 	return ret;
 }
 
-// creates the hash for a supplied fragment
-void CAlignmentThread::CreateHash(const char* fragment, const unsigned char fragmentLen, uint64_t& key) {
+// builds the alignment if the read matches the alignment window exactly on the diagonal of the hash region
+// N.B. such an alignment scores queryLength * match, which no other local alignment reaches unless the read also
+// occurs elsewhere in the window. Both sequences are limited to A, C, G and T: N never matches and the ambiguity
+// codes would match more than one base.
+bool CAlignmentThread::AlignUngapped(const HashRegion& r, Alignment& alignment, const char* pAnchor, const unsigned int begin, const unsigned int end, const char* query, const unsigned int queryLength) {
+
+	// the hash region must lie on a single diagonal and span nearly the whole read
+	const unsigned int regionLength = r.End - r.Begin + 1;
+	if((r.End - r.Begin) != (unsigned int)(r.QueryEnd - r.QueryBegin)) return false;
+	if((regionLength + mSettings.HashSize) < queryLength) return false;
+
+	// the diagonal must lie within the alignment window
+	if(r.Begin < r.QueryBegin) return false;
+	const unsigned int diagonalBegin = r.Begin - r.QueryBegin;
+	if((diagonalBegin < begin) || ((diagonalBegin + queryLength - 1) > end)) return false;
+
+	const unsigned int anchorLength = end - begin + 1;
+	const unsigned int offset       = diagonalBegin - begin;
+
+	// compare the read to the diagonal
+	if(CSequenceUtilities::CountMismatches(pAnchor + offset, query, queryLength) != 0) return false;
+	if(!CSequenceUtilities::HasOnlyCanonicalBases(query, queryLength) || !CSequenceUtilities::HasOnlyCanonicalBases(pAnchor, anchorLength)) return false;
+
+	// make sure that the read does not occur anywhere else in the window
+	for(unsigned int i = 0; (i + queryLength) <= anchorLength; i++)
+		if((i != offset) && (memcmp(pAnchor + i, query, queryLength) == 0)) return false;
+
+	// create the alignment (the coordinates are relative to the window like the Smith-Waterman results)
+	alignment.Reference.Copy(pAnchor + offset, queryLength);
+	alignment.Query.Copy(query, queryLength);
+	alignment.ReferenceBegin = offset;
+	alignment.ReferenceEnd   = offset + queryLength - 1;
+	alignment.QueryBegin     = 0;
+	alignment.QueryEnd       = queryLength - 1;
+	alignment.QueryLength    = queryLength;
+	alignment.NumMismatches  = 0;
 
-	// set the key to zero
-	key = 0;
+	return true;
+}
 
-	if(fragmentLen > 32) {
-		cout << "ERROR: This hash table can only handle fragments smaller or equal to 32 bases." << endl;
-		exit(1);
+// returns false if the read is too far from every substring of the alignment window to pass the mismatch filters
+// N.B. extending a local alignment with its unaligned read bases as insertions yields an alignment of the whole
+// read, so the total number of mismatches is never below the smallest edit distance of the whole read. The
+// mismatch percentage divides by the aligned length, which cannot exceed the read length.
+bool CAlignmentThread::CanPassMismatchFilters(const char* pAnchor, const unsigned int anchorLength, const char* query, const unsigned int queryLength) {
+
+	// calculate the number of edits allowed by the filters
+	unsigned int maxNumEdits = queryLength;
+	if(mFilters.UseMismatchFilter && (mFilters.MaxNumMismatches < maxNumEdits)) maxNumEdits = mFilters.MaxNumMismatches;
+
+	if(mFilters.UseMismatchPercentFilter) {
+		const unsigned int maxPercentEdits = (unsigned int)(queryLength * mFilters.MaxMismatchPercent + 0.001);
+		if(maxPercentEdits < maxNumEdits) maxNumEdits = maxPercentEdits;
 	}
 
-	// human genome 36.2
-	//
-	// A: 843953565
-	// C: 584268578
-	// G: 584621685
-	// M: 1
-	// N: 129484
-	// R: 2
-	// T: 845168978
-	char translation[26] = { 0, 3, 1, 3, -1, -1, 2, 3, -1, -1, 3, -1, 0, 3, -1, -1, -1, 0, 2, 3, -1, 0, 3, 1, 3, -1 };
-
-	// convert each nucleotide to its 2-bit representation
-	for(unsigned char i = 0; i < fragmentLen; i++) {
-
-		// convert [A,C,G,T] to [0,1,2,3]
-		char tValue = translation[fragment[i] - 'A'];
-
-		// catch any unrecognized nucleotides
-		if(tValue < 0) {
-			cout << "ERROR: Unrecognized nucleotide in hash table: " << fragment[i] << endl;
-			cout << "- fragment: ";
-			for(unsigned char j = 0; j < fragmentLen; j++) cout << std::hex << (int)fragment[j];
-			cout << endl;
-			exit(1);
+	return (mEditDistance.CalculateMinDistance(pAnchor, anchorLength, query, queryLength, maxNumEdits) <= maxNumEdits);
+}
+
+// returns false if no alignment with the specified best score and query end can pass the user-specified filters
+// N.B. the aligned read length cannot exceed the query prefix that ends at the best cell. Within it, each
+// mismatched or gapped base lowers the score from an all-match alignment by at most mMaxMismatchPenalty.
+// Both bounds only tighten as the aligned length grows, so they are evaluated at the longest length.
+bool CAlignmentThread::CanPassReadFilters(const float bestScore, const unsigned int queryEnd, const unsigned int queryLength) const {
+
+	// leave alignments without a positive score to the regular filters
+	if(bestScore <= 0.0f) return true;
+
+	const unsigned int maxQueryLength = queryEnd + 1;
+
+	// check the minimum alignment thresholds
+	if(mFilters.UseMinAlignmentFilter && (maxQueryLength < mFilters.MinAlignment)) return false;
+
+	if(mFilters.UseMinAlignmentPercentFilter) {
+		double percentageAligned = (double)maxQueryLength / (double)queryLength;
+		if(percentageAligned < mFilters.MinPercentAlignment) return false;
+	}
+
+	if(mFlags.UseAlignedReadLengthForMismatchCalculation) return true;
+
+	// calculate the lower bound on the total number of mismatches
+	// N.B. the small margin absorbs the floating point rounding of the best score
+	double minNumMismatches = (CPairwiseUtilities::MatchScore * maxQueryLength - bestScore) / mMaxMismatchPenalty - 0.01;
+	if(minNumMismatches < 0.0) minNumMismatches = 0.0;
+	minNumMismatches += queryLength - maxQueryLength;
+
+	// check the maximum mismatch thresholds
+	if(mFilters.UseMismatchFilter && (minNumMismatches > mFilters.MaxNumMismatches)) return false;
+
+	if(mFilters.UseMismatchPercentFilter) {
+		double percentMismatch = minNumMismatches / (double)maxQueryLength;
+		if(percentMismatch > mFilters.MaxMismatchPercent) return false;
+	}
+
+	return true;
+}
+
+// creates the forward and reverse strand hashes for every position in the read
+void CAlignmentThread::CreateHashes(const char* query, const unsigned int queryLength) {
+
+	const unsigned char hashSize = mSettings.HashSize;
+	const unsigned int numHashes = (queryLength >= hashSize ? queryLength - hashSize + 1 : 0);
+
+	mForwardHashes.resize(numHashes);
+	mReverseHashes.resize(numHashes);
+
+	const uint64_t keyMask = (hashSize >= 32 ? 0xffffffffffffffffULL : (1ULL << (hashSize * 2)) - 1);
+	const unsigned char reverseShift = (hashSize - 1) * 2;
+
+	// the reverse strand key of a window is built from the same bases, entering from the top
+	uint64_t forwardKey = 0, reverseKey = 0;
+	unsigned int numValidBases = 0;
+
+	for(unsigned int i = 0; i < queryLength; i++) {
+
+		const unsigned char base = (unsigned char)query[i];
+		const char forwardValue  = mForwardHashLUT[base];
+
+		if(forwardValue < 0) {
+			numValidBases = 0;
+		} else {
+			forwardKey = ((forwardKey << 2) | forwardValue) & keyMask;
+			reverseKey = (reverseKey >> 2) | ((uint64_t)mReverseHashLUT[base] << reverseShift);
+			numValidBases++;
 		}
 
-		// shift the key and add the new value
-		key = key << 2 | tValue;
+		if(i + 1 < hashSize) continue;
+
+		// store the window ending at the current base
+		const unsigned int forwardIndex = i + 1 - hashSize;
+		const unsigned int reverseIndex = numHashes - 1 - forwardIndex;
+		const bool isValid = (numValidBases >= hashSize);
+
+		mForwardHashes[forwardIndex].Key     = forwardKey;
+		mForwardHashes[forwardIndex].IsValid = isValid;
+		mReverseHashes[reverseIndex].Key     = reverseKey;
+		mReverseHashes[reverseIndex].IsValid = isValid;
 	}
 }
 
-// consolidates hash hits into a read candidate (fast algorithm)
-void CAlignmentThread::GetFastReadCandidate(HashRegion& region, char* query, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
+// adds the hash hits of both strands to the hash region trees with one canonical lookup per read position
+void CAlignmentThread::GetCanonicalHashRegions(const unsigned int queryLength, MhpOccupancyList* pForwardMhpOccupancyList, MhpOccupancyList* pReverseMhpOccupancyList) {
 
 	// localize the hash size
 	unsigned char hashSize = mSettings.HashSize;
+	const unsigned int numHashes = queryLength - hashSize + 1;
+
+	mHashRegionTree.Clear();
+	mHashRegionTree.SetExpectedQueryLength(queryLength);
+	mReverseHashRegionTree.Clear();
+	mReverseHashRegionTree.SetExpectedQueryLength(queryLength);
+
+	// collect the windows that can be hashed (the reverse strand window covers the same bases)
+	mHashLookups.clear();
+
+	for(unsigned int i = 0; i < numHashes; ++i) {
+		if(!mForwardHashes[i].IsValid) continue;
+		const unsigned int reverseIndex = numHashes - 1 - i;
 
-	// initialize the mhp occupancy list
+		HashLookup lookup;
+		lookup.Key                  = mForwardHashes[i].Key;
+		lookup.QueryPosition        = i;
+		lookup.ReverseKey           = mReverseHashes[reverseIndex].Key;
+		lookup.ReverseQueryPosition = reverseIndex;
+		mHashLookups.push_back(lookup);
+	}
+
+	mpDNAHash->GetCanonicalBatch(mHashLookups, mHashRegionTree, mReverseHashRegionTree);
+
+	// initialize the mhp occupancy lists (skipped windows use the default occupancy)
+	pForwardMhpOccupancyList->resize(numHashes);
+	pReverseMhpOccupancyList->resize(numHashes);
+
+	MhpOccupancyList::iterator forwardMhpIter = pForwardMhpOccupancyList->begin();
+	MhpOccupancyList::iterator reverseMhpIter = pReverseMhpOccupancyList->begin();
+
+	// the lookups are in ascending forward (and descending reverse) query position order
+	vector<HashLookup>::const_iterator forwardLookupIter = mHashLookups.begin();
+	vector<HashLookup>::const_reverse_iterator reverseLookupIter = mHashLookups.rbegin();
+
+	for(unsigned int i = 0; i < numHashes; ++i, ++forwardMhpIter, ++reverseMhpIter) {
+		forwardMhpIter->Begin = i;
+		forwardMhpIter->End   = i + hashSize - 1;
+		reverseMhpIter->Begin = i;
+		reverseMhpIter->End   = i + hashSize - 1;
+
+		if((forwardLookupIter != mHashLookups.end()) && (forwardLookupIter->QueryPosition == i)) {
+			forwardMhpIter->Occupancy = forwardLookupIter->MhpOccupancy;
+			++forwardLookupIter;
+		} else forwardMhpIter->Occupancy = 1.0;
+
+		if((reverseLookupIter != mHashLookups.rend()) && (reverseLookupIter->ReverseQueryPosition == i)) {
+			reverseMhpIter->Occupancy = reverseLookupIter->ReverseMhpOccupancy;
+			++reverseLookupIter;
+		} else reverseMhpIter->Occupancy = 1.0;
+	}
+}
+
+// adds the hash hits of every valid read position to the hash region tree
+void CAlignmentThread::GetHashRegions(AVLTree::CHashRegionTree& hrt, const vector<ReadHash>& hashes, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
+
+	// localize the hash size
+	unsigned char hashSize = mSettings.HashSize;
 	const unsigned int numHashes = queryLength - hashSize + 1;
+
+	hrt.Clear();
+	hrt.SetExpectedQueryLength(queryLength);
+
+	// collect the windows that can be hashed
+	mHashLookups.clear();
+	vector<ReadHash>::const_iterator hashIter = hashes.begin();
+
+	for(unsigned int i = 0; i < numHashes; ++i, ++hashIter) {
+		if(!hashIter->IsValid) continue;
+		HashLookup lookup;
+		lookup.Key           = hashIter->Key;
+		lookup.QueryPosition = i;
+		mHashLookups.push_back(lookup);
+	}
+
+	// retrieve the hash positions in one batch so that the hash table can prefetch them
+	mpDNAHash->GetBatch(mHashLookups, hrt);
+
+	// initialize the mhp occupancy list (skipped windows use the default occupancy)
 	pMhpOccupancyList->resize(numHashes);
 	MhpOccupancyList::iterator mhpIter = pMhpOccupancyList->begin();
+	vector<HashLookup>::const_iterator lookupIter = mHashLookups.begin();
 
-	// get hash hits from the hash region tree
-	AVLTree::CHashRegionTree hrt(queryLength, hashSize);
-	uint64_t key;
-	char* pQuery = query;
-
-	for(unsigned int i = 0; i < numHashes; ++i, ++pQuery, ++mhpIter) {
-		CreateHash(pQuery, hashSize, key);
+	for(unsigned int i = 0; i < numHashes; ++i, ++mhpIter) {
 		mhpIter->Begin = i;
 		mhpIter->End   = i + hashSize - 1;
-		mpDNAHash->Get(key, i, hrt, mhpIter->Occupancy);
+
+		if((lookupIter != mHashLookups.end()) && (lookupIter->QueryPosition == i)) {
+			mhpIter->Occupancy = lookupIter->MhpOccupancy;
+			++lookupIter;
+		} else mhpIter->Occupancy = 1.0;
 	}
+}
+
+// returns the hash region tree of the specified strand (canonical hashes retrieved both strands beforehand)
+AVLTree::CHashRegionTree& CAlignmentThread::GetStrandHashRegions(const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
+	if(mIsCanonicalHash) return (isReverseStrand ? mReverseHashRegionTree : mHashRegionTree);
+	GetHashRegions(mHashRegionTree, (isReverseStrand ? mReverseHashes : mForwardHashes), queryLength, pMhpOccupancyList);
+	return mHashRegionTree;
+}
+
+// consolidates hash hits into a read candidate (fast algorithm)
+void CAlignmentThread::GetFastReadCandidate(HashRegion& region, const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
+
+	// get hash hits from the hash region tree
+	AVLTree::CHashRegionTree& hrt = GetStrandHashRegions(isReverseStrand, queryLength, pMhpOccupancyList);
 
 	// find the largest region
 	unsigned int regionLength, largestRegionLength = 0;
@@ -793,27 +1060,10 @@ void CAlignmentThread::GetFastReadCandidate(HashRegion& region, char* query, con
 }
 
 // consolidates hash hits into read candidates
-void CAlignmentThread::GetReadCandidates(vector<HashRegion>& regions, char* query, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
-
-	// localize the hash size
-	unsigned char hashSize = mSettings.HashSize;
-
-	// initialize the mhp occupancy list
-	const unsigned int numHashes = queryLength - hashSize + 1;
-	pMhpOccupancyList->resize(numHashes);
-	MhpOccupancyList::iterator mhpIter = pMhpOccupancyList->begin();
+void CAlignmentThread::GetReadCandidates(vector<HashRegion>& regions, const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList) {
 
 	// get hash hits from the hash region tree
-	AVLTree::CHashRegionTree hrt(queryLength, hashSize);
-	uint64_t key;
-	char* pQuery = query;
-
-	for(unsigned int i = 0; i < numHashes; ++i, ++pQuery, ++mhpIter) {
-		CreateHash(pQuery, hashSize, key);
-		mhpIter->Begin = i;
-		mhpIter->End   = i + hashSize - 1;
-		mpDNAHash->Get(key, i, hrt, mhpIter->Occupancy);
-	}
+	AVLTree::CHashRegionTree& hrt = GetStrandHashRegions(isReverseStrand, queryLength, pMhpOccupancyList);
 
 	// add the consolidated regions
 	regions.resize(hrt.GetCount());
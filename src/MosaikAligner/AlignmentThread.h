@@ -18,10 +18,11 @@
 #include "AlignmentWriter.h"
 #include "BandedSmithWaterman.h"
 #include "ColorspaceUtilities.h"
+#include "MyersEditDistance.h"
 #include "NaiveAlignmentSet.h"
 #include "PairwiseUtilities.h"
 #include "PosixThreads.h"
-#include "ReadReader.h"
+#include "ReadPrefetcher.h"
 #include "ReferenceSequence.h"
 #include "SequenceUtilities.h"
 #include "SmithWatermanGotoh.h"
@@ -30,6 +31,10 @@ using namespace std;
 
 #define ALLOCATION_EXTENSION 10
 
+// the number of read batches allocated per alignment thread
+// N.B. each thread holds one batch, the remainder are loaded ahead of time
+#define READ_BATCHES_PER_THREAD 3
+
 // add our alignment status codes
 typedef unsigned char AlignmentStatusType;
 const AlignmentStatusType ALIGNMENTSTATUS_GOOD        = 10;
@@ -55,6 +60,7 @@ public:
 	struct AlignerSettings {
 		string AlignedReadReportFilename;
 		string BasespaceReferenceFilename;
+		string HashSnapshotFilename;
 		string InputReadArchiveFilename;
 		string JumpFilenameStub;
 		string OutputReadArchiveFilename;
@@ -65,6 +71,7 @@ public:
 		unsigned int LocalAlignmentSearchRadius;
 		unsigned int MedianFragmentLength;
 		unsigned int NumCachedHashes;
+		unsigned int ReadBatchSize;
 		unsigned short AlignmentCandidateThreshold;
 		unsigned short HashPositionThreshold;
 		unsigned char HashSize;
@@ -101,11 +108,16 @@ public:
 		bool IsReportingUnalignedReads;
 		bool IsUsingAlignmentCandidateThreshold;
 		bool IsUsingHashPositionThreshold;
+		bool IsUsingHashSnapshot;
 		bool IsUsingJumpDB;
 		bool KeepJumpKeysInMemory;
 		bool KeepJumpPositionsInMemory;
+		bool MapJumpDB;
+		bool PrefetchJumpDB;
 		bool UseAlignedReadLengthForMismatchCalculation;
+		bool UseJumpKmerFilter;
 		bool UseBandedSmithWaterman;
+		bool UseDiagonalSeedSorting;
 		bool UseLocalAlignmentSearch;
 		bool UsePairedEndOutput;
 
@@ -115,11 +127,16 @@ public:
 			, IsReportingUnalignedReads(false)
 			, IsUsingAlignmentCandidateThreshold(false)
 			, IsUsingHashPositionThreshold(false)
+			, IsUsingHashSnapshot(false)
 			, IsUsingJumpDB(false)
 			, KeepJumpKeysInMemory(false)
 			, KeepJumpPositionsInMemory(false)
+			, MapJumpDB(false)
+			, PrefetchJumpDB(false)
 			, UseAlignedReadLengthForMismatchCalculation(false)
+			, UseJumpKmerFilter(false)
 			, UseBandedSmithWaterman(false)
+			, UseDiagonalSeedSorting(false)
 			, UseLocalAlignmentSearch(false)
 			, UsePairedEndOutput(false)
 		{}
@@ -173,26 +190,23 @@ public:
 		FlagData Flags;
 		StatisticsCounters* pCounters;
 		CAbstractDnaHash* pDnaHash;
-		MosaikReadFormat::CReadReader* pIn;
+		MosaikReadFormat::CReadPrefetcher* pIn;
 		MosaikReadFormat::CAlignmentWriter* pOut;
 		FILE* pUnalignedStream;
 		unsigned int ReferenceLen;
 		char* pReference;
 		unsigned int* pRefBegin;
 		unsigned int* pRefEnd;
-		uint64_t* pReadCounter;
 		bool IsPairedEnd;
 		char** pBsRefSeqs;
 	};
 	// aligns the read archive
-	void AlignReadArchive(MosaikReadFormat::CReadReader* pIn, MosaikReadFormat::CAlignmentWriter* pOut, FILE* pUnalignedStream, uint64_t* pReadCounter, bool isPairedEnd);
+	void AlignReadArchive(MosaikReadFormat::CReadPrefetcher* pIn, MosaikReadFormat::CAlignmentWriter* pOut, FILE* pUnalignedStream, bool isPairedEnd);
 	// activates the current alignment thread
 	static void* StartThread(void* arg);
 	// register our thread mutexes
-	static pthread_mutex_t mGetReadMutex;
 	static pthread_mutex_t mReportUnalignedMate1Mutex;
 	static pthread_mutex_t mReportUnalignedMate2Mutex;
-	static pthread_mutex_t mSaveReadMutex;
 	static pthread_mutex_t mStatisticsMutex;
 	// stores the statistical counters
 	StatisticsCounters mStatisticsCounters;
@@ -213,18 +227,40 @@ private:
 			, IsTargetReverseStrand(false)
 		{}
 	};
+	// stores the hash of one read position
+	struct ReadHash {
+		uint64_t Key;
+		bool IsValid;
+
+		ReadHash(void)
+			: Key(0)
+			, IsValid(false)
+		{}
+	};
 	// aligns the read against the reference sequence and returns true if the read was aligned
 	bool AlignRead(CNaiveAlignmentSet& alignments, const char* query, const char* qualities, const unsigned int queryLength, AlignmentStatusType& status);
-	// aligns the read against a specified hash region using Smith-Waterman-Gotoh
-	void AlignRegion(const HashRegion& r, Alignment& alignment, char* query, unsigned int queryLength, unsigned int extensionBases);
+	// aligns the read against a specified hash region using Smith-Waterman-Gotoh (returns false if the region cannot pass the filters)
+	bool AlignRegion(const HashRegion& r, Alignment& alignment, char* query, unsigned int queryLength, unsigned int extensionBases);
+	// builds the alignment if the read matches the reference exactly on the hash region diagonal
+	bool AlignUngapped(const HashRegion& r, Alignment& alignment, const char* pAnchor, const unsigned int begin, const unsigned int end, const char* query, const unsigned int queryLength);
+	// returns false if the read is too far from every substring of the alignment window to pass the mismatch filters
+	bool CanPassMismatchFilters(const char* pAnchor, const unsigned int anchorLength, const char* query, const unsigned int queryLength);
 	// returns true if the alignment passes all of the user-specified filters
 	bool ApplyReadFilters(Alignment& al, const char* qualities, const unsigned int queryLength);
-	// creates the hash for a supplied fragment
-	void CreateHash(const char* fragment, const unsigned char fragmentLen, uint64_t& key);
+	// returns false if no alignment with the specified best score and query end can pass the user-specified filters
+	bool CanPassReadFilters(const float bestScore, const unsigned int queryEnd, const unsigned int queryLength) const;
+	// creates the forward and reverse strand hashes for every position in the read
+	void CreateHashes(const char* query, const unsigned int queryLength);
+	// adds the hash hits of both strands to the hash region trees with one canonical lookup per read position
+	void GetCanonicalHashRegions(const unsigned int queryLength, MhpOccupancyList* pForwardMhpOccupancyList, MhpOccupancyList* pReverseMhpOccupancyList);
+	// adds the hash hits of every valid read position to the hash region tree
+	void GetHashRegions(AVLTree::CHashRegionTree& hrt, const vector<ReadHash>& hashes, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
+	// returns the hash region tree of the specified strand (canonical hashes retrieved both strands beforehand)
+	AVLTree::CHashRegionTree& GetStrandHashRegions(const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
 	// consolidates hash hits into a read candidate (fast algorithm)
-	void GetFastReadCandidate(HashRegion& region, char* query, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
+	void GetFastReadCandidate(HashRegion& region, const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
 	// consolidates hash hits into read candidates
-	void GetReadCandidates(vector<HashRegion>& regions, char* query, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
+	void GetReadCandidates(vector<HashRegion>& regions, const bool isReverseStrand, const unsigned int queryLength, MhpOccupancyList* pMhpOccupancyList);
 	// attempts to rescue the mate paired with a unique mate
 	bool RescueMate(const LocalAlignmentModel& lam, const CMosaikString& bases, const unsigned int uniqueBegin, const unsigned int uniqueEnd, const unsigned int refIndex, Alignment& al);
 	// denotes the active alignment algorithm
@@ -249,6 +285,8 @@ private:
 	// our Smith-Waterman-Gotoh local alignment algorithms
 	CSmithWatermanGotoh mSW;
 	CBandedSmithWaterman mBSW;
+	// our bit-parallel edit distance prefilter
+	CMyersEditDistance mEditDistance;
 	// our base quality LUT
 	double mBaseQualityLUT[100];
 	// our reference sequence LUTs
@@ -261,5 +299,25 @@ private:
 	static const double TWO_NINTHS;
 	// our colorspace to basespace converter
 	CColorspaceUtilities mCS;
+	// consolidates the hash hits (reused for every read)
+	AVLTree::CHashRegionTree mHashRegionTree;
+	// consolidates the reverse strand hash hits (canonical hashes only)
+	AVLTree::CHashRegionTree mReverseHashRegionTree;
+	// toggles if the hash table stores canonical keys
+	bool mIsCanonicalHash;
+	// toggles the score-only pass that rejects alignment candidates before their traceback
+	bool mIsUsingScorePrefilter;
+	// the largest score reduction caused by a single mismatched or gapped base
+	float mMaxMismatchPenalty;
+	// toggles the edit distance prefilter that rejects alignment windows before Smith-Waterman
+	bool mIsUsingEditDistancePrefilter;
+	// the hashes of the current read on each strand
+	vector<ReadHash> mForwardHashes;
+	vector<ReadHash> mReverseHashes;
+	// the hash lookups of the current read strand
+	vector<HashLookup> mHashLookups;
+	// translates nucleotides to their 2-bit hash values (-1 for bases that cannot be hashed)
+	char mForwardHashLUT[256];
+	char mReverseHashLUT[256];
 	vector<ReferenceSequence> mpBsRefSeqs;
 };
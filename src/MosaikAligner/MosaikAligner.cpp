@@ -23,6 +23,7 @@ CMosaikAligner::CMosaikAligner(unsigned char hashSize, CAlignmentThread::Aligner
 	mSettings.HashSize            = hashSize;
 	mSettings.AllocatedReadLength = 0;
 	mSettings.NumThreads          = numThreads;
+	mSettings.ReadBatchSize       = 1;
 }
 
 // deconstructor
@@ -70,11 +71,31 @@ void CMosaikAligner::AlignReadArchive(void) {
 		cout << "finished." << endl;
 	}
 
+	// a hash table snapshot replaces the hash table, so the initial table can stay small
+	HashSnapshotIdentity snapshotIdentity;
+	bool hasSnapshot = false, isSnapshotLoaded = false;
+
+	if(mFlags.IsUsingHashSnapshot) {
+		GetHashSnapshotIdentity(referenceSequences, snapshotIdentity);
+		hasSnapshot = CFileUtilities::CheckFile(mSettings.HashSnapshotFilename.c_str(), false);
+	}
+
 	// initialize our hash tables
-	InitializeHashTables(CalculateHashTableSize(mReferenceLength, mSettings.HashSize));
+	InitializeHashTables(hasSnapshot ? 8 : CalculateHashTableSize(mReferenceLength, mSettings.HashSize));
 
-	// hash the concatenated reference sequence
-	if(!mFlags.IsUsingJumpDB) HashReferenceSequence(refseq);
+	if(hasSnapshot) {
+		cout << "- loading hash table snapshot... ";
+		cout.flush();
+		isSnapshotLoaded = mpDNAHash->LoadSnapshot(mSettings.HashSnapshotFilename, snapshotIdentity);
+		cout << (isSnapshotLoaded ? "finished." : "not found.") << endl;
+	}
+
+	// hash the concatenated reference sequence (some hash tables need several passes)
+	if(!mFlags.IsUsingJumpDB && !isSnapshotLoaded) {
+		do {
+			HashReferenceSequence(refseq);
+		} while(!mpDNAHash->FinishBuildPass());
+	}
 
 	cout << "- loading reference sequence... ";
 	cout.flush();
@@ -93,9 +114,17 @@ void CMosaikAligner::AlignReadArchive(void) {
 	}
 
 	// set the hash positions threshold
-	if(mFlags.IsUsingHashPositionThreshold && (mAlgorithm == CAlignmentThread::AlignerAlgorithm_ALL)) 
+	if(mFlags.IsUsingHashPositionThreshold && (mAlgorithm == CAlignmentThread::AlignerAlgorithm_ALL) && !isSnapshotLoaded) 
 		mpDNAHash->RandomizeAndTrimHashPositions(mSettings.HashPositionThreshold);
 
+	// save the finished hash table for later runs
+	if(mFlags.IsUsingHashSnapshot && !isSnapshotLoaded) {
+		cout << "- saving hash table snapshot... ";
+		cout.flush();
+		mpDNAHash->SaveSnapshot(mSettings.HashSnapshotFilename, snapshotIdentity);
+		cout << "finished." << endl;
+	}
+
 	// localize the read archive filenames
 	string inputReadArchiveFilename  = mSettings.InputReadArchiveFilename;
 	string outputReadArchiveFilename = mSettings.OutputReadArchiveFilename;
@@ -134,6 +163,9 @@ void CMosaikAligner::AlignReadArchive(void) {
 	uint64_t numReadArchiveReads = in.GetNumReads();
 	uint64_t readCounter = 0;
 
+	// initialize our read prefetcher
+	MosaikReadFormat::CReadPrefetcher prefetcher(&in, mSettings.ReadBatchSize, mSettings.NumThreads * READ_BATCHES_PER_THREAD, &readCounter);
+
 	// initialize our threads
 	pthread_t* activeThreads = new pthread_t[mSettings.NumThreads];
 
@@ -146,13 +178,12 @@ void CMosaikAligner::AlignReadArchive(void) {
 	td.pReference          = mReference;
 	td.pCounters           = &mStatisticsCounters;
 	td.pDnaHash            = mpDNAHash;
-	td.pIn                 = &in;
+	td.pIn                 = &prefetcher;
 	td.pOut                = &out;
 	td.pUnalignedStream    = unalignedStream;
 	td.pRefBegin           = pRefBegin;
 	td.pRefEnd             = pRefEnd;
 	td.Settings            = mSettings;
-	td.pReadCounter        = &readCounter;
 	td.IsPairedEnd         = isPairedEnd;
 	td.pBsRefSeqs          = pBsRefSeqs;
 
@@ -160,12 +191,9 @@ void CMosaikAligner::AlignReadArchive(void) {
 	pthread_attr_init(&attr);
 	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
-	pthread_mutex_init(&CAlignmentThread::mGetReadMutex,              NULL);
 	pthread_mutex_init(&CAlignmentThread::mReportUnalignedMate1Mutex, NULL);
 	pthread_mutex_init(&CAlignmentThread::mReportUnalignedMate2Mutex, NULL);
-	pthread_mutex_init(&CAlignmentThread::mSaveReadMutex,             NULL);
 	pthread_mutex_init(&CAlignmentThread::mStatisticsMutex,           NULL);
-	pthread_mutex_init(&CAbstractDnaHash::mJumpCacheMutex,            NULL);
 	pthread_mutex_init(&CAbstractDnaHash::mJumpKeyMutex,              NULL);
 	pthread_mutex_init(&CAbstractDnaHash::mJumpPositionMutex,         NULL);
 
@@ -180,6 +208,9 @@ void CMosaikAligner::AlignReadArchive(void) {
 
 	CProgressBar<uint64_t>::StartThread(&readCounter, 0, numReadArchiveReads, "reads");
 
+	// start loading reads ahead of the alignment threads
+	prefetcher.StartThread();
+
 	// create our threads
 	for(unsigned int i = 0; i < mSettings.NumThreads; i++)
 		pthread_create(&activeThreads[i], &attr, CAlignmentThread::StartThread, (void*)&td);
@@ -194,7 +225,8 @@ void CMosaikAligner::AlignReadArchive(void) {
 	for(unsigned int i = 0; i < mSettings.NumThreads; i++) 
 		pthread_join(activeThreads[i], &status);
 
-	// wait for the progress bar to finish
+	// wait for the read prefetcher and the progress bar to finish
+	prefetcher.WaitThread();
 	CProgressBar<uint64_t>::WaitThread();
 
 	alignmentBench.Stop();
@@ -353,6 +385,11 @@ void CMosaikAligner::EnableAlignmentCandidateThreshold(const unsigned short alig
 	mSettings.AlignmentCandidateThreshold = alignmentCandidateThreshold;
 }
 
+// enables batched read dispatch to the alignment threads
+void CMosaikAligner::EnableBatchedReadDispatch(const unsigned int readBatchSize) {
+	mSettings.ReadBatchSize = readBatchSize;
+}
+
 // enables the banded Smith-Waterman algorithm
 void CMosaikAligner::EnableBandedSmithWaterman(const unsigned int bandwidth) {
 	mFlags.UseBandedSmithWaterman = true;
@@ -365,12 +402,23 @@ void CMosaikAligner::EnableColorspace(const string& basespaceReferenceFilename)
 	mSettings.BasespaceReferenceFilename = basespaceReferenceFilename;
 }
 
+// enables diagonal sorting for the hash hit consolidation
+void CMosaikAligner::EnableDiagonalSeedSorting(void) {
+	mFlags.UseDiagonalSeedSorting = true;
+}
+
 // enables the hash position threshold
 void CMosaikAligner::EnableHashPositionThreshold(const unsigned short hashPositionThreshold) {
 	mFlags.IsUsingHashPositionThreshold = true;
 	mSettings.HashPositionThreshold = hashPositionThreshold;
 }
 
+// enables loading (or creating) a snapshot of the hash table
+void CMosaikAligner::EnableHashSnapshot(const string& filename) {
+	mFlags.IsUsingHashSnapshot     = true;
+	mSettings.HashSnapshotFilename = filename;
+}
+
 // enables the use of the jump database
 void CMosaikAligner::EnableJumpDB(const string& filenameStub, const unsigned int numCachedHashes, const bool keepKeysInMemory, const bool keepPositionsInMemory) {
 	mFlags.IsUsingJumpDB             = true;
@@ -380,6 +428,17 @@ void CMosaikAligner::EnableJumpDB(const string& filenameStub, const unsigned int
 	mSettings.NumCachedHashes        = numCachedHashes;
 }
 
+// enables memory mapping of the jump database
+void CMosaikAligner::EnableMemoryMappedJumpDB(const bool prefetch) {
+	mFlags.MapJumpDB      = true;
+	mFlags.PrefetchJumpDB = prefetch;
+}
+
+// enables the filter that skips the seeds of high-frequency k-mers
+void CMosaikAligner::EnableJumpKmerFilter(void) {
+	mFlags.UseJumpKmerFilter = true;
+}
+
 // enables the local alignment search
 void CMosaikAligner::EnableLocalAlignmentSearch(const unsigned int radius) {
 	mFlags.UseLocalAlignmentSearch       = true;
@@ -397,148 +456,120 @@ void CMosaikAligner::EnableUnalignedReadReporting(const string& unalignedReadRep
 	mFlags.IsReportingUnalignedReads = true;
 }
 
-// hashes the reference sequence
-void CMosaikAligner::HashReferenceSequence(MosaikReadFormat::CReferenceSequenceReader& refseq) {
+// identifies the reference sequence and settings stored in a hash table snapshot
+void CMosaikAligner::GetHashSnapshotIdentity(const vector<ReferenceSequence>& referenceSequences, HashSnapshotIdentity& identity) const {
 
-	// retrieve the 2-bit reference sequence and associated masking sequence
-	char* twoBitConcatenatedSequence = NULL;
-	char* maskSequence               = NULL;
-	unsigned int numMaskedPositions;
+	// FNV-1a over the reference sequence names, lengths and MD5 checksums
+	uint64_t checksum = 14695981039346656037ULL;
+	for(vector<ReferenceSequence>::const_iterator rsIter = referenceSequences.begin(); rsIter != referenceSequences.end(); ++rsIter) {
 
-	refseq.Load2BitConcatenatedSequence(twoBitConcatenatedSequence, maskSequence, numMaskedPositions);
-	unsigned int numBases = refseq.GetReferenceSequenceLength();
+		ostringstream sb;
+		sb << rsIter->Name << '\t' << rsIter->NumBases << '\t' << rsIter->MD5 << '\n';
+		const string description = sb.str();
 
-	// initialization
-	unsigned char rightMasks[4], rightShifts[4];
-	unsigned char leftMasks[4] = { 0xff, 0x3f, 0x0f, 0x03 };
+		for(string::const_iterator cIter = description.begin(); cIter != description.end(); ++cIter) {
+			checksum ^= (unsigned char)*cIter;
+			checksum *= 1099511628211ULL;
+		}
+	}
 
-	char* pAnchor = twoBitConcatenatedSequence;
+	identity.ReferenceLength       = mReferenceLength;
+	identity.ReferenceChecksum     = checksum;
+	identity.NumReferenceSequences = (uint32_t)referenceSequences.size();
+	identity.Algorithm             = (uint32_t)mAlgorithm;
+	identity.HashSize              = mSettings.HashSize;
+	identity.IsColorspace          = (mFlags.EnableColorspace ? 1 : 0);
 
-	uint64_t key, tKey;
-	unsigned char hashSize = mSettings.HashSize;
-	unsigned char hashBits = hashSize * 2;
+	// the hash positions are only trimmed by the all algorithm
+	if(mFlags.IsUsingHashPositionThreshold && (mAlgorithm == CAlignmentThread::AlignerAlgorithm_ALL))
+		identity.HashPositionThreshold = mSettings.HashPositionThreshold;
+}
 
-	unsigned char observedBytes[4];
-	for(unsigned char i = 0; i < 4; i++) {
-		unsigned char sumBits = (i * 2) + hashBits;
-		observedBytes[i]      = (unsigned char)ceil(sumBits / 8.0);
-	}
+// adds the hashes of the thread's build partitions that were collected by every thread
+void* CMosaikAligner::AddReferenceHashesThread(void* arg) {
 
-	unsigned char unusedRightBits = observedBytes[0] * 8 - hashBits;
+	HashingThreadData* pTD                      = (HashingThreadData*)arg;
+	CAbstractDnaHash* pDnaHash                  = pTD->pDnaHash;
+	const vector<HashingThreadData>& threadData = *pTD->pThreadData;
+	const unsigned int numPartitions            = pDnaHash->GetNumBuildPartitions();
 
-	switch(unusedRightBits) {
-	case 0:
-		rightMasks[0]  = 0xff;
-		rightMasks[1]  = 0xc0;
-		rightMasks[2]  = 0xf0;
-		rightMasks[3]  = 0xfc;
-		break;
-	case 2:
-		rightMasks[0]  = 0xfc;
-		rightMasks[1]  = 0xff;
-		rightMasks[2]  = 0xc0;
-		rightMasks[3]  = 0xf0;
-		break;
-	case 4:
-		rightMasks[0]  = 0xf0;
-		rightMasks[1]  = 0xfc;
-		rightMasks[2]  = 0xff;
-		rightMasks[3]  = 0xc0;
-		break;
-	case 6:
-		rightMasks[0]  = 0xc0;
-		rightMasks[1]  = 0xf0;
-		rightMasks[2]  = 0xfc;
-		rightMasks[3]  = 0xff;
-		break;
-	default:
-		cout << "ERROR: Unknown unused right bit combination." << endl;
-		exit(1);
-		break;
-	}
+	// the threads hash consecutive ranges, so the positions of each key are added in reference order
+	for(unsigned int p = pTD->ThreadIndex; p < numPartitions; p += pTD->NumThreads) {
 
-	short rightShift = unusedRightBits;
-	for(unsigned char i = 0; i < 4; i++) {
-		rightShifts[i] = (unsigned char)rightShift;
-		rightShift -= 2;
-		if(rightShift < 0) rightShift = 6;
-	}
+		for(vector<HashingThreadData>::const_iterator tIter = threadData.begin(); tIter != threadData.end(); ++tIter) {
+			const unsigned int end = tIter->PartitionOffsets[p + 1];
+			for(unsigned int i = tIter->PartitionOffsets[p]; i < end; i++) pDnaHash->Add(tIter->Hashes[i].Key, tIter->Hashes[i].Position);
+		}
 
-	unsigned int currentByte;
-	unsigned char cycle = 0;
-	unsigned char shift;
-	unsigned int numCompletedBytes = 0;
-
-	// initialize masking variables
-	unsigned int* pMask = (unsigned int*)maskSequence;
-	unsigned int maskBegin = 0xffffffff;
-	unsigned int maskEnd   = 0xffffffff;
-	unsigned int maskIndex = 0;
-	unsigned int maskMaxIndex = numMaskedPositions * 2;
-
-	if(numMaskedPositions > 0) {
-		maskBegin = pMask[maskIndex++];
-		maskEnd   = pMask[maskIndex++];
+		if(pTD->IsFinishingPartitions) pDnaHash->FinishBuildPartition(p);
 	}
 
+	return 0;
+}
+
+// hashes the reference sequence
+void CMosaikAligner::HashReferenceSequence(MosaikReadFormat::CReferenceSequenceReader& refseq) {
+
+	// retrieve the 2-bit reference sequence and associated masking sequence
+	char* twoBitConcatenatedSequence = NULL;
+	char* maskSequence               = NULL;
+	unsigned int numMaskedPositions  = 0;
+
+	refseq.Load2BitConcatenatedSequence(twoBitConcatenatedSequence, maskSequence, numMaskedPositions);
+	unsigned int numBases = refseq.GetReferenceSequenceLength();
+
+	// keys from different build partitions can be added concurrently
+	const unsigned int numPartitions = mpDNAHash->GetNumBuildPartitions();
+	unsigned int numThreads = (mSettings.NumThreads < numPartitions ? mSettings.NumThreads : numPartitions);
+	if(numThreads == 0) numThreads = 1;
+
 	unsigned int j = 0;
-	unsigned int maxPositions = (unsigned int)(numBases - hashSize + 1);
+	unsigned int maxPositions = (unsigned int)(numBases - mSettings.HashSize + 1);
+
+	HashingThreadData td;
+	td.pDnaHash              = mpDNAHash;
+	td.pTwoBitSequence       = (const unsigned char*)twoBitConcatenatedSequence;
+	td.pMask                 = (const unsigned int*)maskSequence;
+	td.NumMaskedPositions    = numMaskedPositions;
+	td.HashSize              = mSettings.HashSize;
+	td.NumThreads            = numThreads;
+	td.pThreadData           = NULL;
+	td.IsFinishingPartitions = false;
+
+	vector<HashingThreadData> threadData(numThreads, td);
+	vector<pthread_t> threads(numThreads);
+
+	for(unsigned int i = 0; i < numThreads; i++) {
+		threadData[i].ThreadIndex = i;
+		threadData[i].pThreadData = &threadData;
+	}
 
 	CConsole::Heading();
 	cout << endl << "Hashing reference sequence:" << endl;
 	CConsole::Reset();
 	CProgressBar<unsigned int>::StartThread(&j, 0, maxPositions, "ref bases");
 
-	for(; j < maxPositions; j++) {
-
-		// update mask
-		if(j > maskEnd) {
-			if(maskIndex == maskMaxIndex) {
-				maskBegin = 0xffffffff;
-				maskEnd   = 0xffffffff;
-			} else {
-				maskBegin = pMask[maskIndex++];
-				maskEnd   = pMask[maskIndex++];
-			}
-		}
-
-		// initialize
-		currentByte = numCompletedBytes + observedBytes[cycle] - 1;
-		shift       = -rightShifts[cycle];
-
-		// add the rightmost byte
-		tKey = pAnchor[currentByte--] & rightMasks[cycle];
-		key  = tKey >> -shift;
-		shift += 8;
-
-		// add the internal bytes
-		while(currentByte > numCompletedBytes) {
-			tKey = pAnchor[currentByte--] & 0xff;
-			key |= tKey << shift;
-			shift += 8;
-		}
+	// every thread hashes its own range of each chunk and groups the hashes by build partition. Afterwards
+	// every thread adds the hashes of its own build partitions, so no locking is needed.
+	void* status = NULL;
+	for(unsigned int chunkBegin = 0; chunkBegin < maxPositions; chunkBegin += REFERENCE_HASH_CHUNK_SIZE) {
 
-		// add the leftmost byte
-		tKey = pAnchor[currentByte] & leftMasks[cycle++];
-		key |= tKey << shift;
+		const unsigned int chunkEnd  = (maxPositions - chunkBegin > REFERENCE_HASH_CHUNK_SIZE ? chunkBegin + REFERENCE_HASH_CHUNK_SIZE : maxPositions);
+		const unsigned int rangeSize = (chunkEnd - chunkBegin + numThreads - 1) / numThreads;
 
-		// increment our offset cycle and 2-bit position
-		if(cycle > 3) {
-			cycle = 0;
-			numCompletedBytes++;
+		for(unsigned int i = 0; i < numThreads; i++) {
+			threadData[i].Begin = chunkBegin + (rangeSize * i < chunkEnd - chunkBegin ? rangeSize * i : chunkEnd - chunkBegin);
+			threadData[i].End   = (chunkEnd - threadData[i].Begin > rangeSize ? threadData[i].Begin + rangeSize : chunkEnd);
+			threadData[i].IsFinishingPartitions = (chunkEnd == maxPositions);
+			pthread_create(&threads[i], NULL, HashReferenceSequenceThread, (void*)&threadData[i]);
 		}
 
-		// check if we should mask this
-		bool maskPosition = false;
-		unsigned int jEnd = j + hashSize - 1;
-		if((j >= maskBegin) && (j <= maskEnd))      maskPosition = true;
-		if((maskBegin >= j) && (maskBegin <= jEnd)) maskPosition = true;
-		if((maskBegin >= j) && (maskEnd <= jEnd))   maskPosition = true;
-		if((j >= maskBegin) && (jEnd <= maskEnd))   maskPosition = true;
+		for(unsigned int i = 0; i < numThreads; i++) pthread_join(threads[i], &status);
 
-		if(maskPosition) continue;
+		for(unsigned int i = 0; i < numThreads; i++) pthread_create(&threads[i], NULL, AddReferenceHashesThread, (void*)&threadData[i]);
+		for(unsigned int i = 0; i < numThreads; i++) pthread_join(threads[i], &status);
 
-		mpDNAHash->Add(key, j);
+		j = chunkEnd;
 	}
 
 	CProgressBar<unsigned int>::WaitThread();
@@ -549,6 +580,76 @@ void CMosaikAligner::HashReferenceSequence(MosaikReadFormat::CReferenceSequenceR
 	delete [] maskSequence;
 }
 
+// hashes the thread's range of reference positions
+void* CMosaikAligner::HashReferenceSequenceThread(void* arg) {
+
+	HashingThreadData* pTD           = (HashingThreadData*)arg;
+	CAbstractDnaHash* pDnaHash       = pTD->pDnaHash;
+	const unsigned char* pAnchor     = pTD->pTwoBitSequence;
+	const unsigned int* pMask        = pTD->pMask;
+	const unsigned char hashSize     = pTD->HashSize;
+	const unsigned int numPartitions = pDnaHash->GetNumBuildPartitions();
+
+	const uint64_t keyMask = (hashSize >= 32 ? 0xffffffffffffffffULL : (1ULL << (hashSize * 2)) - 1);
+
+	// the 2-bit sequence stores the first base in the two most significant bits of each byte
+	uint64_t key = 0;
+	for(unsigned int i = pTD->Begin; i < pTD->Begin + hashSize - 1; i++)
+		key = (key << 2) | ((pAnchor[i >> 2] >> (6 - ((i & 3) << 1))) & 3);
+
+	// find the first masked region that does not end before our range
+	unsigned int maskIndex = 0, maskEnd = pTD->NumMaskedPositions;
+	while(maskIndex < maskEnd) {
+		const unsigned int middle = (maskIndex + maskEnd) / 2;
+		if(pMask[middle * 2 + 1] < pTD->Begin) maskIndex = middle + 1;
+		else maskEnd = middle;
+	}
+
+	vector<ReferenceHash>& hashes = pTD->UnsortedHashes;
+	hashes.clear();
+
+	ReferenceHash rh;
+	for(unsigned int j = pTD->Begin; j < pTD->End; j++) {
+
+		// roll the next base into the key
+		const unsigned int jEnd = j + hashSize - 1;
+		key = ((key << 2) | ((pAnchor[jEnd >> 2] >> (6 - ((jEnd & 3) << 1))) & 3)) & keyMask;
+
+		// skip hashes that overlap a masked region
+		while((maskIndex < pTD->NumMaskedPositions) && (pMask[maskIndex * 2 + 1] < j)) maskIndex++;
+		if((maskIndex < pTD->NumMaskedPositions) && (pMask[maskIndex * 2] <= jEnd)) continue;
+
+		// a single thread owns every build partition
+		if(pTD->NumThreads == 1) {
+			pDnaHash->Add(key, j);
+			continue;
+		}
+
+		rh.Key      = key;
+		rh.Position = j;
+		hashes.push_back(rh);
+	}
+
+	// group the hashes by build partition (a stable counting sort keeps them in reference order)
+	vector<unsigned int>& offsets = pTD->PartitionOffsets;
+	offsets.assign(numPartitions + 1, 0);
+
+	for(vector<ReferenceHash>::const_iterator hIter = hashes.begin(); hIter != hashes.end(); ++hIter)
+		offsets[pDnaHash->GetBuildPartition(hIter->Key) + 1]++;
+
+	for(unsigned int p = 0; p < numPartitions; p++) offsets[p + 1] += offsets[p];
+
+	pTD->Hashes.resize(hashes.size());
+	for(vector<ReferenceHash>::const_iterator hIter = hashes.begin(); hIter != hashes.end(); ++hIter)
+		pTD->Hashes[offsets[pDnaHash->GetBuildPartition(hIter->Key)]++] = *hIter;
+
+	// restore the partition offsets
+	for(unsigned int p = numPartitions; p > 0; p--) offsets[p] = offsets[p - 1];
+	offsets[0] = 0;
+
+	return 0;
+}
+
 // initializes the hash tables
 void CMosaikAligner::InitializeHashTables(const unsigned char bitSize) {
 
@@ -557,24 +658,33 @@ void CMosaikAligner::InitializeHashTables(const unsigned char bitSize) {
 	case CAlignmentThread::AlignerAlgorithm_FAST:
 	case CAlignmentThread::AlignerAlgorithm_SINGLE:
 		if(mFlags.IsUsingJumpDB) {
-			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 1, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes);
+			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 1, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes, mFlags.MapJumpDB, mFlags.PrefetchJumpDB);
 		} else mpDNAHash = new CDnaHash(bitSize, mSettings.HashSize);
 		break;
 	case CAlignmentThread::AlignerAlgorithm_MULTI:
 		if(mFlags.IsUsingJumpDB) {
-			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 9, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes);
+			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 9, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes, mFlags.MapJumpDB, mFlags.PrefetchJumpDB);
 		} else mpDNAHash = new CMultiDnaHash(bitSize, mSettings.HashSize);
 		break;
 	case CAlignmentThread::AlignerAlgorithm_ALL:
 		if(mFlags.IsUsingJumpDB) {
-			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 0, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes);
-		} else mpDNAHash = new CUbiqDnaHash(bitSize, mSettings.HashSize);
+			mpDNAHash = new CJumpDnaHash(mSettings.HashSize, mSettings.JumpFilenameStub, 0, mFlags.KeepJumpKeysInMemory, mFlags.KeepJumpPositionsInMemory, mSettings.NumCachedHashes, mFlags.MapJumpDB, mFlags.PrefetchJumpDB);
+		} else mpDNAHash = new CCsrDnaHash(bitSize, mSettings.HashSize);
 		break;
 	default:
 		cout << "ERROR: Unknown alignment algorithm specified." << endl;
 		exit(1);
 		break;
 	}
+
+	// the k-mer filter is stored next to the jump database
+	if(mFlags.UseJumpKmerFilter) ((CJumpDnaHash*)mpDNAHash)->LoadKmerFilter(mSettings.JumpFilenameStub + "_filter.jmp");
+
+	// canonical keys pair each k-mer with its basespace reverse complement
+	if(mFlags.EnableColorspace && mpDNAHash->IsCanonical()) {
+		cout << "ERROR: Canonical jump databases cannot be used with colorspace reads. Please create the jump database without the -ck parameter." << endl;
+		exit(1);
+	}
 }
 
 // sets the filenames used by the aligner
@@ -19,17 +19,21 @@
 #include "ReferenceSequence.h"
 #include "Benchmark.h"
 #include "ConsoleUtilities.h"
+#include "CsrDnaHash.h"
 #include "DnaHash.h"
+#include "FileUtilities.h"
 #include "JumpDnaHash.h"
 #include "ReadReader.h"
 #include "MultiDnaHash.h"
 #include "PosixThreads.h"
 #include "ProgressBar.h"
 #include "ReferenceSequenceReader.h"
-#include "UbiqDnaHash.h"
 
 using namespace std;
 
+// the number of reference positions hashed before the hashes are added to their build partitions
+#define REFERENCE_HASH_CHUNK_SIZE 2097152
+
 class CMosaikAligner {
 public:
 	// constructor
@@ -41,14 +45,24 @@ public:
 	void AlignReadArchive(void);
 	// enables the alignment candidate threshold
 	void EnableAlignmentCandidateThreshold(const unsigned short alignmentCandidateThreshold);
+	// enables batched read dispatch to the alignment threads
+	void EnableBatchedReadDispatch(const unsigned int readBatchSize);
 	// enables the banded Smith-Waterman algorithm
 	void EnableBandedSmithWaterman(const unsigned int bandwidth);
 	// enables SOLiD colorspace translation
 	void EnableColorspace(const string& basespaceReferenceFilename);
+	// enables diagonal sorting for the hash hit consolidation
+	void EnableDiagonalSeedSorting(void);
 	// enables the hash position threshold
 	void EnableHashPositionThreshold(const unsigned short hashPositionThreshold);
+	// enables loading (or creating) a snapshot of the hash table
+	void EnableHashSnapshot(const string& filename);
 	// enables the use of the jump database
 	void EnableJumpDB(const string& filenameStub, const unsigned int cacheSizeMB, const bool keepKeysInMemory, const bool keepPositionsInMemory);
+	// enables memory mapping of the jump database
+	void EnableMemoryMappedJumpDB(const bool prefetch);
+	// enables the filter that skips the seeds of high-frequency k-mers
+	void EnableJumpKmerFilter(void);
 	// enables the local alignment search
 	void EnableLocalAlignmentSearch(const unsigned int radius);
 	// enables paired-end read output
@@ -74,8 +88,39 @@ private:
 	CAlignmentThread::StatisticsCounters mStatisticsCounters;
 	// estimates the appropriate hash table size
 	static unsigned char CalculateHashTableSize(const unsigned int referenceLength, const unsigned char hashSize);
+	// stores a reference hash until the thread that owns its build partition adds it
+	struct ReferenceHash {
+		uint64_t Key;
+		unsigned int Position;
+	};
+	// stores the data used by a reference hashing thread
+	struct HashingThreadData {
+		CAbstractDnaHash* pDnaHash;
+		const unsigned char* pTwoBitSequence;
+		const unsigned int* pMask;
+		unsigned int NumMaskedPositions;
+		unsigned char HashSize;
+		unsigned int NumThreads;
+		unsigned int ThreadIndex;
+		// the reference positions hashed by this thread in the current chunk
+		unsigned int Begin;
+		unsigned int End;
+		// the hashes of those positions grouped by build partition
+		vector<ReferenceHash> Hashes;
+		vector<ReferenceHash> UnsortedHashes;
+		vector<unsigned int> PartitionOffsets;
+		// the data of every hashing thread (used when adding the hashes of the thread's build partitions)
+		const vector<HashingThreadData>* pThreadData;
+		bool IsFinishingPartitions;
+	};
+	// identifies the reference sequence and settings stored in a hash table snapshot
+	void GetHashSnapshotIdentity(const vector<ReferenceSequence>& referenceSequences, HashSnapshotIdentity& identity) const;
 	// hashes the reference sequence
 	void HashReferenceSequence(MosaikReadFormat::CReferenceSequenceReader& refseq);
+	// adds the hashes of the thread's build partitions that were collected by every thread
+	static void* AddReferenceHashesThread(void* arg);
+	// hashes the thread's range of reference positions
+	static void* HashReferenceSequenceThread(void* arg);
 	// initializes the hash tables
 	void InitializeHashTables(const unsigned char bitSize);
 	// the reference sequence
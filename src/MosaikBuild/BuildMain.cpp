@@ -42,6 +42,7 @@ struct ConfigurationSettings {
 	bool HasReadFasta2Filename;
 	bool HasReadFastaFilename;
 	bool HasReadGroupID;
+	bool HasNumCompressionThreads;
 	bool HasReadLimit;
 	bool HasReadNamePrefix;
 	bool HasSampleName;
@@ -86,6 +87,7 @@ struct ConfigurationSettings {
 	uint64_t ReadLimit;
 	unsigned char AssignedBQ;
 	unsigned int MedianFragmentLength;
+	unsigned int NumCompressionThreads;
 	unsigned int NumNBasesAllowed;
 	unsigned int NumTrimPrefixBases;
 	unsigned int NumTrimPrefixName;
@@ -113,6 +115,7 @@ struct ConfigurationSettings {
 		, HasReadFasta2Filename(false)
 		, HasReadFastaFilename(false)
 		, HasReadGroupID(false)
+		, HasNumCompressionThreads(false)
 		, HasReadLimit(false)
 		, HasReadNamePrefix(false)
 		, HasSampleName(false)
@@ -200,6 +203,7 @@ int main(int argc, char* argv[]) {
 
 	// add the read archive options
 	OptionGroup* pReadArchiveOpts = COptions::CreateOptionGroup("Read Archive Options");
+	COptions::AddValueOption("-ct",  "# of threads",         "compresses the partitions in # threads",   "", settings.HasNumCompressionThreads, settings.NumCompressionThreads, pReadArchiveOpts);
 	COptions::AddValueOption("-out", "MOSAIK read filename", "the output read file",                     "", settings.HasOutputReadsFilename, settings.OutputReadsFilename, pReadArchiveOpts);
 	COptions::AddValueOption("-p",   "read name prefix",     "adds the prefix to each read name",        "", settings.HasReadNamePrefix,      settings.ReadNamePrefix,      pReadArchiveOpts);
 	COptions::AddValueOption("-rl",  "# of reads",           "limits the # of reads processed",          "", settings.HasReadLimit,           settings.ReadLimit,           pReadArchiveOpts);
@@ -265,6 +269,12 @@ int main(int argc, char* argv[]) {
 		foundError = true;
 	}
 
+	// check the number of compression threads
+	if(settings.HasNumCompressionThreads && (settings.NumCompressionThreads < 1)) {
+		errorBuilder << ERROR_SPACER << "The number of compression threads should be at least 1." << endl;
+		foundError = true;
+	}
+
 	// check the sequencing technology
 	SequencingTechnologies seqTech = ST_UNKNOWN;
 
@@ -519,6 +529,12 @@ int main(int argc, char* argv[]) {
 		mb.EnableReadLimit(settings.ReadLimit);
 	}
 
+	// enable parallel partition compression
+	if(settings.HasNumCompressionThreads) {
+		cout << "- compressing the read archive partitions in " << settings.NumCompressionThreads << " threads" << endl;
+		mb.EnableParallelCompression(settings.NumCompressionThreads);
+	}
+
 	cout << endl;
 
 	// ================
@@ -31,6 +31,7 @@ CMosaikBuild::CMosaikBuild(const MosaikReadFormat::ReadGroup& md)
 , mReadSuffixTrim(0)
 , mReadNamePrefixTrim(0)
 , mReadNameSuffixTrim(0)
+, mNumCompressionThreads(1)
 {
 	// initialize the read and index buffer
 	try {
@@ -709,6 +710,11 @@ void CMosaikBuild::EnableReadLimit(const uint64_t readLimit) {
 	mReadLimit    = readLimit;
 }
 
+// Enables the compression of read archive partitions in multiple threads
+void CMosaikBuild::EnableParallelCompression(const unsigned int numThreads) {
+	mNumCompressionThreads = numThreads;
+}
+
 // returns the colorspace name for the given read name
 void CMosaikBuild::GetColorspaceName(const CMosaikString& readName, ColorspaceName& cn) {
 	vector<string> columns;
@@ -772,6 +778,7 @@ void CMosaikBuild::ParseBustard(const string& directory, const string& lanes, co
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, (splitReads ? RS_PAIRED_END_READ : RS_SINGLE_END_READ), mReadGroup);
 
 	unsigned int fBufferSize = 4096;
@@ -926,6 +933,7 @@ void CMosaikBuild::ParseFasta(const string& readFastaFilename, const string& out
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_SINGLE_END_READ, mReadGroup);
 
 	// initialize our reader
@@ -986,6 +994,7 @@ void CMosaikBuild::ParsePEFasta(string& readFastaFilename, string& readFastaFile
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_PAIRED_END_READ, mReadGroup);
 
 	bool removedMateSuffix = false;
@@ -1158,6 +1167,7 @@ void CMosaikBuild::ParseFastq(vector<string>& fastqFiles, const string& outputFi
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_SINGLE_END_READ, mReadGroup);
 
 	CColorspaceUtilities csu;
@@ -1237,6 +1247,7 @@ void CMosaikBuild::ParsePEFastq(vector<string>& mate1Files, vector<string>& mate
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_PAIRED_END_READ, mReadGroup);
 
 	CColorspaceUtilities csu;
@@ -1396,6 +1407,7 @@ void CMosaikBuild::ParseGerald(const string& directory, const string& lanes, con
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_SINGLE_END_READ, mReadGroup);
 
 	bool isRunning = true;
@@ -1450,6 +1462,7 @@ void CMosaikBuild::ParseSRF(vector<string>& srfFiles, const string& outputFilena
 
 	// initialize our writer
 	MosaikReadFormat::CReadWriter writer;
+	writer.EnableParallelCompression(mNumCompressionThreads);
 	writer.Open(outputFilename, RS_SINGLE_END_READ, mReadGroup);
 
 	bool isRunning = true;
@@ -80,6 +80,8 @@ public:
 	void EnableReadNamePrefix(const string& prefix);
 	// Enables a limit on the number of reads written to the read archive
 	void EnableReadLimit(const uint64_t readLimit);
+	// Enables the compression of read archive partitions in multiple threads
+	void EnableParallelCompression(const unsigned int numThreads);
 	// Parses an Illumina Bustard directory
 	void ParseBustard(const string& directory, const string& lanes, const string& outputFilename, const bool splitReads);
 	// Parses the sequence and quality FASTA files while writing to our read archive
@@ -210,4 +212,6 @@ private:
 	CMosaikString mReadNamePrefix;
 	// specifies the lanes that are allowed
 	bool mAllowedLanes[8];
+	// the number of threads used to compress the read archive partitions
+	unsigned int mNumCompressionThreads;
 };
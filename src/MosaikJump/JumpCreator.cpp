@@ -11,7 +11,7 @@
 #include "JumpCreator.h"
 
 // constructor
-CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameStub, const unsigned char sortingMemoryGB, const bool keepKeysInMemory, const unsigned int hashPositionThreshold)
+CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameStub, const unsigned char sortingMemoryGB, const bool keepKeysInMemory, const unsigned int hashPositionThreshold, const unsigned char numThreads, const bool useSparseKeys, const bool useCanonicalKeys, const vector<unsigned int>& subsampleCaps)
 : mHashSize(hashSize)
 , mSortingMemoryGB(sortingMemoryGB)
 , mKeys(NULL)
@@ -25,7 +25,26 @@ CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameS
 , mLogHashPositions(false)
 , mKeyBuffer(NULL)
 , mKeyBufferLen(0)
+, mNumThreads(numThreads > 0 ? numThreads : 1)
+, mNextBlockPosition(0)
+, mSortInMemory(false)
+, mPositionsOffset(0)
+, mNextKey(0)
+, mUseSparseKeys(useSparseKeys)
+, mSparseDirectoryBits(0)
+, mSparseLowBits(0)
+, mSparseLowBytes(0)
+, mNumSparseKeys(0)
+, mUseCanonicalKeys(useCanonicalKeys)
+, mStrandBits(useCanonicalKeys ? 1 : 0)
+, mUseCanonicalRanks(useCanonicalKeys && !useSparseKeys)
+, mSubsampleCaps(subsampleCaps)
+, mUseKmerFilter(false)
+, mKmerFilterThreshold(0)
+, mKmerFilterFilename(filenameStub + "_filter.jmp")
 {
+	pthread_mutex_init(&mHashingMutex, NULL);
+
 	// initialize the file buffer
 	try {
 		mBuffer = new unsigned char[mBufferLen];
@@ -34,12 +53,14 @@ CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameS
 		exit(1);
 	}
 
-	// initialize the key buffer
-	mKeyBufferLen = (uint64_t)(pow(4.0, (double)mHashSize) * KEY_LENGTH);
+	// initialize the key buffer (the sparse key records are always written sequentially)
+	if(mUseCanonicalRanks) mKeyBufferLen = CJumpCanonicalKeys::GetNumKeys(mHashSize) * KEY_LENGTH;
+	else mKeyBufferLen = (uint64_t)(pow(4.0, (double)mHashSize) * KEY_LENGTH);
+	if(mUseSparseKeys) mKeepKeysInMemory = false;
 
-	if(keepKeysInMemory) {
+	if(mKeepKeysInMemory) {
 		try {
-			unsigned int num64uint = (unsigned int)(mKeyBufferLen / (double)SIZEOF_UINT64);
+			unsigned int num64uint = (unsigned int)((mKeyBufferLen + SIZEOF_UINT64 - 1) / SIZEOF_UINT64);
 			mKeyBuffer = new uint64_t[num64uint];
 			const uint64_t EMPTY = 0xffffffffffffffffULL;
 			uninitialized_fill(mKeyBuffer, mKeyBuffer + num64uint, EMPTY);
@@ -60,6 +81,11 @@ CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameS
 		exit(1);
 	}
 
+	setvbuf(mKeys, NULL, _IOFBF, JUMP_OUTPUT_BUFFER_SIZE);
+
+	// the canonical ranks do not follow the hash order, so the keys kept on disk are filled in place
+	if(mUseCanonicalRanks && !mKeepKeysInMemory) WriteEmptyKeys(mKeyBufferLen / KEY_LENGTH);
+
 	FILE* meta = NULL;
 	fopen_s(&meta, metaFilename.c_str(), "wb");
 
@@ -69,6 +95,15 @@ CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameS
 	}
 
 	putc(hashSize, meta);
+	putc(JUMP_FORMAT_VERSION_3, meta);
+	putc((mUseSparseKeys ? JUMP_KEYS_SPARSE : JUMP_KEYS_DENSE), meta);
+	if(mUseCanonicalRanks)     putc(JUMP_STRANDS_CANONICAL_RANKED, meta);
+	else if(mUseCanonicalKeys) putc(JUMP_STRANDS_CANONICAL, meta);
+	else                       putc(JUMP_STRANDS_FORWARD, meta);
+
+	// the aligner needs the subsample caps to know where each tier ends
+	putc((unsigned char)mSubsampleCaps.size(), meta);
+	if(!mSubsampleCaps.empty()) fwrite((char*)&mSubsampleCaps[0], SIZEOF_INT, mSubsampleCaps.size(), meta);
 	fclose(meta);
 
 	fopen_s(&mPositions, positionsFilename.c_str(), "wb");
@@ -78,6 +113,8 @@ CJumpCreator::CJumpCreator(const unsigned char hashSize, const string& filenameS
 		exit(1);
 	}
 
+	setvbuf(mPositions, NULL, _IOFBF, JUMP_OUTPUT_BUFFER_SIZE);
+
 	if(hashPositionThreshold > 0) {
 		cout << "- setting hash position threshold to " << hashPositionThreshold << endl;
 		mLimitPositions   = true;
@@ -99,48 +136,97 @@ CJumpCreator::~CJumpCreator(void) {
 	// delete our temporary files
 	for(unsigned int i = 0; i < mSerializedPositionsFilenames.size(); i++)
 		rm(mSerializedPositionsFilenames[i].c_str());
+
+	pthread_mutex_destroy(&mHashingMutex);
 }
 
 // builds the jump database
 void CJumpCreator::BuildJumpDatabase(void) {
 
-	// ------------------------------
-	// create the jump database files
-	// ------------------------------
+	// -----------------------------------------
+	// write the hash positions in hash order
+	// -----------------------------------------
+
+	CConsole::Heading(); 
+	cout << endl << "- writing jump positions database:" << endl;
+	CConsole::Reset(); 
+
+	if(mUseSparseKeys) StartSparseKeys();
+
+	unsigned int numProcessed = 0;
+	CProgressBar<unsigned int>::StartThread(&numProcessed, 0, mNumHashPositions, "hash positions");
 
-	if(!mKeepKeysInMemory) {
+	if(mSortInMemory) StoreSortedHashPositions(numProcessed);
+	else MergeSortingFiles(numProcessed);
+
+	// stop the progress bar
+	CProgressBar<unsigned int>::WaitThread();
+
+	// write the keys to file
+	if(mUseSparseKeys) {
+
+		FinishSparseKeys();
+
+	} else if(mKeepKeysInMemory) {
 
 		uint64_t bytesLeft = mKeyBufferLen;
 
-		unsigned int fillBufferSize = 314572800; // 300 MB
+		unsigned int fillBufferSize = 314572800 ; // 300 MB
 		unsigned int numBuffers = (unsigned int)(mKeyBufferLen / (double)fillBufferSize);
 		unsigned int currentBuffer = 0;
+		char* pKeys = (char*)mKeyBuffer;
 
 		CConsole::Heading(); 
-		cout << endl << "- creating jump keys database (" << numBuffers << " blocks):" << endl;
+		cout << endl << "- serializing jump keys database (" << numBuffers << " blocks):" << endl;
 		CConsole::Reset(); 
 
-		char* fillBuffer = new char[fillBufferSize];
-		uninitialized_fill(fillBuffer, fillBuffer + fillBufferSize, 0xff);
-
 		bool isRunning = true;
 		CProgressCounter<unsigned int>::StartThread(&currentBuffer, &isRunning, "blocks");
 
 		for(; currentBuffer < numBuffers; currentBuffer++) {
-			fwrite(fillBuffer, fillBufferSize, 1, mKeys);
+			fwrite(pKeys, fillBufferSize, 1, mKeys);
+			pKeys     += fillBufferSize;
 			bytesLeft -= fillBufferSize;
 		}
 
-		fwrite(fillBuffer, (size_t)bytesLeft, 1, mKeys);
+		fwrite(pKeys, (size_t)bytesLeft, 1, mKeys);
 
 		// stop the progress counter
 		isRunning = false;
 		CProgressCounter<unsigned int>::WaitThread();
 
-		// clean up
-		delete [] fillBuffer;
+	} else {
+
+		// the keys were written in ascending order, so only the trailing keys are left
+		if(!mUseCanonicalRanks) WriteEmptyKeys(mKeyBufferLen / KEY_LENGTH - mNextKey);
 	}
 
+	if(mUseKmerFilter) WriteKmerFilter();
+}
+
+// stores a filter of the k-mers with more than the specified number of hash positions
+void CJumpCreator::EnableKmerFilter(const unsigned int positionThreshold) {
+	mUseKmerFilter       = true;
+	mKmerFilterThreshold = positionThreshold;
+}
+
+// writes the filter of the over-represented k-mers
+void CJumpCreator::WriteKmerFilter(void) {
+
+	CJumpKmerFilter filter;
+	filter.Initialize(mFrequentKeys.size(), mKmerFilterThreshold);
+
+	for(vector<uint64_t>::const_iterator kIter = mFrequentKeys.begin(); kIter != mFrequentKeys.end(); ++kIter)
+		filter.Add(*kIter);
+
+	filter.Save(mKmerFilterFilename);
+
+	cout << "- stored " << mFrequentKeys.size() << " k-mers with more than " << mKmerFilterThreshold << " hash positions in the k-mer filter" << endl;
+}
+
+// merges the sorted temporary files and stores the hash positions in the jump database
+void CJumpCreator::MergeSortingFiles(unsigned int& numProcessed) {
+
 	// ---------------------------------------
 	// open all of the temporary sorting files
 	// ---------------------------------------
@@ -156,21 +242,13 @@ void CJumpCreator::BuildJumpDatabase(void) {
 			cout << "ERROR: Unable to open temporary file (" << mSerializedPositionsFilenames[i] << ") for reading." << endl;
 			exit(1);
 		}
-	}
-
-	// -------------------------
-	// initialize sorting vector
-	// -------------------------
 
-	double memoryAllocated = mSortingMemoryGB * 1073741824.0;
-	unsigned int maxSortingElements = (int)(memoryAllocated / (double)sizeof(HashPosition));
-
-	vector<HashPosition> hashCounts;
-	hashCounts.reserve(maxSortingElements);
+		setvbuf(sortHandles[i], NULL, _IOFBF, JUMP_SORT_BUFFER_SIZE);
+	}
 
-	// ---------------
-	// get the top row
-	// ---------------
+	// ----------------------------------------------
+	// get the top row (a heap with the lowest hash)
+	// ----------------------------------------------
 
 	vector<HashPosition> sameHash;
 	vector<HashPosition> topRow;
@@ -182,90 +260,39 @@ void CJumpCreator::BuildJumpDatabase(void) {
 		if(hp.Deserialize(sortHandles[i])) topRow.push_back(hp);
 	}
 
-	sort(topRow.begin(), topRow.end(), SortHashPositionDesc());
+	make_heap(topRow.begin(), topRow.end(), SortHashPositionDesc());
 
 	// -----------------
 	// process the files
 	// -----------------
 
-	CConsole::Heading(); 
-	cout << endl << "- writing jump positions database:" << endl;
-	CConsole::Reset(); 
-
-	unsigned int numProcessed = 0;
-	CProgressBar<unsigned int>::StartThread(&numProcessed, 0, mNumHashPositions, "hash positions");
-
-	while(true) {
+	while(!topRow.empty()) {
 
-		// no more hash positions
-		if(topRow.empty()) break;
+		pop_heap(topRow.begin(), topRow.end(), SortHashPositionDesc());
 		HashPosition bestPosition = topRow.back();
 		topRow.pop_back();
 
-		if(sameHash.empty()) {
-
-			sameHash.push_back(bestPosition);
-
-		} else {
-
-			if(bestPosition.Hash == sameHash[0].Hash) {
-				sameHash.push_back(bestPosition);
-			} else {
-				numProcessed += sameHash.size();
-				StoreHash(sameHash);
-
-				sameHash.clear();
-				sameHash.push_back(bestPosition);
-			}
+		if(!sameHash.empty() && ((bestPosition.Hash >> mStrandBits) != (sameHash[0].Hash >> mStrandBits))) {
+			numProcessed += sameHash.size();
+			StoreHash(sameHash);
+			sameHash.clear();
 		}
 
+		sameHash.push_back(bestPosition);
+
 		// get the next hash position from the appropriate temp file
-		{
-			HashPosition hp;
-			hp.Owner = bestPosition.Owner;
-			if(hp.Deserialize(sortHandles[bestPosition.Owner])) topRow.push_back(hp);
+		HashPosition hp;
+		hp.Owner = bestPosition.Owner;
+		if(hp.Deserialize(sortHandles[bestPosition.Owner])) {
+			topRow.push_back(hp);
+			push_heap(topRow.begin(), topRow.end(), SortHashPositionDesc());
 		}
-
-		sort(topRow.begin(), topRow.end(), SortHashPositionDesc());
 	}
 
 	// store the last hash
 	numProcessed += sameHash.size();
 	StoreHash(sameHash);
 
-	// stop the progress bar
-	CProgressBar<unsigned int>::WaitThread();
-
-	// write the keys to file
-	if(mKeepKeysInMemory) {
-
-		uint64_t bytesLeft = mKeyBufferLen;
-
-		unsigned int fillBufferSize = 314572800 ; // 300 MB
-		unsigned int numBuffers = (unsigned int)(mKeyBufferLen / (double)fillBufferSize);
-		unsigned int currentBuffer = 0;
-		char* pKeys = (char*)mKeyBuffer;
-
-		CConsole::Heading(); 
-		cout << endl << "- serializing jump keys database (" << numBuffers << " blocks):" << endl;
-		CConsole::Reset(); 
-
-		bool isRunning = true;
-		CProgressCounter<unsigned int>::StartThread(&currentBuffer, &isRunning, "blocks");
-
-		for(; currentBuffer < numBuffers; currentBuffer++) {
-			fwrite(pKeys, fillBufferSize, 1, mKeys);
-			pKeys     += fillBufferSize;
-			bytesLeft -= fillBufferSize;
-		}
-
-		fwrite(pKeys, (size_t)bytesLeft, 1, mKeys);
-
-		// stop the progress counter
-		isRunning = false;
-		CProgressCounter<unsigned int>::WaitThread();
-	}
-
 	// close our files
 	for(unsigned int i = 0; i < numSortingFiles; i++) fclose(sortHandles[i]);
 
@@ -273,36 +300,29 @@ void CJumpCreator::BuildJumpDatabase(void) {
 	delete [] sortHandles;
 }
 
-// creates the hash for a supplied fragment
-void CJumpCreator::CreateHash(const char* fragment, const unsigned char fragmentLen, uint64_t& key) {
-
-	// set the key to zero
-	key = 0;
-	const char translation[26] = { 0, 3, 1, 3, -1, -1, 2, 3, -1, -1, 3, -1, 0, 3, -1, -1, -1, 0, 2, 3, -1, 0, 3, 1, 3, -1 };
+// stores the sorted hash positions in the jump database
+void CJumpCreator::StoreSortedHashPositions(unsigned int& numProcessed) {
 
-	if(fragmentLen > 32) {
-		cout << "ERROR: This hash table can only handle fragments smaller or equal to 32 bases." << endl;
-		exit(1);
-	}	
+	vector<HashPosition> sameHash;
+	vector<HashPosition>::const_iterator hpIter = mSortedHashPositions.begin();
 
-	// convert each nucleotide to its 2-bit representation
-	for(unsigned char i = 0; i < fragmentLen; i++) {
+	while(hpIter != mSortedHashPositions.end()) {
 
-		// convert [A,C,G,T] to [0,1,2,3]
-		char tValue = translation[fragment[i] - 'A'];
+		// collect all of the positions of this hash
+		vector<HashPosition>::const_iterator endIter = hpIter + 1;
+		while((endIter != mSortedHashPositions.end()) && ((endIter->Hash >> mStrandBits) == (hpIter->Hash >> mStrandBits))) ++endIter;
 
-		// catch any unrecognized nucleotides
-		if(tValue < 0) {
-			cout << "ERROR: Unrecognized nucleotide in hash table: " << fragment[i] << endl;
-			cout << "- fragment: ";
-			for(unsigned j = 0; j < fragmentLen; j++) cout << fragment[j];
-			cout << endl;
-			exit(1);
-		}
+		sameHash.assign(hpIter, endIter);
+		numProcessed += sameHash.size();
+		StoreHash(sameHash);
 
-		// shift the key and add the new value
-		key = key << 2 | tValue;
+		hpIter = endIter;
 	}
+
+	// an empty reference still produces an error
+	if(mSortedHashPositions.empty()) StoreHash(sameHash);
+
+	vector<HashPosition>().swap(mSortedHashPositions);
 }
 
 // enables hash position logging
@@ -338,15 +358,19 @@ void CJumpCreator::HashReference(const string& referenceFilename) {
 	cout << "finished." << endl << endl;
 	refseq.Close();
 
-	// -------------------------
-	// initialize sorting vector
-	// -------------------------
+	// ---------------------------------------------------
+	// split the sorting memory between the hashing threads
+	// ---------------------------------------------------
+
+	unsigned int maxPositions = referenceLength - mHashSize + 1;
 
 	double memoryAllocated = mSortingMemoryGB * 1073741824.0;
-	unsigned int maxSortingElements = (int)(memoryAllocated / (double)sizeof(HashPosition));
+	unsigned int maxSortingElements = (unsigned int)(memoryAllocated / (double)sizeof(HashPosition) / mNumThreads);
+	if(maxSortingElements == 0) maxSortingElements = 1;
 
-	vector<HashPosition> hashPositions;
-	hashPositions.reserve(maxSortingElements);
+	// skip the temporary files when every hash position and the radix sort buffer fit in the sorting memory
+	mSortInMemory = ((double)maxPositions * 2.0 * (double)sizeof(HashPosition) <= memoryAllocated);
+	if(mSortInMemory) mBlockHashPositions.resize((maxPositions + JUMP_HASHING_BLOCK_SIZE - 1) / JUMP_HASHING_BLOCK_SIZE);
 
 	// ----------------------------------------
 	// hash the concatenated reference sequence
@@ -356,74 +380,278 @@ void CJumpCreator::HashReference(const string& referenceFilename) {
 	cout << "- hashing reference sequence:" << endl;
 	CConsole::Reset(); 
 
-	char* pAnchor = pReference;
+	mNumHashPositions  = 0;
+	mNextBlockPosition = 0;
+
+	HashingThreadData td;
+	td.pCreator           = this;
+	td.pReference         = pReference;
+	td.NumPositions       = maxPositions;
+	td.MaxSortingElements = maxSortingElements;
+
+	CProgressBar<unsigned int>::StartThread(&mNextBlockPosition, 0, maxPositions, "hashes");
+
+	vector<pthread_t> threads(mNumThreads);
+	for(unsigned int i = 0; i < mNumThreads; i++) pthread_create(&threads[i], NULL, HashReferenceThread, (void*)&td);
+
+	void* status = NULL;
+	for(unsigned int i = 0; i < mNumThreads; i++) pthread_join(threads[i], &status);
+
+	mNextBlockPosition = maxPositions;
+	CProgressBar<unsigned int>::WaitThread();
+
+	if(mSortInMemory) {
+		cout << endl << "- sorting hash positions in memory... ";
+		cout.flush();
+		RadixSortHashPositions();
+		cout << "finished." << endl;
+	} else cout << endl << "- serialized " << mSerializedPositionsFilenames.size() << " sorted temporary files." << endl;
+
+	// clean up
+	delete [] pReference;
+}
+
+// hashes reference blocks until the whole reference has been hashed
+void CJumpCreator::HashReferenceBlocks(const char* pReference, const unsigned int numPositions, const unsigned int maxSortingElements) {
+
+	// convert [A,C,G,T] to [0,1,2,3]
+	const char translation[26] = { 0, 3, 1, 3, -1, -1, 2, 3, -1, -1, 3, -1, 0, 3, -1, -1, -1, 0, 2, 3, -1, 0, 3, 1, 3, -1 };
+	const uint64_t keyMask = (mHashSize >= 32 ? 0xffffffffffffffffULL : (1ULL << (mHashSize * 2)) - 1);
+	const unsigned char reverseShift = (mHashSize - 1) * 2;
+
+	vector<HashPosition> hashPositions;
+	if(!mSortInMemory) hashPositions.reserve(maxSortingElements);
+
+	while(true) {
+
+		// grab the next block of reference positions
+		pthread_mutex_lock(&mHashingMutex);
+		const unsigned int blockBegin = mNextBlockPosition;
+		const unsigned int blockEnd   = (numPositions - blockBegin > JUMP_HASHING_BLOCK_SIZE ? blockBegin + JUMP_HASHING_BLOCK_SIZE : numPositions);
+		mNextBlockPosition = blockEnd;
+		pthread_mutex_unlock(&mHashingMutex);
+
+		if(blockBegin >= blockEnd) break;
+
+		// when sorting in memory, every block keeps its own hash positions
+		vector<HashPosition>& blockHashPositions = (mSortInMemory ? mBlockHashPositions[blockBegin / JUMP_HASHING_BLOCK_SIZE] : hashPositions);
+		if(mSortInMemory) blockHashPositions.reserve(blockEnd - blockBegin);
+
+		// roll the key over the block: hashes containing J, X or N are skipped
+		uint64_t key = 0, reverseKey = 0;
+		unsigned int firstValidPosition  = blockBegin;
+		bool hasUnrecognized             = false;
+		unsigned int unrecognizedPosition = 0;
+
+		const unsigned int lastBase = blockEnd + mHashSize - 1;
+		for(unsigned int j = blockBegin; j < lastBase; j++) {
+
+			const char anchorChar = pReference[j];
+			char tValue = ((anchorChar >= 'A') && (anchorChar <= 'Z') ? translation[anchorChar - 'A'] : -1);
+
+			if((anchorChar == 'J') || (anchorChar == 'X') || (anchorChar == 'N')) firstValidPosition = j + 1;
+			else if(tValue < 0) {
+				hasUnrecognized      = true;
+				unrecognizedPosition = j;
+				tValue               = 0;
+			}
+
+			key        = ((key << 2) | tValue) & keyMask;
+			reverseKey = (reverseKey >> 2) | ((uint64_t)(3 - tValue) << reverseShift);
+
+			// wait until the first hash in the block is complete
+			if(j < blockBegin + mHashSize - 1) continue;
+
+			const unsigned int position = j + 1 - mHashSize;
+			if(position < firstValidPosition) continue;
+
+			// catch any unrecognized nucleotides
+			if(hasUnrecognized && (unrecognizedPosition >= position)) {
+				cout << "ERROR: Unrecognized nucleotide in hash table: " << pReference[unrecognizedPosition] << endl;
+				cout << "- fragment: ";
+				for(unsigned int k = 0; k < mHashSize; k++) cout << pReference[position + k];
+				cout << endl;
+				exit(1);
+			}
+
+			// canonical hashes store the strand in the lowest bit, so both strands of a key sort together
+			HashPosition hp;
+			hp.Hash     = key;
+			hp.Position = position;
+			if(mUseCanonicalKeys) hp.Hash = (key <= reverseKey ? (key << 1) : ((reverseKey << 1) | 1));
+			blockHashPositions.push_back(hp);
+
+			// dump our sorting vector
+			if(!mSortInMemory && (hashPositions.size() >= maxSortingElements)) SerializeSortingVector(hashPositions);
+		}
+	}
+
+	if(!hashPositions.empty()) SerializeSortingVector(hashPositions);
+}
+
+// sorts the hashed reference blocks by hash with a parallel LSD radix sort
+void CJumpCreator::RadixSortHashPositions(void) {
 
-	unsigned int maxPositions = referenceLength - mHashSize + 1;
-	unsigned int i = 0;
 	mNumHashPositions = 0;
+	for(unsigned int i = 0; i < (unsigned int)mBlockHashPositions.size(); i++) mNumHashPositions += mBlockHashPositions[i].size();
 
-	CProgressBar<unsigned int>::StartThread(&i, 0, maxPositions, "hashes");
+	if(mNumHashPositions == 0) {
+		vector<vector<HashPosition> >().swap(mBlockHashPositions);
+		return;
+	}
 
-	for(; i < maxPositions; i++, pAnchor++) {
+	// the blocks are in reference order, so a stable sort on the hash also orders the positions
+	const unsigned char keyBits   = mHashSize * 2 + mStrandBits;
+	const unsigned char numPasses = (keyBits + JUMP_RADIX_BITS - 1) / JUMP_RADIX_BITS;
+	const unsigned char digitBits = (keyBits + numPasses - 1) / numPasses;
+	const unsigned int numBuckets = 1 << digitBits;
+
+	// the first pass scatters straight out of the reference blocks, so only its destination is allocated
+	// before the blocks are freed: at most two copies of the hash positions exist at any time
+	vector<HashPosition> buffer;
+	const bool isFirstDestinationSorted = (numPasses % 2 == 1);
+	if(isFirstDestinationSorted) mSortedHashPositions.resize(mNumHashPositions);
+	else buffer.resize(mNumHashPositions);
+
+	vector<unsigned int> bucketOffsets(mNumThreads * numBuckets);
+	vector<RadixSortThreadData> threadData(mNumThreads);
+	vector<pthread_t> threads(mNumThreads);
+	vector<RadixSegment> segments;
+
+	for(unsigned char pass = 0; pass < numPasses; pass++) {
+
+		// the source is split into segments that the threads process in order
+		vector<HashPosition>& destination = ((numPasses - pass) % 2 == 1 ? mSortedHashPositions : buffer);
+		vector<HashPosition>& source      = (&destination == &buffer ? mSortedHashPositions : buffer);
+		HashPosition* pDestination  = &destination[0];
+		const HashPosition* pSource = (pass == 0 ? NULL : &source[0]);
+
+		segments.clear();
+
+		if(pass == 0) {
+			for(unsigned int i = 0; i < (unsigned int)mBlockHashPositions.size(); i++) {
+				if(mBlockHashPositions[i].empty()) continue;
+				RadixSegment rs;
+				rs.pBegin = &mBlockHashPositions[i][0];
+				rs.pEnd   = rs.pBegin + mBlockHashPositions[i].size();
+				segments.push_back(rs);
+			}
+		} else {
+			const unsigned int chunkSize = (mNumHashPositions + mNumThreads - 1) / mNumThreads;
+			for(unsigned int i = 0; i < mNumHashPositions; i += chunkSize) {
+				RadixSegment rs;
+				rs.pBegin = pSource + i;
+				rs.pEnd   = pSource + (mNumHashPositions - i > chunkSize ? i + chunkSize : mNumHashPositions);
+				segments.push_back(rs);
+			}
+		}
 
-		bool skipHash = false;
+		// assign consecutive segments to each thread
+		const unsigned int numSegments = (unsigned int)segments.size();
+		for(unsigned int t = 0; t < mNumThreads; t++) {
+			const unsigned int segmentBegin = (unsigned int)((uint64_t)numSegments * t / mNumThreads);
+			const unsigned int segmentEnd   = (unsigned int)((uint64_t)numSegments * (t + 1) / mNumThreads);
+
+			threadData[t].pSegments      = (numSegments > 0 ? &segments[0] + segmentBegin : NULL);
+			threadData[t].NumSegments    = segmentEnd - segmentBegin;
+			threadData[t].pDestination   = pDestination;
+			threadData[t].pBucketOffsets = &bucketOffsets[t * numBuckets];
+			threadData[t].Shift          = pass * digitBits;
+			threadData[t].DigitMask      = numBuckets - 1;
+			threadData[t].IsScattering   = false;
+		}
 
-		for(unsigned int j = 0; j < mHashSize; j++) {
-			char anchorChar = *(pAnchor + j);
-			if((anchorChar == 'J') || (anchorChar == 'X') || (anchorChar == 'N')) {
-				skipHash = true;
-				break;
+		// count the digits
+		void* status = NULL;
+		for(unsigned int t = 0; t < mNumThreads; t++) pthread_create(&threads[t], NULL, RadixSortThread, (void*)&threadData[t]);
+		for(unsigned int t = 0; t < mNumThreads; t++) pthread_join(threads[t], &status);
+
+		// convert the counts into offsets: bucket-major, thread-minor keeps the sort stable
+		unsigned int offset = 0;
+		for(unsigned int b = 0; b < numBuckets; b++) {
+			for(unsigned int t = 0; t < mNumThreads; t++) {
+				const unsigned int count = bucketOffsets[t * numBuckets + b];
+				bucketOffsets[t * numBuckets + b] = offset;
+				offset += count;
 			}
 		}
 
-		if(skipHash) continue;
+		// scatter the hash positions
+		for(unsigned int t = 0; t < mNumThreads; t++) {
+			threadData[t].IsScattering = true;
+			pthread_create(&threads[t], NULL, RadixSortThread, (void*)&threadData[t]);
+		}
+
+		for(unsigned int t = 0; t < mNumThreads; t++) pthread_join(threads[t], &status);
 
-		HashPosition hp;
-		hp.Position = i;
-		CreateHash(pAnchor, mHashSize, hp.Hash);
-		hashPositions.push_back(hp);
-
-		// dump our sorting vector
-		if(hashPositions.size() >= maxSortingElements) {
-			mNumHashPositions += hashPositions.size();
-			SerializeSortingVector(hashPositions);
+		// the reference blocks are no longer needed after the first pass
+		if(pass == 0) {
+			vector<vector<HashPosition> >().swap(mBlockHashPositions);
+			if(numPasses > 1) {
+				if(isFirstDestinationSorted) buffer.resize(mNumHashPositions);
+				else mSortedHashPositions.resize(mNumHashPositions);
+			}
 		}
 	}
+}
 
-	CProgressBar<unsigned int>::WaitThread();
+// counts (or scatters) the digits of the thread's segments
+void* CJumpCreator::RadixSortThread(void* arg) {
 
-	cout << endl << "- serializing final sorting vector... ";
-	cout.flush();
+	RadixSortThreadData* pTD = (RadixSortThreadData*)arg;
+	unsigned int* pOffsets   = pTD->pBucketOffsets;
+	const unsigned char shift = pTD->Shift;
+	const uint64_t digitMask  = pTD->DigitMask;
 
-	mNumHashPositions += hashPositions.size();
-	SerializeSortingVector(hashPositions);
+	if(!pTD->IsScattering) fill(pOffsets, pOffsets + digitMask + 1, 0);
 
-	cout << "finished." << endl;
+	for(unsigned int s = 0; s < pTD->NumSegments; s++) {
+		const HashPosition* pEnd = pTD->pSegments[s].pEnd;
 
-	// clean up
-	delete [] pReference;
+		if(pTD->IsScattering) {
+			for(const HashPosition* pHP = pTD->pSegments[s].pBegin; pHP != pEnd; ++pHP)
+				pTD->pDestination[pOffsets[(pHP->Hash >> shift) & digitMask]++] = *pHP;
+		} else {
+			for(const HashPosition* pHP = pTD->pSegments[s].pBegin; pHP != pEnd; ++pHP)
+				pOffsets[(pHP->Hash >> shift) & digitMask]++;
+		}
+	}
+
+	return 0;
+}
+
+// the hashing thread entry point
+void* CJumpCreator::HashReferenceThread(void* arg) {
+	HashingThreadData* pTD = (HashingThreadData*)arg;
+	pTD->pCreator->HashReferenceBlocks(pTD->pReference, pTD->NumPositions, pTD->MaxSortingElements);
+	return 0;
 }
 
 // serializes the sorting vector to temporary files
 void CJumpCreator::SerializeSortingVector(vector<HashPosition>& hashPositions) {
 
-	// retrieve a temporary filename
+	// sort the hash positions
+	sort(hashPositions.begin(), hashPositions.end(), SortHashPositionAsc());
+
+	// retrieve a temporary filename and open the temporary file
 	string tempFilename;
-	CFileUtilities::GetTempFilename(tempFilename);
+	FILE* temp = NULL;
 
-	mSerializedPositionsFilenames.push_back(tempFilename);
+	pthread_mutex_lock(&mHashingMutex);
 
-	// open the temporary file
-	FILE* temp = NULL;
+	CFileUtilities::GetTempFilename(tempFilename);
+	mSerializedPositionsFilenames.push_back(tempFilename);
 	fopen_s(&temp, tempFilename.c_str(), "wb");
+	mNumHashPositions += hashPositions.size();
+
+	pthread_mutex_unlock(&mHashingMutex);
 
 	if(!temp) {
 		cout << "ERROR: Unable to open temporary file (" << tempFilename << ") for writing." << endl;
 		exit(1);
 	}
 
-	// sort the hash positions
-	sort(hashPositions.begin(), hashPositions.end(), SortHashPositionAsc());
+	setvbuf(temp, NULL, _IOFBF, JUMP_SORT_BUFFER_SIZE);
 
 	// serialize
 	for(unsigned int i = 0; i < hashPositions.size(); i++) 
@@ -439,30 +667,36 @@ void CJumpCreator::SerializeSortingVector(vector<HashPosition>& hashPositions) {
 // stores the supplied hash positions in the jump database
 void CJumpCreator::StoreHash(vector<HashPosition>& hashPositions) {
 
-	unsigned int numHashes = hashPositions.size();
-
 	// store the hash positions
 	//if(mLogHashPositions) gzwrite(mHashPositionLog, (char*)&numHashes, SIZEOF_INT);
 
-	if(numHashes == 0) {
+	if(hashPositions.empty()) {
 		cout << "ERROR: Tried to store an empty hash." << endl;
 		exit(1);
 	}
 
-	// limit the number of hashes that will be written
-	if(mLimitPositions && (numHashes > mMaxHashPositions)) numHashes = mMaxHashPositions;
-
-	// shuffle the vector
-	std::shuffle(hashPositions.begin(), hashPositions.end(), std::default_random_engine{});
-
 	// localize the hash
-	uint64_t hash = hashPositions[0].Hash;
+	uint64_t hash = hashPositions[0].Hash >> mStrandBits;
+
+	// canonical keys count the positions of both strands
+	if(mUseKmerFilter && (hashPositions.size() > mKmerFilterThreshold)) mFrequentKeys.push_back(hash);
 
 	// write the position file offset in the keys file
-	off_type offset = hash * KEY_LENGTH;
-	off_type positionStart = ftell64(mPositions);
+	off_type offset = (mUseCanonicalRanks ? CJumpCanonicalKeys::GetRank(hash, mHashSize) : hash) * KEY_LENGTH;
+	off_type positionStart = mPositionsOffset;
 
-	if(mKeepKeysInMemory) {
+	if(mUseSparseKeys) {
+
+		// the hashes arrive in ascending order, so the records are already sorted
+		unsigned char record[SIZEOF_UINT64 + JUMP_SPARSE_OFFSET_LENGTH];
+		const uint64_t lowKey = hash & (((uint64_t)1 << mSparseLowBits) - 1);
+		CJumpSparseKeys::PackRecord(lowKey, mSparseLowBytes, positionStart, record);
+		fwrite((char*)record, CJumpSparseKeys::GetRecordLength(mSparseLowBytes), 1, mKeys);
+
+		mSparseDirectory[(hash >> mSparseLowBits) + 1]++;
+		mNumSparseKeys++;
+
+	} else if(mKeepKeysInMemory) {
 
 		unsigned int num64uint = (unsigned int)(offset / (double)SIZEOF_UINT64);
 		uint64_t* p64uint = &mKeyBuffer[num64uint];
@@ -472,24 +706,142 @@ void CJumpCreator::StoreHash(vector<HashPosition>& hashPositions) {
 
 		memcpy(pKeys + numBytes, (char*)&positionStart, KEY_LENGTH);
 
-	} else {
+	} else if(mUseCanonicalRanks) {
 
 		fseek64(mKeys, offset, SEEK_SET);
 		fwrite((char*)&positionStart, KEY_LENGTH, 1, mKeys);
+
+	} else {
+
+		// the hashes arrive in ascending order, so the keys file is written sequentially
+		WriteEmptyKeys(hash - mNextKey);
+		fwrite((char*)&positionStart, KEY_LENGTH, 1, mKeys);
+		mNextKey = hash + 1;
+	}
+
+	// canonical keys store the positions of the key followed by the positions of its reverse complement
+	vector<HashPosition>::iterator reverseIter = hashPositions.end();
+	if(mUseCanonicalKeys) {
+		reverseIter = hashPositions.begin();
+		while((reverseIter != hashPositions.end()) && ((reverseIter->Hash & 1) == 0)) ++reverseIter;
 	}
 
-	// write the hash positions
-	unsigned int entrySize = (numHashes + 1) * SIZEOF_INT;
+	JumpListHeader listHeader;
+	listHeader.NumReferencePositions[0] = (unsigned int)(reverseIter - hashPositions.begin());
+	listHeader.NumReferencePositions[1] = (unsigned int)(hashPositions.end() - reverseIter);
+
+	SelectPositions(hashPositions.begin(), reverseIter, mSortedPositions);
+	SelectPositions(reverseIter, hashPositions.end(), mSortedReversePositions);
+
+	listHeader.NumPositions[0] = (unsigned int)mSortedPositions.size();
+	listHeader.NumPositions[1] = (unsigned int)mSortedReversePositions.size();
+
+	// write the hash positions: the list header followed by the varint deltas of each strand
+	unsigned int entrySize = JUMP_MAX_LIST_HEADER_LENGTH + (listHeader.NumPositions[0] + listHeader.NumPositions[1]) * JUMP_MAX_VARINT_LENGTH;
 	CMemoryUtilities::CheckBufferSize(mBuffer, mBufferLen, entrySize);
 
-	unsigned int bufferOffset = 0;
-	memcpy(mBuffer + bufferOffset, (char*)&numHashes, SIZEOF_INT);
-	bufferOffset += SIZEOF_INT;
+	unsigned char* pDeltas = mBuffer + JUMP_MAX_LIST_HEADER_LENGTH;
+	listHeader.EncodedLength[0] = EncodeSubsampleTiers(mSortedPositions, pDeltas);
+	listHeader.EncodedLength[1] = EncodeSubsampleTiers(mSortedReversePositions, pDeltas + listHeader.EncodedLength[0]);
+	const unsigned int encodedLength = listHeader.EncodedLength[0] + listHeader.EncodedLength[1];
+
+	unsigned char header[JUMP_MAX_LIST_HEADER_LENGTH];
+	const unsigned int headerLength = CJumpPositionCodec::EncodeListHeader(listHeader, mUseCanonicalKeys, header);
+
+	unsigned char* pEntry = pDeltas - headerLength;
+	memcpy(pEntry, header, headerLength);
+
+	const unsigned int bufferOffset = headerLength + encodedLength;
+	fwrite(pEntry, bufferOffset, 1, mPositions);
+	mPositionsOffset += bufferOffset;
+}
+
+// encodes the subsample tiers of the selected hash positions and returns the number of bytes written
+unsigned int CJumpCreator::EncodeSubsampleTiers(const vector<unsigned int>& sortedPositions, unsigned char* pBuffer) {
+
+	const unsigned int numPositions = (unsigned int)sortedPositions.size();
+	unsigned int numBytes = 0;
+
+	// the deltas restart at every tier
+	for(unsigned int tierBegin = 0; tierBegin < numPositions;) {
+		const unsigned int tierEnd = CJumpPositionCodec::GetTierEnd(mSubsampleCaps, tierBegin, numPositions);
+		numBytes += CJumpPositionCodec::EncodePositions(&sortedPositions[tierBegin], tierEnd - tierBegin, pBuffer + numBytes);
+		tierBegin = tierEnd;
+	}
+
+	return numBytes;
+}
+
+// selects the hash positions that will be written (a shuffled subset when limiting) and sorts each subsample tier
+void CJumpCreator::SelectPositions(vector<HashPosition>::iterator begin, vector<HashPosition>::iterator end, vector<unsigned int>& sortedPositions) {
+
+	unsigned int numHashes = (unsigned int)(end - begin);
+
+	// limit the number of hashes that will be written
+	if(mLimitPositions && (numHashes > mMaxHashPositions)) numHashes = mMaxHashPositions;
+
+	// shuffle the vector
+	std::shuffle(begin, end, std::default_random_engine{});
+
+	// sort each subsample tier so that it can be delta encoded: the shuffled order decides which tier a position lands in
+	sortedPositions.resize(numHashes);
+	for(unsigned int i = 0; i < numHashes; i++) sortedPositions[i] = begin[i].Position;
+
+	for(unsigned int tierBegin = 0; tierBegin < numHashes;) {
+		const unsigned int tierEnd = CJumpPositionCodec::GetTierEnd(mSubsampleCaps, tierBegin, numHashes);
+		sort(sortedPositions.begin() + tierBegin, sortedPositions.begin() + tierEnd);
+		tierBegin = tierEnd;
+	}
+}
+
+// prepares the keys file for the sparse key records
+void CJumpCreator::StartSparseKeys(void) {
 
-	for(unsigned int i = 0; i < numHashes; i++) {
-		memcpy(mBuffer + bufferOffset, (char*)&hashPositions[i].Position, SIZEOF_INT);
-		bufferOffset += SIZEOF_INT;
+	// size the directory from the number of hash positions (an upper bound for the number of keys)
+	mSparseDirectoryBits = CJumpSparseKeys::GetDirectoryBits(mNumHashPositions, mHashSize);
+	mSparseLowBits       = mHashSize * 2 - mSparseDirectoryBits;
+	mSparseLowBytes      = (mSparseLowBits + 7) / 8;
+
+	try {
+		mSparseDirectory.assign(((size_t)1 << mSparseDirectoryBits) + 1, 0);
+	} catch(const bad_alloc&) {
+		cout << "ERROR: Unable to allocate enough memory for the sparse key directory." << endl;
+		exit(1);
 	}
 
-	fwrite(mBuffer, bufferOffset, 1, mPositions);
+	// the header and the directory are written once all of the records are known
+	fseek64(mKeys, CJumpSparseKeys::GetRecordsOffset(mSparseDirectoryBits), SEEK_SET);
+}
+
+// writes the sparse keys header and the bucket directory
+void CJumpCreator::FinishSparseKeys(void) {
+
+	// convert the bucket counts into bucket starts
+	for(size_t i = 1; i < mSparseDirectory.size(); i++) mSparseDirectory[i] += mSparseDirectory[i - 1];
+
+	JumpSparseKeysHeader header;
+	memset((char*)&header, 0, sizeof(JumpSparseKeysHeader));
+	memcpy(header.Signature, JUMP_SPARSE_KEYS_SIGNATURE, JUMP_SPARSE_KEYS_SIGNATURE_LEN);
+	header.NumKeys       = mNumSparseKeys;
+	header.DirectoryBits = mSparseDirectoryBits;
+	header.LowBytes      = mSparseLowBytes;
+
+	fseek64(mKeys, 0, SEEK_SET);
+	fwrite((char*)&header, sizeof(JumpSparseKeysHeader), 1, mKeys);
+	fwrite((char*)&mSparseDirectory[0], SIZEOF_INT, mSparseDirectory.size(), mKeys);
+
+	cout << "- stored " << mNumSparseKeys << " keys in the sparse key directory (" << (1ULL << mSparseDirectoryBits) << " buckets)." << endl;
+}
+
+// writes empty key entries for keys missing from the reference (keys on disk only)
+void CJumpCreator::WriteEmptyKeys(uint64_t numKeys) {
+
+	const unsigned int FILL_BUFFER_KEYS = 65536;
+	static const vector<char> fillBuffer(FILL_BUFFER_KEYS * KEY_LENGTH, (char)0xff);
+
+	while(numKeys > 0) {
+		const unsigned int numBufferKeys = (numKeys > FILL_BUFFER_KEYS ? FILL_BUFFER_KEYS : (unsigned int)numKeys);
+		fwrite(&fillBuffer[0], numBufferKeys * KEY_LENGTH, 1, mKeys);
+		numKeys -= numBufferKeys;
+	}
 }
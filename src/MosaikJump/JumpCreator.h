@@ -16,7 +16,12 @@
 #include <algorithm>
 #include "ConsoleUtilities.h"
 #include "FileUtilities.h"
+#include "JumpCanonicalKeys.h"
+#include "JumpKmerFilter.h"
+#include "JumpPositionCodec.h"
+#include "JumpSparseKeys.h"
 #include "MemoryUtilities.h"
+#include "PosixThreads.h"
 #include "ProgressBar.h"
 #include "ProgressCounter.h"
 #include "ReferenceSequenceReader.h"
@@ -25,14 +30,26 @@ using namespace std;
 
 #define KEY_LENGTH 5
 
+// the number of reference positions hashed by a thread at a time
+#define JUMP_HASHING_BLOCK_SIZE 1048576
+
+// the stream buffer sizes for the jump database and the temporary sorting files
+#define JUMP_OUTPUT_BUFFER_SIZE 8388608
+#define JUMP_SORT_BUFFER_SIZE   1048576
+
+// the maximum number of hash bits sorted per radix sort pass
+#define JUMP_RADIX_BITS 11
+
 class CJumpCreator {
 public:
 	// constructor
-	CJumpCreator(const unsigned char hashSize, const string& filenameStub, const unsigned char sortingMemoryGB, const bool keepKeysInMemory, const unsigned int hashPositionThreshold);
+	CJumpCreator(const unsigned char hashSize, const string& filenameStub, const unsigned char sortingMemoryGB, const bool keepKeysInMemory, const unsigned int hashPositionThreshold, const unsigned char numThreads, const bool useSparseKeys, const bool useCanonicalKeys, const vector<unsigned int>& subsampleCaps);
 	// destructor
 	~CJumpCreator(void);
 	// builds the jump database
 	void BuildJumpDatabase(void);
+	// stores a filter of the k-mers with more than the specified number of hash positions
+	void EnableKmerFilter(const unsigned int positionThreshold);
 	// enables hash position logging
 	//void EnableHashPositionsLogging(const string& filename);
 	// hashes the reference and stores the results in sorted temporary files
@@ -43,7 +60,7 @@ private:
 	struct HashPosition {
 		uint64_t Hash;
 		unsigned int Position;
-		unsigned char Owner;
+		unsigned int Owner;
 
 		// deserialize this object from the supplied file stream
 		bool Deserialize(FILE* temp) {
@@ -74,12 +91,56 @@ private:
 			return hp2.Hash < hp1.Hash;
 		}
 	};
-	// creates the hash for a supplied fragment
-	static void CreateHash(const char* fragment, const unsigned char fragmentLen, uint64_t& key);
+	// stores the data used by a hashing thread
+	struct HashingThreadData {
+		CJumpCreator* pCreator;
+		const char* pReference;
+		unsigned int NumPositions;
+		unsigned int MaxSortingElements;
+	};
+	// hashes reference blocks until the whole reference has been hashed
+	void HashReferenceBlocks(const char* pReference, const unsigned int numPositions, const unsigned int maxSortingElements);
+	// the hashing thread entry point
+	static void* HashReferenceThread(void* arg);
+	// points to a sorted run of hash positions in a radix sort pass
+	struct RadixSegment {
+		const HashPosition* pBegin;
+		const HashPosition* pEnd;
+	};
+	// stores the data used by a radix sort thread
+	struct RadixSortThreadData {
+		const RadixSegment* pSegments;
+		unsigned int NumSegments;
+		HashPosition* pDestination;
+		unsigned int* pBucketOffsets;
+		unsigned char Shift;
+		uint64_t DigitMask;
+		bool IsScattering;
+	};
+	// sorts the hashed reference blocks by hash with a parallel LSD radix sort
+	void RadixSortHashPositions(void);
+	// counts (or scatters) the digits of the thread's segments
+	static void* RadixSortThread(void* arg);
+	// stores the sorted hash positions in the jump database
+	void StoreSortedHashPositions(unsigned int& numProcessed);
+	// merges the sorted temporary files and stores the hash positions in the jump database
+	void MergeSortingFiles(unsigned int& numProcessed);
 	// serializes the sorting vector to temporary files
 	void SerializeSortingVector(vector<HashPosition>& hashPositions);
 	// stores the supplied hash positions in the jump database
 	void StoreHash(vector<HashPosition>& hashPositions);
+	// encodes the subsample tiers of the selected hash positions and returns the number of bytes written
+	unsigned int EncodeSubsampleTiers(const vector<unsigned int>& sortedPositions, unsigned char* pBuffer);
+	// selects the hash positions that will be written (a shuffled subset when limiting) and sorts each subsample tier
+	void SelectPositions(vector<HashPosition>::iterator begin, vector<HashPosition>::iterator end, vector<unsigned int>& sortedPositions);
+	// writes the filter of the over-represented k-mers
+	void WriteKmerFilter(void);
+	// writes empty key entries for keys missing from the reference (keys on disk only)
+	void WriteEmptyKeys(uint64_t numKeys);
+	// prepares the keys file for the sparse key records
+	void StartSparseKeys(void);
+	// writes the sparse keys header and the bucket directory
+	void FinishSparseKeys(void);
 	// stores the all of the serialized filenames used
 	vector<string> mSerializedPositionsFilenames;
 	// our hash size
@@ -90,6 +151,10 @@ private:
 	FILE* mKeys;
 	FILE* mPositions;
 	//gzFile mHashPositionLog;
+	// stores the sorted positions of the current hash
+	vector<unsigned int> mSortedPositions;
+	// stores the sorted positions of the reverse complement of the current hash (canonical keys only)
+	vector<unsigned int> mSortedReversePositions;
 	// our output buffer
 	unsigned char* mBuffer;
 	// the output buffer size
@@ -108,4 +173,46 @@ private:
 	uint64_t* mKeyBuffer;
 	// the key buffer size
 	uint64_t mKeyBufferLen;
+	// the number of hashing threads
+	unsigned char mNumThreads;
+	// the first reference position of the next hashing block
+	unsigned int mNextBlockPosition;
+	// protects the hashing block counter, the temporary files and the hash position count
+	pthread_mutex_t mHashingMutex;
+	// toggles whether all hash positions are sorted in memory instead of in temporary files
+	bool mSortInMemory;
+	// the hash positions of each reference block (in-memory sorting only)
+	vector<vector<HashPosition> > mBlockHashPositions;
+	// all of the hash positions sorted by hash and position (in-memory sorting only)
+	vector<HashPosition> mSortedHashPositions;
+	// the current size of the positions file
+	off_type mPositionsOffset;
+	// the next key to be written to the keys file (keys on disk only)
+	uint64_t mNextKey;
+	// toggles if the keys are stored in a sparse key directory
+	bool mUseSparseKeys;
+	// the sparse key directory layout
+	unsigned char mSparseDirectoryBits;
+	unsigned char mSparseLowBits;
+	unsigned char mSparseLowBytes;
+	// the number of keys in each sparse directory bucket (the bucket starts once finished)
+	vector<unsigned int> mSparseDirectory;
+	// the number of keys stored in the sparse key directory
+	uint64_t mNumSparseKeys;
+	// toggles if the keys are canonical (the lower of the k-mer and its reverse complement)
+	bool mUseCanonicalKeys;
+	// the number of strand bits below the key in each hash (canonical keys only)
+	unsigned char mStrandBits;
+	// toggles if the dense key directory is indexed by canonical rank (one slot per key and reverse complement)
+	bool mUseCanonicalRanks;
+	// the ascending hash position caps that split each position list into deterministic subsample tiers
+	vector<unsigned int> mSubsampleCaps;
+	// toggles if a filter of the over-represented k-mers should be stored
+	bool mUseKmerFilter;
+	// the k-mers with more than this number of hash positions are stored in the filter
+	unsigned int mKmerFilterThreshold;
+	// the over-represented k-mers (written once the number of k-mers is known)
+	vector<uint64_t> mFrequentKeys;
+	// the k-mer filter filename
+	string mKmerFilterFilename;
 };
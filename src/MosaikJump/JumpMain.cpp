@@ -24,19 +24,31 @@ using namespace std;
 #define MIN_HASH_SIZE     4
 #define MAX_HASH_SIZE     32
 
+// larger hash sizes store the keys in a sparse key directory
+#define MAX_DENSE_KEYS_HASH_SIZE 16
+
+// canonical keys need one spare bit for the strand
+#define MAX_CANONICAL_HASH_SIZE 31
+
 unsigned char DEFAULT_SORTING_MEMORY = 2;
+unsigned int DEFAULT_NUM_THREADS      = 1;
 
 // create a configuration variable struct
 struct ConfigurationSettings {
 
 	// flags
 	bool HasJumpFilenameStub;
+	bool HasKmerFilterThreshold;
 	bool HasHashPositionsFilename;
 	bool HasHashSize;
+	bool HasNumThreads;
 	bool HasReferenceFilename;
 	bool HasSortingMemory;
+	bool HasSubsampleCaps;
 	bool KeepKeysOnDisk;
 	bool LimitHashPositions;
+	bool UseCanonicalKeys;
+	bool UseSparseKeys;
 
 	// filenames
 	string ReferenceFilename;
@@ -44,19 +56,28 @@ struct ConfigurationSettings {
 	string HashPositionsFilename;
 
 	// parameters
+	string SubsampleCaps;
 	unsigned int HashPositionThreshold;
 	unsigned int HashSize;
+	unsigned int KmerFilterThreshold;
+	unsigned int NumThreads;
 	unsigned char SortingMemory;
 
 	// constructor
 	ConfigurationSettings()
 		: HasJumpFilenameStub(false)
+		, HasKmerFilterThreshold(false)
 		, HasHashPositionsFilename(false)
 		, HasHashSize(false)
+		, HasNumThreads(false)
 		, HasReferenceFilename(false)
 		, HasSortingMemory(false)
+		, HasSubsampleCaps(false)
 		, KeepKeysOnDisk(false)
 		, LimitHashPositions(false)
+		, UseCanonicalKeys(false)
+		, UseSparseKeys(false)
+		, NumThreads(DEFAULT_NUM_THREADS)
 		, SortingMemory(DEFAULT_SORTING_MEMORY)
 	{}
 };
@@ -90,10 +111,15 @@ int main(int argc, char* argv[]) {
 
 	// add the options
 	OptionGroup* pOpts = COptions::CreateOptionGroup("Options");
+	COptions::AddOption("-ck",                         "stores canonical keys: both strands in one key slot",         settings.UseCanonicalKeys,                                 pOpts);
 	COptions::AddOption("-kd",                         "keeps the keys database on disk",                             settings.KeepKeysOnDisk,                                   pOpts);
+	COptions::AddOption("-sk",                         "stores the keys in a sparse key directory",                   settings.UseSparseKeys,                                    pOpts);
 	COptions::AddValueOption("-mem", "GB",             "the amount memory used when sorting hashes", "",              settings.HasSortingMemory,   settings.SortingMemory,         pOpts, DEFAULT_SORTING_MEMORY);
 	COptions::AddValueOption("-hs",  "hash size",      "the hash size [4 - 32]",                     "The hash size", settings.HasHashSize,        settings.HashSize,              pOpts);
+	COptions::AddValueOption("-hf",  "hash positions", "stores a filter of k-mers with more positions. With -jhf the aligner drops every seed of these k-mers", "",           settings.HasKmerFilterThreshold, settings.KmerFilterThreshold, pOpts);
 	COptions::AddValueOption("-mhp", "hash positions", "sets the max number of hash positions",      "",              settings.LimitHashPositions, settings.HashPositionThreshold, pOpts);
+	COptions::AddValueOption("-p",   "processors",     "the number of hashing & sorting threads",    "",              settings.HasNumThreads,      settings.NumThreads,            pOpts, DEFAULT_NUM_THREADS);
+	COptions::AddValueOption("-sc",  "caps",           "stores subsamples for these aligner -mhp values, e.g. 1,9,100. The aligner reads each subsample in reference order instead of a shuffled order, so repetitive reads may align differently", "", settings.HasSubsampleCaps, settings.SubsampleCaps,    pOpts);
 
 	// parse the current command line
 	COptions::Parse(argc, argv);
@@ -112,18 +138,59 @@ int main(int argc, char* argv[]) {
 		foundError = true;
 	}
 
+	// check the number of threads
+	if(settings.HasNumThreads && ((settings.NumThreads < 1) || (settings.NumThreads > 255))) {
+		errorBuilder << ERROR_SPACER << "The number of processors should be between 1 and 255. Please revise with the -p parameter." << endl;
+		foundError = true;
+	}
+
 	// check the hash position threshold
 	if(settings.LimitHashPositions && (settings.HashPositionThreshold < 1)) {
 		errorBuilder << ERROR_SPACER << "The hash position threshold should be larger than 0." << endl;
 		foundError = true;
 	}
 
+	// check the k-mer filter threshold
+	if(settings.HasKmerFilterThreshold && (settings.KmerFilterThreshold < 1)) {
+		errorBuilder << ERROR_SPACER << "The k-mer filter threshold should be larger than 0. Please revise with the -hf parameter." << endl;
+		foundError = true;
+	}
+
+	// check the subsample caps
+	vector<unsigned int> subsampleCaps;
+	if(settings.HasSubsampleCaps) {
+
+		istringstream capStream(settings.SubsampleCaps);
+		string cap;
+		bool isValid = true;
+
+		while(getline(capStream, cap, ',')) {
+			const unsigned int value = (unsigned int)strtoul(cap.c_str(), NULL, 10);
+			if(value == 0) isValid = false;
+			else subsampleCaps.push_back(value);
+		}
+
+		sort(subsampleCaps.begin(), subsampleCaps.end());
+		subsampleCaps.erase(unique(subsampleCaps.begin(), subsampleCaps.end()), subsampleCaps.end());
+
+		if(!isValid || subsampleCaps.empty() || (subsampleCaps.size() > JUMP_MAX_SUBSAMPLE_CAPS)) {
+			errorBuilder << ERROR_SPACER << "The subsample caps should be a comma-separated list of up to " << JUMP_MAX_SUBSAMPLE_CAPS << " positive numbers. Please revise with the -sc parameter." << endl;
+			foundError = true;
+		}
+	}
+
 	// check the hash size
 	if(settings.HasHashSize && ((settings.HashSize < MIN_HASH_SIZE) || (settings.HashSize > MAX_HASH_SIZE))) {
 		errorBuilder << ERROR_SPACER << "Hash size should be between " << MIN_HASH_SIZE << " and " << MAX_HASH_SIZE << ". Please revise with the -hs parameter." << endl;
 		foundError = true;
 	}
 
+	// check the canonical key hash size
+	if(settings.UseCanonicalKeys && settings.HasHashSize && (settings.HashSize > MAX_CANONICAL_HASH_SIZE)) {
+		errorBuilder << ERROR_SPACER << "Canonical keys support hash sizes up to " << MAX_CANONICAL_HASH_SIZE << ". Please revise with the -hs parameter." << endl;
+		foundError = true;
+	}
+
 	// print the errors if any were found
 	if(foundError) {
 
@@ -144,11 +211,24 @@ int main(int argc, char* argv[]) {
 	if(settings.HasReferenceFilename)
 		MosaikReadFormat::CReferenceSequenceReader::CheckFile(settings.ReferenceFilename, true);
 
+	// the dense keys database needs 5 bytes for every possible key
+	if(!settings.UseSparseKeys && (settings.HashSize > MAX_DENSE_KEYS_HASH_SIZE)) {
+		cout << "- hash sizes above " << MAX_DENSE_KEYS_HASH_SIZE << " use a sparse key directory" << endl;
+		settings.UseSparseKeys = true;
+	}
+
+	if(!subsampleCaps.empty()) {
+		cout << "- storing deterministic subsamples for " << subsampleCaps.size() << " hash position caps (" << settings.SubsampleCaps << ")" << endl;
+	}
+
 	// start benchmarking
 	CBenchmark bench;
 	bench.Start();
 
-	CJumpCreator jc(settings.HashSize, settings.JumpFilenameStub, settings.SortingMemory, !settings.KeepKeysOnDisk, settings.HashPositionThreshold);
+	CJumpCreator jc(settings.HashSize, settings.JumpFilenameStub, settings.SortingMemory, !settings.KeepKeysOnDisk, settings.HashPositionThreshold, (unsigned char)settings.NumThreads, settings.UseSparseKeys, settings.UseCanonicalKeys, subsampleCaps);
+
+	// store a filter of the over-represented k-mers
+	if(settings.HasKmerFilterThreshold) jc.EnableKmerFilter(settings.KmerFilterThreshold);
 
 	// hash the reference and store the results in sorted temporary files
 	jc.HashReference(settings.ReferenceFilename);
@@ -68,6 +68,11 @@ void CPairedEndSort::EnableFullFragmentLengthSampling(void) {
 	mFlags.SampleAllFragmentLengths = true;
 }
 
+// compresses the output partitions in the specified number of threads
+void CPairedEndSort::EnableParallelCompression(const unsigned int numThreads) {
+	mSettings.NumCompressionThreads = numThreads;
+}
+
 // retrieves a read from the specified temporary file
 bool CPairedEndSort::GetAlignment(FILE* tempFile, const unsigned int owner, Alignment& al) {
 
@@ -836,6 +841,7 @@ void CPairedEndSort::ResolvePairedEndReads(const string& inputFilename, const st
 
 	// open our output file
 	MosaikReadFormat::CAlignmentWriter aw;
+	aw.EnableParallelCompression(mSettings.NumCompressionThreads);
 	aw.Open(outputFilename, *pReferenceSequences, readGroups, as);
 
 	// allocate the file stream array
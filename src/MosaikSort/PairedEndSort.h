@@ -90,6 +90,8 @@ public:
 	void EnableDuplicateFiltering(const string& duplicateDirectory);
 	// enables the sampling of all read pairs
 	void EnableFullFragmentLengthSampling(void);
+	// compresses the output partitions in the specified number of threads
+	void EnableParallelCompression(const unsigned int numThreads);
 	// resolves the paired-end reads found in the specified input file
 	void ResolvePairedEndReads(const string& inputFilename, const string& outputFilename);
 	// sets the desired confidence interval
@@ -104,10 +106,12 @@ private:
 		string UnresolvedFilename;
 		double ConfidenceInterval;
 		unsigned int NumCachedReads;
+		unsigned int NumCompressionThreads;
 
 		SortSettings() 
 			: ConfidenceInterval(DEFAULT_CONFIDENCE_INTERVAL)
 			, NumCachedReads(0)
+			, NumCompressionThreads(1)
 		{}
 	} mSettings;
 	// define our boolean flags structure
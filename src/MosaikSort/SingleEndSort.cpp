@@ -18,6 +18,7 @@ CSingleEndSort::CSingleEndSort(const unsigned int numCachedAlignments)
 , mSortNonUniqueMates(false)
 , mRemoveDuplicates(false)
 , mRenameReads(false)
+, mNumCompressionThreads(1)
 {
 }
 
@@ -46,6 +47,11 @@ void CSingleEndSort::EnableNonUniqueMode(void) {
 	mSortNonUniqueMates = true;
 }
 
+// compresses the output partitions in the specified number of threads
+void CSingleEndSort::EnableParallelCompression(const unsigned int numThreads) {
+	mNumCompressionThreads = numThreads;
+}
+
 // retrieves an alignment from the specified temporary file
 bool CSingleEndSort::GetAlignment(FILE* tempFile, const unsigned int owner, Alignment& al) {
 
@@ -439,6 +445,7 @@ void CSingleEndSort::SaveAlignmentsOrderedByPosition(const string& inputFilename
 
 	// open our output file
 	MosaikReadFormat::CAlignmentWriter aw;
+	aw.EnableParallelCompression(mNumCompressionThreads);
 	aw.Open(outputFilename, *pReferenceSequences, readGroups, AS_SORTED_ALIGNMENT);
 
 	// allocate the file stream array
@@ -47,6 +47,8 @@ public:
 	void EnableDuplicateFiltering(const string& duplicateDirectory);
 	// processes multiply aligned reads
 	void EnableNonUniqueMode(void);
+	// compresses the output partitions in the specified number of threads
+	void EnableParallelCompression(const unsigned int numThreads);
 	// sorts the input alignments and saves them to the output file
 	void SaveAlignmentsOrderedByPosition(const string& inputFilename, const string& outputFilename);
 private:
@@ -77,4 +79,6 @@ private:
 	string mDuplicateDirectory;
 	// toggles if we want to append the alignment count to the read name
 	bool mRenameReads;
+	// the number of threads used to compress the output partitions
+	unsigned int mNumCompressionThreads;
 };
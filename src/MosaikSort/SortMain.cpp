@@ -34,6 +34,7 @@ struct ConfigurationSettings {
 	bool HasConfidenceInterval;
 	bool HasDuplicateDirectory;
 	bool HasInputMosaikAlignmentFilename;
+	bool HasNumCompressionThreads;
 	bool HasOutputMosaikAlignmentFilename;
 	bool IgnoreUM;
 	bool IgnoreUU;
@@ -52,6 +53,7 @@ struct ConfigurationSettings {
 	// parameters
 	double ConfidenceInterval;
 	unsigned int CacheSize;
+	unsigned int NumCompressionThreads;
 
 	// constructor
 	ConfigurationSettings()
@@ -61,6 +63,7 @@ struct ConfigurationSettings {
 		, HasConfidenceInterval(false)
 		, HasDuplicateDirectory(false)
 		, HasInputMosaikAlignmentFilename(false)
+		, HasNumCompressionThreads(false)
 		, HasOutputMosaikAlignmentFilename(false)
 		, IgnoreUM(false)
 		, IgnoreUU(false)
@@ -71,6 +74,7 @@ struct ConfigurationSettings {
 		, UseNonUniqueReads(false)
 		, ConfidenceInterval(DEFAULT_CONFIDENCE_INTERVAL)
 		, CacheSize(DEFAULT_CACHE_SIZE)
+		, NumCompressionThreads(1)
 	{}
 };
 
@@ -96,6 +100,7 @@ int main(int argc, char* argv[]) {
 	// add the input/output options
 	OptionGroup* pIOOpts = COptions::CreateOptionGroup("Input & Output");
 	COptions::AddOption("-consed",                                "appends a number to read names for consed compatibility",                   settings.UseConsedRenaming,                                                        pIOOpts);
+	COptions::AddValueOption("-ct",  "# of threads",              "compresses the output partitions in # threads",                         "", settings.HasNumCompressionThreads,         settings.NumCompressionThreads,         pIOOpts);
 	COptions::AddValueOption("-dup", "directory",                 "enables duplicate filtering with databases in the specified directory", "", settings.HasDuplicateDirectory,            settings.DuplicateDirectory,            pIOOpts);
 	COptions::AddValueOption("-in",  "MOSAIK alignment filename", "the input MOSAIK alignment file",  "An input MOSAIK alignment filename",    settings.HasInputMosaikAlignmentFilename,  settings.InputMosaikAlignmentFilename,  pIOOpts);
 	COptions::AddValueOption("-out", "MOSAIK alignment filename", "the output MOSAIK alignment file", "An output MOSAIK alignment filename",   settings.HasOutputMosaikAlignmentFilename, settings.OutputMosaikAlignmentFilename, pIOOpts);
@@ -136,6 +141,12 @@ int main(int argc, char* argv[]) {
 		foundError = true;
 	}
 
+	// check the number of compression threads
+	if(settings.HasNumCompressionThreads && (settings.NumCompressionThreads < 1)) {
+		errorBuilder << ERROR_SPACER << "The number of compression threads should be at least 1." << endl;
+		foundError = true;
+	}
+
 	// print the errors if any were found
 	if(foundError) {
 
@@ -224,6 +235,12 @@ int main(int argc, char* argv[]) {
 			pes.DisableFragmentAlignmentQuality();
 		}
 
+		// enable parallel partition compression
+		if(settings.HasNumCompressionThreads) {
+			printf("- compressing the output partitions in %u threads\n", settings.NumCompressionThreads);
+			pes.EnableParallelCompression(settings.NumCompressionThreads);
+		}
+
 		// resolve the paired-end reads
 		pes.ResolvePairedEndReads(settings.InputMosaikAlignmentFilename, settings.OutputMosaikAlignmentFilename);
 
@@ -256,6 +273,12 @@ int main(int argc, char* argv[]) {
 			ses.EnableConsedRenaming();
 		}
 
+		// enable parallel partition compression
+		if(settings.HasNumCompressionThreads) {
+			printf("- compressing the output partitions in %u threads\n", settings.NumCompressionThreads);
+			ses.EnableParallelCompression(settings.NumCompressionThreads);
+		}
+
 		ses.SaveAlignmentsOrderedByPosition(settings.InputMosaikAlignmentFilename, settings.OutputMosaikAlignmentFilename);
 	}
 